@@ -1,9 +1,15 @@
 #include <RcppArmadillo.h>
 #include <cmath>
+#include <chrono>
 #include "BranchGLMHelpers.h"
 #include "ParBranchGLMHelpers.h"
+#include "CrossProducts.h"
 #include "BranchGLMHelpers.h"
 #include "VariableSelection.h"
+#include "Checkpoint.h"
+#include "SharedBound.h"
+#include "MappedMatrix.h"
+#include "ThreadPolicy.h"
 #ifdef _OPENMP
 # include <omp.h>
 #endif
@@ -15,76 +21,156 @@ void UpdateBestMetrics(arma::mat* BestModels,
                        arma::vec* Metrics, 
                        double cutoff){
   
-  // Only getting first k metrics
-  if(cutoff < 0 && any(*Metrics < BestMetrics->at(BestMetrics->n_elem - 1))){
+  // The best models are shared by all threads searching the tree
+#pragma omp critical(BestMetrics)
+  {
+    // Only getting first k metrics
+    if(cutoff < 0 && any(*Metrics < BestMetrics->at(BestMetrics->n_elem - 1))){
     
-    // Defining vector to order metrics
-    arma::vec tempMetrics(BestMetrics->n_elem + Metrics->n_elem);
-    tempMetrics.subvec(0, BestMetrics->n_elem - 1) = *BestMetrics;
-    tempMetrics.subvec(BestMetrics->n_elem, tempMetrics.n_elem - 1) = *Metrics;
+      // Defining vector to order metrics
+      arma::vec tempMetrics(BestMetrics->n_elem + Metrics->n_elem);
+      tempMetrics.subvec(0, BestMetrics->n_elem - 1) = *BestMetrics;
+      tempMetrics.subvec(BestMetrics->n_elem, tempMetrics.n_elem - 1) = *Metrics;
     
-    // Sorting by metric values
-    arma::uvec sorted = sort_index(tempMetrics);
+      // Sorting by metric values
+      arma::uvec sorted = sort_index(tempMetrics);
     
-    // Defining matrix to store all models
-    arma::mat NewModels(Models->n_rows, BestModels->n_cols + Models->n_cols);
-    NewModels.cols(0, BestModels->n_cols - 1) = *BestModels;
-    NewModels.cols(BestModels->n_cols, NewModels.n_cols - 1) = *Models;
-    tempMetrics = tempMetrics(sorted);
-    NewModels = NewModels.cols(sorted);
+      // Defining matrix to store all models
+      arma::mat NewModels(Models->n_rows, BestModels->n_cols + Models->n_cols);
+      NewModels.cols(0, BestModels->n_cols - 1) = *BestModels;
+      NewModels.cols(BestModels->n_cols, NewModels.n_cols - 1) = *Models;
+      tempMetrics = tempMetrics(sorted);
+      NewModels = NewModels.cols(sorted);
     
-   *BestModels = NewModels.cols(0, BestModels->n_cols - 1);
-   *BestMetrics = tempMetrics.subvec(0, BestMetrics->n_elem - 1);
-  }
-  else if(any(*Metrics < BestMetrics->at(0) + cutoff)){
+     *BestModels = NewModels.cols(0, BestModels->n_cols - 1);
+     *BestMetrics = tempMetrics.subvec(0, BestMetrics->n_elem - 1);
+    }
+    else if(any(*Metrics < BestMetrics->at(0) + cutoff)){
     
-    // Only keeping models with metric values within cutoff of the best metric
-    double minMetric = std::min(min(*BestMetrics), min(*Metrics));
-    arma::uvec indOld = find(*BestMetrics <= minMetric + cutoff);
-    arma::uvec indNew = find(*Metrics <= minMetric + cutoff);
+      // Only keeping models with metric values within cutoff of the best metric
+      double minMetric = std::min(min(*BestMetrics), min(*Metrics));
+      arma::uvec indOld = find(*BestMetrics <= minMetric + cutoff);
+      arma::uvec indNew = find(*Metrics <= minMetric + cutoff);
       
-    // Defining matrix to store all models
-    arma::mat NewModels(Models->n_rows, indOld.n_elem + indNew.n_elem);
-    arma::vec NewMetrics(indOld.n_elem + indNew.n_elem);
+      // Defining matrix to store all models
+      arma::mat NewModels(Models->n_rows, indOld.n_elem + indNew.n_elem);
+      arma::vec NewMetrics(indOld.n_elem + indNew.n_elem);
     
-    // Getting new metrics to sort models
-    if(indOld.n_elem > 0){
-      NewMetrics.subvec(0, indOld.n_elem - 1) = BestMetrics->elem(indOld);
-    }
-    NewMetrics.subvec(indOld.n_elem, NewMetrics.n_elem - 1) = Metrics->elem(indNew);
-    arma::uvec sorted = sort_index(NewMetrics);
+      // Getting new metrics to sort models
+      if(indOld.n_elem > 0){
+        NewMetrics.subvec(0, indOld.n_elem - 1) = BestMetrics->elem(indOld);
+      }
+      NewMetrics.subvec(indOld.n_elem, NewMetrics.n_elem - 1) = Metrics->elem(indNew);
+      arma::uvec sorted = sort_index(NewMetrics);
     
-    // Placing models in correct place
-    if(indOld.n_elem > 0){
-      NewModels.cols(0, indOld.n_elem - 1) = BestModels->cols(indOld);
+      // Placing models in correct place
+      if(indOld.n_elem > 0){
+        NewModels.cols(0, indOld.n_elem - 1) = BestModels->cols(indOld);
+      }
+      NewModels.cols(indOld.n_elem, NewModels.n_cols - 1) = Models->cols(indNew);
+      *BestModels = NewModels.cols(sorted);
+      *BestMetrics = NewMetrics.elem(sorted);
     }
-    NewModels.cols(indOld.n_elem, NewModels.n_cols - 1) = Models->cols(indNew);
-    *BestModels = NewModels.cols(sorted);
-    *BestMetrics = NewMetrics.elem(sorted);
   }
 }
 
+// Models are stored as their coefficients followed by the 0/1 indicators of the 
+// variables in them, so a variable isn't dropped when its coefficient is 0
+void SetIndicators(arma::mat* Models, const arma::ivec* CurModel, unsigned int j){
+  unsigned int start = Models->n_rows - CurModel->n_elem;
+  for(unsigned int i = 0; i < CurModel->n_elem; i++){
+    Models->at(start + i, j) = CurModel->at(i) != 0;
+  }
+}
+
+// Gets metric value used to cutoff branches, this is read in the same critical 
+// section that the best metrics are updated in
+// If Shared is not null, then the cutoff found by other processes is also used
+double GetMetricCutoff(const arma::vec* BestMetrics, double cutoff, 
+                       SharedBound* Shared = nullptr){
+  double metricCutoff;
+#pragma omp critical(BestMetrics)
+  {
+    if(cutoff == -1){
+      metricCutoff = BestMetrics->at(BestMetrics->n_elem - 1);
+    }
+    else{
+      metricCutoff = BestMetrics->at(0) + cutoff;
+    }
+  }
+  if(Shared != nullptr){
+    metricCutoff = std::min(metricCutoff, Shared->get());
+  }
+  return(metricCutoff);
+}
+
+// Largest number of open nodes kept by the best-first search
+const unsigned int MaxNodes = 100000;
+
+// Forward declarations so the nodes of each search can be expanded by ExpandNode
+template<typename T>
+void BackwardBranch(const T* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+                    const arma::imat* Interactions, 
+                    std::string method, int m, GLMFamily Family,
+                    arma::ivec* CurModel, arma::mat* BestModels, arma::vec* BestMetrics, 
+                    unsigned long long* numchecked, arma::ivec* indices, double tol, 
+                    int maxit, unsigned int cur, const arma::vec* pen, 
+                    double LowerBound, arma::uvec* NewOrder, Progress* p, double cutoff, 
+                    const arma::vec* Init, const LinRegChol* Chol, 
+                    std::vector<GLMWorkspace>* Workspaces, SearchFrontier* Frontier);
+
+template<typename T>
+void SwitchForwardBranch(const T* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+               const arma::imat* Interactions,
+               std::string method, int m, GLMFamily Family,
+               arma::ivec* CurModel, arma::mat* BestModels, arma::vec* BestMetrics, 
+               unsigned long long* numchecked, arma::ivec* indices, double tol, 
+               int maxit, unsigned int cur, const arma::vec* pen, 
+               double LowerBound, arma::uvec* NewOrder, Progress* p, 
+               double UpperMetric, double cutoff, const LinRegChol* Chol, 
+               std::vector<GLMWorkspace>* Workspaces, SearchFrontier* Frontier);
+
+template<typename T>
+void SwitchBackwardBranch(const T* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+                       const arma::imat* Interactions,
+                       std::string method, int m, GLMFamily Family,
+                       arma::ivec* CurModel, arma::mat* BestModels, arma::vec* BestMetrics, 
+                       unsigned long long* numchecked, arma::ivec* indices, double tol, 
+                       int maxit, unsigned int cur, const arma::vec* pen, 
+                       double LowerBound, arma::uvec* NewOrder, Progress* p, 
+                       double LowerMetric, double cutoff, const LinRegChol* Chol, 
+                       std::vector<GLMWorkspace>* Workspaces, SearchFrontier* Frontier);
+
 // Function used to performing branching for branch and bound method
-void Branch(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+// If Queue is not null, then the new models are added to the queue instead of 
+// searching their subtrees
+template<typename T>
+void Branch(const T* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
             const arma::imat* Interactions, 
-            std::string method, int m, std::string Link, std::string Dist,
+            std::string method, int m, GLMFamily Family,
             arma::ivec* CurModel, arma::mat* BestModels, arma::vec* BestMetrics, 
-            unsigned int* numchecked, arma::ivec* indices, double tol, 
+            unsigned long long* numchecked, arma::ivec* indices, double tol, 
             int maxit, 
             int maxsize, unsigned int cur, const arma::vec* pen, 
-            double LowerBound, arma::uvec* NewOrder, Progress* p, double cutoff){
+            double LowerBound, arma::uvec* NewOrder, Progress* p, double cutoff, 
+            const arma::vec* Init, const LinRegChol* Chol, 
+            std::vector<GLMWorkspace>* Workspaces, NodeQueue* Queue, 
+            SearchFrontier* Frontier, SharedBound* Shared){
+  
+  // Adding this node to the queue instead of expanding it when the search is 
+  // suspended for a checkpoint
+  if(Frontier != nullptr && Frontier->Suspend()){
+    Frontier->Add(MakeNode(CurModel, NewOrder, cur, maxsize, LowerBound, Init));
+    return;
+  }
   
   // Checking for user interrupt
-  checkUserInterrupt();
+  if(p->interrupted()){
+    return;
+  }
   
   // Getting metric value used to cutoff branches
-  double metricCutoff;
-  if(cutoff == -1){
-    metricCutoff = BestMetrics->at(BestMetrics->n_elem - 1);
-  }
-  else{
-    metricCutoff = BestMetrics->at(0) + cutoff;
-  }
+  double metricCutoff = GetMetricCutoff(BestMetrics, cutoff, Shared);
   
   
   // Continuing branching process if lower bound is smaller than the best observed metric
@@ -98,45 +184,75 @@ void Branch(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const
     arma::uvec NewOrder2 = NewOrder->subvec(cur, NewOrder->n_elem - 1);
     arma::vec Metrics(NewOrder2.n_elem);
     arma::uvec Counts(NewOrder2.n_elem, arma::fill::zeros);
-    arma::mat NewModels(X->n_cols, NewOrder2.n_elem, arma::fill::zeros);
+    arma::mat NewModels(X->n_cols + CurModel->n_elem, NewOrder2.n_elem, arma::fill::zeros);
     
-    // Getting metric values
-#pragma omp parallel for schedule(dynamic) 
-    for(unsigned int j = 0; j < NewOrder2.n_elem; j++){
-      arma::ivec CurModel2 = *CurModel;
-      CurModel2.at(NewOrder2.at(j)) = 1;
-      if(CheckModel(&CurModel2, Interactions)){
-        // Only fitting model if it is valid
-        Counts.at(j) = 1;
-        Metrics.at(j) = MetricHelper(X, XTWX, Y, Offset, indices, &CurModel2, 
-                                     method, m, Link, Dist, tol, maxit, pen, 
-                                     j, &NewModels);
+    // Getting metric values, invalid models have a metric value of infinity
+    Metrics.fill(arma::datum::inf);
+    if(Chol != nullptr){
+#pragma omp taskloop default(shared) grainsize(1)
+      for(unsigned int j = 0; j < NewOrder2.n_elem; j++){
+        arma::ivec CurModel2 = *CurModel;
+        CurModel2.at(NewOrder2.at(j)) = 1;
+        if(CheckModel(&CurModel2, Interactions)){
+          // Adding the variable to the cholesky factor for linear regression
+          Counts.at(j) = 1;
+          SetIndicators(&NewModels, &CurModel2, j);
+          LinRegChol Chol2 = *Chol;
+          if(Chol2.AddVar(indices, NewOrder2.at(j))){
+            Metrics.at(j) = LinRegMetricHelper(&Chol2, &CurModel2, pen, j, &NewModels);
+          }
+        }
       }
-      else{
-        // If model is not valid then set metric value to infinity
-        Metrics.at(j) = arma::datum::inf;
+    }
+    else{
+      // Only fitting valid models, these are fit in batches that share passes over X
+      std::vector<arma::ivec> Models;
+      arma::uvec Cur(NewOrder2.n_elem);
+      for(unsigned int j = 0; j < NewOrder2.n_elem; j++){
+        arma::ivec CurModel2 = *CurModel;
+        CurModel2.at(NewOrder2.at(j)) = 1;
+        if(CheckModel(&CurModel2, Interactions)){
+          Counts.at(j) = 1;
+          SetIndicators(&NewModels, &CurModel2, j);
+          Cur.at(Models.size()) = j;
+          Models.push_back(CurModel2);
+        }
+      }
+      unsigned int nbatches = NumBatches(Models.size());
+#pragma omp taskloop default(shared) grainsize(1)
+      for(unsigned int b = 0; b < nbatches; b++){
+        BatchMetricHelper(X, XTWX, Y, Offset, indices, &Models, &Cur, b, nbatches, 
+                          method, m, Family, tol, maxit, pen, &NewModels, &Metrics, 
+                          Init, GetWorkspace(Workspaces));
       }
     }
     
     // Updating numchecked and potentially updating the best model
+#pragma omp atomic
     *numchecked += arma::accu(Counts);
     UpdateBestMetrics(BestModels, BestMetrics, &NewModels, &Metrics, cutoff);
     
-    // Getting cutoff for new best metric
-    if(cutoff == -1){
-      metricCutoff = BestMetrics->at(BestMetrics->n_elem - 1);
-    }
-    else{
-      metricCutoff = BestMetrics->at(0) + cutoff;
+    // Getting cutoff for new best metric and sharing it with other processes
+    if(Shared != nullptr){
+      Shared->put(GetMetricCutoff(BestMetrics, cutoff));
     }
+    metricCutoff = GetMetricCutoff(BestMetrics, cutoff, Shared);
     
     // Updating best metrics must be done before sorting
     arma::uvec sorted = sort_index(Metrics);
     NewOrder2 = NewOrder2(sorted);
     Metrics = Metrics(sorted);
     
-    // Checking for user interrupt
-    checkUserInterrupt();
+    // Keeping coefficients of the new models to use as initial values for their 
+    // children, this is done before the bounds overwrite them
+    arma::mat NewBetas = NewModels.cols(sorted);
+    arma::vec NewMetrics = Metrics;
+    
+    // Checking for user interrupt, when the search is checkpointed the node is 
+    // finished so none of its models are lost
+    if(p->interrupted() && Frontier == nullptr){
+      return;
+    }
     
     // Only find bounds and perform branching if there is at least 1 element to branch on
     // and maxsize is greater than 1
@@ -149,7 +265,7 @@ void Branch(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const
       arma::uvec Counts2(NewOrder2.n_elem - 1, arma::fill::zeros);
       
       // Getting lower bounds
-    #pragma omp parallel for schedule(dynamic)
+    #pragma omp taskloop default(shared) grainsize(1)
       for(unsigned int j = 0; j < NewOrder2.n_elem - 1; j++){
         // Checking if any previous bounds mean we don't need to check this set of models
         bool flag = false;
@@ -166,9 +282,9 @@ void Branch(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const
             Counts2.at(j) = 1;
           
             // Getting lower bound of model without current variable necessarily included
-            Bounds.at(j) = GetBound(X, XTWX, Y, Offset, method, m, Link, Dist, CurModel,
+            Bounds.at(j) = GetBound(X, XTWX, Y, Offset, method, m, Family, CurModel,
                          indices, tol, maxit, pen, j, &NewOrder2, LowerBound, 
-                         &Metrics, &NewModels);
+                         &Metrics, &NewModels, Init, Chol, GetWorkspace(Workspaces));
             Bounds.at(j) += min(*pen);
             if(std::isinf(Bounds.at(j))){
               Bounds.at(j) = LowerBound;
@@ -186,19 +302,62 @@ void Branch(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const
       }
       
       // Updating numchecked
+#pragma omp atomic
       (*numchecked) += arma::accu(Counts2);
       
-      // Checking for user interrupt
-      checkUserInterrupt();
+      // Checking for user interrupt, when the search is checkpointed the node is 
+      // finished so none of its models are lost
+      if(p->interrupted() && Frontier == nullptr){
+        return;
+      }
       
-      // Recursively calling this function for each new model
+      // Adding the new models to the queue for the best-first search
+      if(Queue != nullptr){
+        for(unsigned int j = 0; j < NewOrder2.n_elem - 1; j++){
+          BranchNode Node;
+          Node.CurModel = *CurModel;
+          Node.CurModel.at(NewOrder2.at(j)) = 1;
+          Node.NewOrder = NewOrder2;
+          Node.cur = j + 1;
+          Node.maxsize = maxsize - 1;
+          Node.LowerBound = Bounds.at(j);
+          if(!std::isinf(NewMetrics.at(j))){
+            Node.Init = NewBetas.col(j);
+          }
+          Queue->push(Node);
+        }
+        return;
+      }
+      
+      // Recursively calling this function for each new model, each subtree is 
+      // searched as a separate task
       for(unsigned int j = 0; j < NewOrder2.n_elem - 1; j++){
-        arma::ivec CurModel2 = *CurModel;
-        CurModel2.at(NewOrder2.at(j)) = 1;
-        Branch(X, XTWX, Y, Offset, Interactions, method, m, Link, Dist, &CurModel2, BestModels, 
-               BestMetrics, numchecked, indices, tol, maxit, maxsize - 1, j + 1, pen, 
-               Bounds.at(j), &NewOrder2, p, cutoff);
+#pragma omp task default(shared) firstprivate(j)
+        {
+          arma::ivec CurModel2 = *CurModel;
+          CurModel2.at(NewOrder2.at(j)) = 1;
+        
+          // Warm starting from the new model's coefficients if it was fit
+          arma::vec NewInit = NewBetas.col(j);
+          const arma::vec* Init2 = std::isinf(NewMetrics.at(j)) ? nullptr : &NewInit;
+          if(Chol != nullptr){
+            // Updating the cholesky factor for the new model, models are fit 
+            // from scratch if this model is singular
+            LinRegChol Chol2 = *Chol;
+            bool Success = Chol2.AddVar(indices, NewOrder2.at(j));
+            Branch(X, XTWX, Y, Offset, Interactions, method, m, Family, &CurModel2, BestModels, 
+                   BestMetrics, numchecked, indices, tol, maxit, maxsize - 1, j + 1, pen, 
+                   Bounds.at(j), &NewOrder2, p, cutoff, Init2, Success ? &Chol2 : nullptr, 
+                   Workspaces, nullptr, Frontier, Shared);
+          }else{
+            Branch(X, XTWX, Y, Offset, Interactions, method, m, Family, &CurModel2, BestModels, 
+                   BestMetrics, numchecked, indices, tol, maxit, maxsize - 1, j + 1, pen, 
+                   Bounds.at(j), &NewOrder2, p, cutoff, Init2, nullptr, Workspaces, 
+                   nullptr, Frontier, Shared);
+          }
+        }
       }
+#pragma omp taskwait
     }
   }
   else{
@@ -208,26 +367,203 @@ void Branch(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const
   }
 }
 
+// Expands a node that was taken from a queue of open nodes with the branching 
+// function of the search that it belongs to
+// If Switch is true, then the node is from the switch search and Chol is the 
+// factor of the initial model, otherwise the factor for the node is found from Chol
+template<typename T>
+void ExpandNode(const T* X, const arma::mat* XTWX, const arma::vec* Y, 
+                const arma::vec* Offset, const arma::imat* Interactions, 
+                std::string method, int m, GLMFamily Family, BranchNode* Node, 
+                arma::mat* BestModels, arma::vec* BestMetrics, 
+                unsigned long long* numchecked, arma::ivec* indices, double tol, 
+                int maxit, const arma::vec* pen, Progress* p, double cutoff, bool Switch, 
+                const LinRegChol* Chol, std::vector<GLMWorkspace>* Workspaces, 
+                NodeQueue* Queue, SearchFrontier* Frontier, SharedBound* Shared){
+  
+  // The switch search always uses the factor of the initial model
+  if(Switch){
+    if(Node->Forward){
+      SwitchForwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Family, 
+                          &Node->CurModel, BestModels, BestMetrics, numchecked, indices, 
+                          tol, maxit, Node->cur, pen, Node->LowerBound, &Node->NewOrder, 
+                          p, Node->Metric, cutoff, Chol, Workspaces, Frontier);
+    }else{
+      SwitchBackwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Family, 
+                           &Node->CurModel, BestModels, BestMetrics, numchecked, indices, 
+                           tol, maxit, Node->cur, pen, Node->LowerBound, &Node->NewOrder, 
+                           p, Node->Metric, cutoff, Chol, Workspaces, Frontier);
+    }
+    return;
+  }
+  
+  // The cholesky factor isn't stored with each node, so it is found from 
+  // the factor of the initial model
+  const arma::vec* Init = Node->Init.n_elem > 0 ? &Node->Init : nullptr;
+  if(Chol != nullptr){
+    LinRegChol Chol2 = *Chol;
+    bool Success = Chol2.AddModel(indices, &Node->CurModel);
+    if(Node->Forward){
+      Branch(X, XTWX, Y, Offset, Interactions, method, m, Family, &Node->CurModel, 
+             BestModels, BestMetrics, numchecked, indices, tol, maxit, Node->maxsize, 
+             Node->cur, pen, Node->LowerBound, &Node->NewOrder, p, cutoff, Init, 
+             Success ? &Chol2 : nullptr, Workspaces, Queue, Frontier, Shared);
+    }else{
+      BackwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Family, &Node->CurModel, 
+                     BestModels, BestMetrics, numchecked, indices, tol, maxit, Node->cur, 
+                     pen, Node->LowerBound, &Node->NewOrder, p, cutoff, Init, 
+                     Success ? &Chol2 : nullptr, Workspaces, Frontier);
+    }
+  }else if(Node->Forward){
+    Branch(X, XTWX, Y, Offset, Interactions, method, m, Family, &Node->CurModel, 
+           BestModels, BestMetrics, numchecked, indices, tol, maxit, Node->maxsize, 
+           Node->cur, pen, Node->LowerBound, &Node->NewOrder, p, cutoff, Init, 
+           nullptr, Workspaces, Queue, Frontier, Shared);
+  }else{
+    BackwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Family, &Node->CurModel, 
+                   BestModels, BestMetrics, numchecked, indices, tol, maxit, Node->cur, 
+                   pen, Node->LowerBound, &Node->NewOrder, p, cutoff, Init, nullptr, 
+                   Workspaces, Frontier);
+  }
+}
+
+// Depth-first search of the open nodes in Queue, each subtree is searched as a 
+// separate task
+// If Frontier is not null, then the search is suspended every interval seconds, 
+// the nodes that are left are written to checkpoint and the search continues 
+// from them until the queue is empty or the search is interrupted
+template<typename T>
+void SearchNodes(const T* X, const arma::mat* XTWX, const arma::vec* Y, 
+                 const arma::vec* Offset, const arma::imat* Interactions, 
+                 std::string method, int m, GLMFamily Family,
+                 arma::mat* BestModels, arma::vec* BestMetrics, 
+                 unsigned long long* numchecked, arma::ivec* indices, double tol, 
+                 int maxit, const arma::vec* pen, Progress* p, double cutoff, bool Switch, 
+                 const LinRegChol* Chol, std::vector<GLMWorkspace>* Workspaces, 
+                 NodeQueue* Queue, SearchFrontier* Frontier, std::string checkpoint, 
+                 uint64_t key, bool* failed, SharedBound* Shared){
+  
+  while(!Queue->empty()){
+    
+    // Taking the nodes out of the queue, suspended nodes are added back to it
+    std::vector<BranchNode> Nodes;
+    Nodes.reserve(Queue->size());
+    while(!Queue->empty()){
+      Nodes.push_back(Queue->top());
+      Queue->pop();
+    }
+    
+    // Searching the subtree of each node
+#pragma omp parallel
+    {
+#pragma omp single
+      {
+        for(unsigned int i = 0; i < Nodes.size(); i++){
+#pragma omp task default(shared) firstprivate(i)
+          ExpandNode(X, XTWX, Y, Offset, Interactions, method, m, Family, &Nodes.at(i), 
+                     BestModels, BestMetrics, numchecked, indices, tol, maxit, pen, p, 
+                     cutoff, Switch, Chol, Workspaces, nullptr, Frontier, Shared);
+        }
+#pragma omp taskwait
+      }
+    }
+    
+    if(Frontier == nullptr){
+      return;
+    }
+    
+    // Writing checkpoint, every task has returned so the nodes that are left 
+    // and the best models are consistent
+    if(!SaveCheckpoint(checkpoint, Queue, BestModels, BestMetrics, *numchecked, 
+                       p, pen, cutoff, key)){
+      *failed = true;
+    }
+    
+    // Checking for user interrupt
+    if(p->interrupted()){
+      return;
+    }
+    Frontier->Restart();
+  }
+}
+
+// Best-first search for branch and bound method
+// Open nodes are expanded in order of their lower bounds, so good models are 
+// found sooner and more of the tree is cut off. Once the queue holds MaxNodes 
+// nodes, the subtrees of expanded nodes are searched depth-first with Branch
+// If Frontier is not null, then the state of the search is written to checkpoint 
+// every interval seconds and when the search is interrupted
+// If nsplit is positive, then the search stops once there are nsplit open nodes, 
+// these are searched separately by other processes
+template<typename T>
+void BestFirstBranch(const T* X, const arma::mat* XTWX, const arma::vec* Y, 
+                     const arma::vec* Offset, const arma::imat* Interactions, 
+                     std::string method, int m, GLMFamily Family,
+                     arma::mat* BestModels, arma::vec* BestMetrics, 
+                     unsigned long long* numchecked, arma::ivec* indices, double tol, 
+                     int maxit, const arma::vec* pen, Progress* p, double cutoff, 
+                     const LinRegChol* Chol, std::vector<GLMWorkspace>* Workspaces, 
+                     NodeQueue* Queue, SearchFrontier* Frontier, std::string checkpoint, 
+                     uint64_t key, bool* failed, SharedBound* Shared, unsigned int nsplit){
+  
+  // Expanding the node with the smallest lower bound until the queue is empty
+  while(!Queue->empty() && (nsplit == 0 || Queue->size() < nsplit)){
+    
+    // Writing checkpoint
+    if(Frontier != nullptr && Frontier->Due()){
+      if(!SaveCheckpoint(checkpoint, Queue, BestModels, BestMetrics, *numchecked, 
+                         p, pen, cutoff, key)){
+        *failed = true;
+      }
+      Frontier->Restart();
+    }
+    
+    BranchNode Node = Queue->top();
+    Queue->pop();
+    
+    // An expanded node is always finished, so its children are in the queue 
+    // exactly once when the search is interrupted
+    NodeQueue* Queue2 = Queue->size() < MaxNodes ? Queue : nullptr;
+    ExpandNode(X, XTWX, Y, Offset, Interactions, method, m, Family, &Node, 
+               BestModels, BestMetrics, numchecked, indices, tol, maxit, pen, p, 
+               cutoff, false, Chol, Workspaces, Queue2, Frontier, Shared);
+    
+    // Checking for user interrupt
+    if(p->interrupted()){
+      if(Frontier != nullptr && 
+         !SaveCheckpoint(checkpoint, Queue, BestModels, BestMetrics, *numchecked, 
+                         p, pen, cutoff, key)){
+        *failed = true;
+      }
+      return;
+    }
+  }
+}
+
 
 // Branch and bound method
-// [[Rcpp::export]]
-List BranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector offset, 
-                       IntegerVector indices, IntegerVector num,
-                       IntegerMatrix interactions,
-                       std::string method, int m,
-                       std::string Link, std::string Dist,
-                       unsigned int nthreads, double tol, int maxit, 
-                       IntegerVector keep, int maxsize, NumericVector pen,
-                       bool display_progress, unsigned int NumBest, double cutoff){
+template<typename T>
+List BranchAndBoundHelper(const T* X, NumericVector y, NumericVector offset, 
+                          IntegerVector indices, IntegerVector num,
+                          IntegerMatrix interactions,
+                          std::string method, int m,
+                          std::string Link, std::string Dist,
+                          unsigned int nthreads, double tol, int maxit, 
+                          IntegerVector keep, int maxsize, NumericVector pen,
+                          bool display_progress, unsigned int NumBest, double cutoff, 
+                          bool bestfirst, std::string checkpoint, double interval, 
+                          bool resume, unsigned int nsplit, std::string shared){
+  
+  // Getting family and link used by the fitting functions
+  const GLMFamily Family = GetFamily(Dist, Link);
   
   // Creating necessary vectors/matrices
-  const arma::mat X(x.begin(), x.rows(), x.cols(), false, true);
   const arma::vec Y(y.begin(), y.size(), false, true);
   const arma::vec Offset(offset.begin(), offset.size(), false, true);
   const arma::vec Pen(pen.begin(), pen.size(), false, true);
   const arma::imat Interactions(interactions.begin(), interactions.rows(), 
                                 interactions.cols(), false, true);
-  arma::mat BestModels(X.n_cols, NumBest, arma::fill::zeros);
+  arma::mat BestModels(X->n_cols + keep.size(), NumBest, arma::fill::zeros);
   arma::vec BestMetrics(NumBest);
   BestMetrics.fill(arma::datum::inf);
   arma::ivec Indices(indices.begin(), indices.size(), false, true);
@@ -237,17 +573,24 @@ List BranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector offset,
   CurModel.replace(1, 0);
   
   
+  // Setting number of threads used to fit the candidate models
+  ThreadScope Threads(ChooseThreads(X->n_rows, X->n_cols, num.size(), nthreads));
+  
   // Getting X'WX
-  arma::mat XTWX = X.t() * X;
+  arma::mat XTWX = ParGramCpp(X);
+  
+  // Getting X'y, y'y, and the cholesky factor of X'X for the initial model, 
+  // these are used to get linear regression models without refitting them
+  const LinRegCross Cross = GetLinRegCross(X, &XTWX, &Y, &Offset, Family);
+  LinRegChol Chol(&XTWX, &Cross, X->n_rows);
+  bool UseChol = IsLinReg(Family) && Chol.AddModel(&Indices, &CurModel);
   
   // Creating necessary scalars
-  unsigned int numchecked = 1;
+  unsigned long long numchecked = 1;
   unsigned int size = 0;
   
-  // Setting number of threads if OpenMP is available
-#ifdef _OPENMP
-  omp_set_num_threads(nthreads);
-#endif
+  // Creating workspaces used to fit models for each thread
+  std::vector<GLMWorkspace> Workspaces = MakeWorkspaces(X->n_rows, X->n_cols);
   
   // Getting size of model space to check
   for(unsigned int j = 0; j < CurModel.n_elem; j++){
@@ -257,7 +600,7 @@ List BranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector offset,
   }
   
   // Creating object to report progress
-  Progress p(GetNum(size, maxsize), display_progress);
+  Progress p(GetNum(size, maxsize), display_progress, &numchecked);
   p.print();
   
   arma::uvec NewOrder(size);
@@ -273,70 +616,287 @@ List BranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector offset,
   // Checking for user interrupt
   checkUserInterrupt();
   
-  // Fitting initial model
-  arma::mat betaMat(X.n_cols, 1, arma::fill::zeros);
-  double CurMetric = MetricHelper(&X, &XTWX, &Y, &Offset, &Indices, 
-                                     &CurModel, method, m, Link, Dist, 
-                                     tol, maxit, &Pen, 0, &betaMat);
+  // Open nodes for the best-first search and for checkpoints
+  NodeQueue Queue;
+  SearchFrontier Frontier(&Queue, interval, &p);
+  SearchFrontier* Frontier1 = checkpoint.empty() ? nullptr : &Frontier;
+  uint64_t key = SearchKey(&Y, &Offset, X->n_cols, Dist, Link, "forward");
   
-  // Updating BestMetric is CurMetric is better
-  if(CurMetric < BestMetrics.at(0)){
-    BestMetrics.at(0) = CurMetric;
-    BestModels.col(0) = betaMat.col(0);
-  }
+  // Cutoff shared with other processes searching the same tree
+  SharedBound Bound(shared, checkpoint + ".bound");
+  SharedBound* Shared = shared.empty() ? nullptr : &Bound;
   
-  // Finding initial lower bound
+  // Coefficients of the initial model are used as initial values for the other models
+  arma::vec CurBeta;
+  const arma::vec* Init = nullptr;
   double LowerBound = -arma::datum::inf;
-  arma::vec Metrics(1);
-  Metrics.at(0) = arma::datum::inf;
-  LowerBound = GetBound(&X, &XTWX, &Y, &Offset, method, m, Link, Dist, &CurModel,
-                        &Indices, tol, maxit, &Pen, 
-                        0, &NewOrder, LowerBound, &Metrics, 
-                        &betaMat, true) + min(Pen);
   
-  // Incrementing numchecked
-  numchecked++;
+  if(resume){
+    // Reading the state of the search from the checkpoint file instead of 
+    // starting from the initial model
+    LoadCheckpoint(checkpoint, &Queue, &BestModels, &BestMetrics, &numchecked, &p, 
+                   &Pen, cutoff, key);
+  }else{
+    // Fitting initial model
+    arma::mat betaMat(X->n_cols + CurModel.n_elem, 1, arma::fill::zeros);
+    double CurMetric;
+    if(UseChol){
+      CurMetric = LinRegMetricHelper(&Chol, &CurModel, &Pen, 0, &betaMat);
+    }else{
+      CurMetric = MetricHelper(X, &XTWX, &Y, &Offset, &Indices, 
+                               &CurModel, method, m, Family, 
+                               tol, maxit, &Pen, 0, &betaMat, nullptr, GetWorkspace(&Workspaces));
+    }
+    SetIndicators(&betaMat, &CurModel, 0);
+    
+    // Updating BestMetric is CurMetric is better
+    if(CurMetric < BestMetrics.at(0)){
+      BestMetrics.at(0) = CurMetric;
+      BestModels.col(0) = betaMat.col(0);
+    }
+    CurBeta = betaMat.col(0);
+    Init = std::isinf(CurMetric) ? nullptr : &CurBeta;
+    
+    // Finding initial lower bound
+    arma::vec Metrics(1);
+    Metrics.at(0) = arma::datum::inf;
+    LowerBound = GetBound(X, &XTWX, &Y, &Offset, method, m, Family, &CurModel,
+                          &Indices, tol, maxit, &Pen, 
+                          0, &NewOrder, LowerBound, &Metrics, 
+                          &betaMat, Init, UseChol ? &Chol : nullptr, 
+                          GetWorkspace(&Workspaces), true) + min(Pen);
+    
+    // Incrementing numchecked
+    numchecked++;
+    
+    // The search starts from the initial model
+    Queue.push(MakeNode(&CurModel, &NewOrder, 0, maxsize, LowerBound, Init));
+  }
   
-  // Starting branching process
-  Branch(&X, &XTWX, &Y, &Offset, &Interactions, method, m, Link, Dist, &CurModel, &BestModels, 
-            &BestMetrics, &numchecked, &Indices, tol, maxit, maxsize, 0, &Pen, 
-            LowerBound, &NewOrder, &p, cutoff);
+  // Starting branching process, the tree is searched with tasks
+  // that are run by a team of threads
+  bool failed = false;
+  if(bestfirst){
+    // The loop is run by the master thread since progress is only printed and 
+    // interrupts are only checked on it, the other threads run the tasks it makes
+#pragma omp parallel
+    {
+#pragma omp master
+      BestFirstBranch(X, &XTWX, &Y, &Offset, &Interactions, method, m, Family, 
+                      &BestModels, &BestMetrics, &numchecked, &Indices, tol, maxit, 
+                      &Pen, &p, cutoff, UseChol ? &Chol : nullptr, &Workspaces, 
+                      &Queue, Frontier1, checkpoint, key, &failed, Shared, nsplit);
+    }
+  }else{
+    SearchNodes(X, &XTWX, &Y, &Offset, &Interactions, method, m, Family, 
+                &BestModels, &BestMetrics, &numchecked, &Indices, tol, maxit, 
+                &Pen, &p, cutoff, false, UseChol ? &Chol : nullptr, &Workspaces, 
+                &Queue, Frontier1, checkpoint, key, &failed, Shared);
+  }
   
-  // Printing off final update
-  p.finalprint();
+  // Warning if the checkpoint file couldn't be written
+  if(failed){
+    warning("the checkpoint file could not be written");
+  }
   
-  List FinalList = List::create(Named("bestmodels") = BestModels,
-                                Named("numchecked") = numchecked,
-                                Named("bestmetrics") = BestMetrics);
+  // Stopping if the user interrupted the search
+  if(p.interrupted()){
+    throw Rcpp::internal::InterruptedException();
+  }
   
-  // Resetting number of threads if OpenMP is available
-#ifdef _OPENMP
-  omp_set_num_threads(1);
-#endif
+  // Writing the open nodes to separate checkpoint files so they can be searched 
+  // by other processes, the shared cutoff starts from the best models found so far
+  unsigned int nparts = 0;
+  if(nsplit > 0 && !Queue.empty()){
+    if(Shared != nullptr){
+      Shared->put(GetMetricCutoff(&BestMetrics, cutoff));
+    }
+    nparts = SplitCheckpoint(checkpoint, &Queue, &BestModels, &BestMetrics, 
+                             numchecked, &p, &Pen, cutoff, key);
+  }else{
+    // Printing off final update
+    p.finalprint();
+  }
+  
+  List FinalList = List::create(Named("bestmodels") = arma::mat(BestModels.rows(0, X->n_cols - 1)),
+                                Named("bestindicators") = 
+                                  arma::mat(BestModels.rows(X->n_cols, BestModels.n_rows - 1)),
+                                Named("numchecked") = (double)numchecked,
+                                Named("bestmetrics") = BestMetrics, 
+                                Named("nparts") = nparts);
   
   return(FinalList);
 }
 
+// Refits the best models found by a search with a single precision copy of X 
+// with X itself, so the reported metrics and coefficients don't depend on the 
+// rounding of X, the coefficients from the search are used as initial values
+// The variables in each model are given by the indicators from the search
+// The models are sorted again since their order can change with the refit
+List RefitBestModels(const arma::mat* X, List Search, NumericVector y, 
+                     NumericVector offset, IntegerVector indices, 
+                     std::string method, int m, std::string Link, std::string Dist,
+                     unsigned int nthreads, double tol, int maxit, 
+                     NumericVector pen, double cutoff){
+  
+  // Getting family and link used by the fitting functions
+  const GLMFamily Family = GetFamily(Dist, Link);
+  
+  // Creating necessary vectors/matrices
+  const arma::vec Y(y.begin(), y.size(), false, true);
+  const arma::vec Offset(offset.begin(), offset.size(), false, true);
+  const arma::vec Pen(pen.begin(), pen.size(), false, true);
+  const arma::ivec Indices(indices.begin(), indices.size(), false, true);
+  NumericMatrix models = Search["bestmodels"];
+  NumericMatrix indicators = Search["bestindicators"];
+  NumericVector metrics = Search["bestmetrics"];
+  arma::mat BestModels(models.begin(), models.rows(), models.cols());
+  arma::mat BestIndicators(indicators.begin(), indicators.rows(), indicators.cols());
+  arma::vec BestMetrics(metrics.begin(), metrics.size());
+  
+  // Getting the columns of X that are in any of the models
+  arma::uvec Used(X->n_cols, arma::fill::zeros);
+  for(unsigned int j = 0; j < BestModels.n_cols; j++){
+    if(std::isinf(BestMetrics.at(j))){
+      continue;
+    }
+    for(unsigned int i = 0; i < Indices.n_elem; i++){
+      if(BestIndicators.at(Indices.at(i), j) != 0){
+        Used.at(i) = 1;
+      }
+    }
+  }
+  arma::uvec Cols = find(Used);
+  
+  // Setting number of threads used to refit the models
+  ThreadScope Threads(ChooseThreads(X->n_rows, X->n_cols, BestModels.n_cols, nthreads));
+  
+  // Getting X'WX, only the block for the columns that are used is needed
+  arma::mat XTWX(X->n_cols, X->n_cols, arma::fill::zeros);
+  if(Cols.n_elem > 0){
+    arma::vec w(X->n_rows, arma::fill::ones);
+    XTWX.submat(Cols, Cols) = ParWeightedXTX(X, &Cols, &w);
+  }
+  
+  // Creating workspaces used to fit models for each thread
+  std::vector<GLMWorkspace> Workspaces = MakeWorkspaces(X->n_rows, X->n_cols);
+  
+  // Refitting models
+#pragma omp parallel for schedule(dynamic, 1)
+  for(unsigned int j = 0; j < BestModels.n_cols; j++){
+    if(std::isinf(BestMetrics.at(j))){
+      continue;
+    }
+    arma::ivec CurModel(Pen.n_elem, arma::fill::zeros);
+    for(unsigned int i = 0; i < Pen.n_elem; i++){
+      CurModel.at(i) = BestIndicators.at(i, j) != 0;
+    }
+    const arma::vec Init = BestModels.col(j);
+    arma::mat betaMat(X->n_cols, 1, arma::fill::zeros);
+    BestMetrics.at(j) = MetricHelper(X, &XTWX, &Y, &Offset, &Indices, &CurModel, 
+                                     method, m, Family, tol, maxit, &Pen, 0, 
+                                     &betaMat, &Init, GetWorkspace(&Workspaces));
+    BestModels.col(j) = betaMat.col(0);
+  }
+  
+  // Sorting models and only keeping models within cutoff of the best model
+  arma::uvec sorted = arma::stable_sort_index(BestMetrics);
+  BestMetrics = BestMetrics.elem(sorted);
+  BestModels = BestModels.cols(sorted);
+  BestIndicators = BestIndicators.cols(sorted);
+  if(cutoff >= 0){
+    arma::uvec keep = find(BestMetrics <= BestMetrics.at(0) + cutoff);
+    if(keep.n_elem > 0){
+      BestMetrics = BestMetrics.elem(keep);
+      BestModels = BestModels.cols(keep);
+      BestIndicators = BestIndicators.cols(keep);
+    }
+  }
+  Search["bestmodels"] = BestModels;
+  Search["bestindicators"] = BestIndicators;
+  Search["bestmetrics"] = BestMetrics;
+  
+  return(Search);
+}
+
+// Branch and bound method, x is either a numeric matrix or a dgCMatrix
+// If float32 is true, then the search uses a single precision copy of a dense x 
+// and the best models are refit with x
+// [[Rcpp::export]]
+List BranchAndBoundCpp(SEXP x, NumericVector y, NumericVector offset, 
+                       IntegerVector indices, IntegerVector num,
+                       IntegerMatrix interactions,
+                       std::string method, int m,
+                       std::string Link, std::string Dist,
+                       unsigned int nthreads, double tol, int maxit, 
+                       IntegerVector keep, int maxsize, NumericVector pen,
+                       bool display_progress, unsigned int NumBest, double cutoff, 
+                       bool bestfirst, std::string checkpoint, double interval, 
+                       bool resume, unsigned int nsplit, std::string shared, 
+                       bool float32){
+  
+  // Sparse design matrices are dgCMatrix objects, these are kept in CSC form
+  if(Rf_isS4(x)){
+    const arma::sp_mat X = as<arma::sp_mat>(x);
+    return(BranchAndBoundHelper(&X, y, offset, indices, num, interactions, method, m,
+                                Link, Dist, nthreads, tol, maxit, keep, maxsize, pen,
+                                display_progress, NumBest, cutoff, bestfirst,
+                                checkpoint, interval, resume, nsplit, shared));
+  }
+  // Dense design matrices are either numeric matrices or mapped design files
+  const DenseDesign X(x);
+  if(float32){
+    // The single precision copy is held in memory along with x, so mapped 
+    // design files which may not fit in memory can't be used
+    if(TYPEOF(x) == EXTPTRSXP){
+      stop("float32 can't be used with mapped design matrices");
+    }
+    
+    // The copy is freed before the best models are refit with x
+    List Search;
+    {
+      const arma::fmat XF = arma::conv_to<arma::fmat>::from(*X.get());
+      Search = BranchAndBoundHelper(&XF, y, offset, indices, num, interactions, 
+                                    method, m, Link, Dist, nthreads, tol, maxit,
+                                    keep, maxsize, pen, display_progress, NumBest,
+                                    cutoff, bestfirst, checkpoint, interval, resume,
+                                    nsplit, shared);
+    }
+    return(RefitBestModels(X.get(), Search, y, offset, indices, method, m, Link, Dist, 
+                           nthreads, tol, maxit, pen, cutoff));
+  }
+  return(BranchAndBoundHelper(X.get(), y, offset, indices, num, interactions, method, m,
+                              Link, Dist, nthreads, tol, maxit, keep, maxsize, pen,
+                              display_progress, NumBest, cutoff, bestfirst, checkpoint,
+                              interval, resume, nsplit, shared));
+}
+
 // Function used to performing branching for backward branch and bound method
-void BackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+template<typename T>
+void BackwardBranch(const T* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
                     const arma::imat* Interactions, 
-                    std::string method, int m, std::string Link, std::string Dist,
+                    std::string method, int m, GLMFamily Family,
                     arma::ivec* CurModel, arma::mat* BestModels, arma::vec* BestMetrics, 
-                    unsigned int* numchecked, arma::ivec* indices, double tol, 
+                    unsigned long long* numchecked, arma::ivec* indices, double tol, 
                     int maxit, unsigned int cur, const arma::vec* pen, 
-                    double LowerBound, arma::uvec* NewOrder, Progress* p, double cutoff){
+                    double LowerBound, arma::uvec* NewOrder, Progress* p, double cutoff, 
+                    const arma::vec* Init, const LinRegChol* Chol, 
+                    std::vector<GLMWorkspace>* Workspaces, SearchFrontier* Frontier){
+  
+  // Adding this node to the queue instead of expanding it when the search is 
+  // suspended for a checkpoint
+  if(Frontier != nullptr && Frontier->Suspend()){
+    Frontier->Add(MakeNode(CurModel, NewOrder, cur, 0, LowerBound, Init, false));
+    return;
+  }
   
   // Checking for user interrupt
-  checkUserInterrupt();
+  if(p->interrupted()){
+    return;
+  }
   
   // Getting metric value used to cutoff branches
-  double metricCutoff;
-  if(cutoff == -1){
-    metricCutoff = BestMetrics->at(BestMetrics->n_elem - 1);
-  }
-  else{
-    metricCutoff = BestMetrics->at(0) + cutoff;
-  }
+  double metricCutoff = GetMetricCutoff(BestMetrics, cutoff);
   // Continuing branching process if lower bound is smaller than the best observed metric
   if(LowerBound < metricCutoff){
     // Updating progress
@@ -348,10 +908,10 @@ void BackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::vec*
     arma::vec Metrics(cur + 1);
     Metrics.fill(arma::datum::inf);
     arma::uvec Counts(cur + 1, arma::fill::zeros);
-    arma::mat NewModels(X->n_cols, NewOrder2.n_elem, arma::fill::zeros);
+    arma::mat NewModels(X->n_cols + CurModel->n_elem, NewOrder2.n_elem, arma::fill::zeros);
     
     // Getting metric values
-#pragma omp parallel for schedule(dynamic) 
+#pragma omp taskloop default(shared) grainsize(1)
     for(unsigned int j = 0; j < NewOrder2.n_elem; j++){
       arma::ivec CurModel2 = *CurModel;
       CurModel2.at(NewOrder->at(j)) = 0;
@@ -359,14 +919,23 @@ void BackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::vec*
       if(CheckModel(&CurModel2, Interactions)){
         // Only fitting model if it is valid
         Counts.at(j) = 1;
-        Metrics.at(j) = MetricHelper(X, XTWX, Y, Offset, indices, &CurModel2,
-                                          method, m, Link, Dist, 
-                                          tol, maxit, pen, j, &NewModels);
+        SetIndicators(&NewModels, &CurModel2, j);
+        if(Chol != nullptr){
+          // Dropping the variable from the cholesky factor for linear regression
+          LinRegChol Chol2 = *Chol;
+          Chol2.DropVar(indices, NewOrder->at(j));
+          Metrics.at(j) = LinRegMetricHelper(&Chol2, &CurModel2, pen, j, &NewModels);
+        }else{
+          Metrics.at(j) = MetricHelper(X, XTWX, Y, Offset, indices, &CurModel2,
+                                       method, m, Family, 
+                                       tol, maxit, pen, j, &NewModels, Init, GetWorkspace(Workspaces));
+        }
       }
     }
     
     
     // Updating numchecked and potentially updating the best model
+#pragma omp atomic
     *numchecked += arma::accu(Counts);
     UpdateBestMetrics(BestModels, BestMetrics, &NewModels, &Metrics, cutoff);
     
@@ -375,14 +944,22 @@ void BackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::vec*
     NewOrder2 = NewOrder2(sorted);
     Metrics = Metrics(sorted);
     
-    // Checking for user interrupt
-    checkUserInterrupt();
+    // Keeping coefficients of the new models to use as initial values for their 
+    // children, this is done before the bounds overwrite the metric values
+    arma::mat NewBetas = NewModels.cols(sorted);
+    arma::vec NewMetrics = Metrics;
+    
+    // Checking for user interrupt, when the search is checkpointed the node is 
+    // finished so none of its models are lost
+    if(p->interrupted() && Frontier == nullptr){
+      return;
+    }
     
     // Creating vector to store Counts
     arma::uvec Counts2(Metrics.n_elem - 1, arma::fill::zeros);
     
     // Getting lower bounds which are now stored in Metrics
-#pragma omp parallel for schedule(dynamic)
+#pragma omp taskloop default(shared) grainsize(1)
     for(unsigned int j = 1; j < NewOrder2.n_elem; j++){
       arma::ivec CurModel2 = *CurModel;
       CurModel2.at(NewOrder2.at(j)) = 0;
@@ -393,12 +970,18 @@ void BackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::vec*
           // Fitting model for upper bound since it wasn't fit earlier
           // Only done when the upper model isn't valid, but the set is valid
           Counts2(j - 1) = 1;
-          Metrics.at(j) = MetricHelper(X, XTWX, Y, Offset, indices, &CurModel2,
-                  method, m, Link, Dist, 
-                  tol, maxit, pen, j, &NewModels);
+          if(Chol != nullptr){
+            LinRegChol Chol2 = *Chol;
+            Chol2.DropVar(indices, NewOrder2.at(j));
+            Metrics.at(j) = LinRegMetricHelper(&Chol2, &CurModel2, pen, j, &NewModels);
+          }else{
+            Metrics.at(j) = MetricHelper(X, XTWX, Y, Offset, indices, &CurModel2,
+                    method, m, Family, 
+                    tol, maxit, pen, j, &NewModels, Init, GetWorkspace(Workspaces));
+          }
         }
         if(!std::isinf(Metrics.at(j))){
-          Metrics.at(j) = BackwardGetBound(X, indices, &CurModel2, &NewOrder2, 
+          Metrics.at(j) = BackwardGetBound(indices, &CurModel2, &NewOrder2, 
                      j, Metrics.at(j), pen);
         }else{
           Metrics.at(j) = LowerBound;
@@ -411,19 +994,43 @@ void BackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::vec*
     }
     
     // Updating numchecked
+#pragma omp atomic
     (*numchecked) += arma::accu(Counts2);
     
-    // Checking for user interrupt
-    checkUserInterrupt();
+    // Checking for user interrupt, when the search is checkpointed the node is 
+    // finished so none of its models are lost
+    if(p->interrupted() && Frontier == nullptr){
+      return;
+    }
     
-    // Recursively calling this function for each new model
+    // Recursively calling this function for each new model, each subtree is 
+    // searched as a separate task
     for(unsigned int j = 1; j < NewOrder2.n_elem; j++){
-      arma::ivec CurModel2 = *CurModel;
-      CurModel2.at(NewOrder2.at(j)) = 0;
-      BackwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Link, Dist, &CurModel2, BestModels, 
-                     BestMetrics, numchecked, indices, tol, maxit, j - 1, pen, 
-                     Metrics.at(j), &NewOrder2, p, cutoff);
+#pragma omp task default(shared) firstprivate(j)
+      {
+        arma::ivec CurModel2 = *CurModel;
+        CurModel2.at(NewOrder2.at(j)) = 0;
+      
+        // Warm starting from the new model's coefficients if it was fit
+        arma::vec NewInit = NewBetas.col(j);
+        const arma::vec* Init2 = std::isinf(NewMetrics.at(j)) ? nullptr : &NewInit;
+        if(Chol != nullptr){
+          // Updating the cholesky factor for the new model
+          LinRegChol Chol2 = *Chol;
+          Chol2.DropVar(indices, NewOrder2.at(j));
+          BackwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Family, &CurModel2, BestModels, 
+                         BestMetrics, numchecked, indices, tol, maxit, j - 1, pen, 
+                         Metrics.at(j), &NewOrder2, p, cutoff, Init2, &Chol2, Workspaces, 
+                         Frontier);
+        }else{
+          BackwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Family, &CurModel2, BestModels, 
+                         BestMetrics, numchecked, indices, tol, maxit, j - 1, pen, 
+                         Metrics.at(j), &NewOrder2, p, cutoff, Init2, nullptr, Workspaces, 
+                         Frontier);
+        }
+      }
     }
+#pragma omp taskwait
   }
   else{
     // Updating progress since we have cut off part of the tree
@@ -434,24 +1041,27 @@ void BackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::vec*
 
 
 // Backward Branch and bound method
-// [[Rcpp::export]]
-List BackwardBranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector offset, 
-                               IntegerVector indices, IntegerVector num,
-                               IntegerMatrix interactions,
-                               std::string method, int m,
-                               std::string Link, std::string Dist,
-                               unsigned int nthreads, double tol, int maxit, 
-                               IntegerVector keep, NumericVector pen,
-                               bool display_progress, unsigned int NumBest, double cutoff){
+template<typename T>
+List BackwardBranchAndBoundHelper(const T* X, NumericVector y, NumericVector offset, 
+                                  IntegerVector indices, IntegerVector num,
+                                  IntegerMatrix interactions,
+                                  std::string method, int m,
+                                  std::string Link, std::string Dist,
+                                  unsigned int nthreads, double tol, int maxit, 
+                                  IntegerVector keep, NumericVector pen,
+                                  bool display_progress, unsigned int NumBest, double cutoff, 
+                                  std::string checkpoint, double interval, bool resume){
+  
+  // Getting family and link used by the fitting functions
+  const GLMFamily Family = GetFamily(Dist, Link);
   
   // Creating necessary vectors/matrices
-  const arma::mat X(x.begin(), x.rows(), x.cols(), false, true);
   const arma::vec Y(y.begin(), y.size(), false, true);
   const arma::vec Offset(offset.begin(), offset.size(), false, true);
   const arma::vec Pen(pen.begin(), pen.size(), false, true);
   const arma::imat Interactions(interactions.begin(), interactions.rows(), 
                                 interactions.cols(), false, true);
-  arma::mat BestModels(X.n_cols, NumBest, arma::fill::zeros);
+  arma::mat BestModels(X->n_cols + keep.size(), NumBest, arma::fill::zeros);
   arma::vec BestMetrics(NumBest);
   BestMetrics.fill(arma::datum::inf);
   arma::ivec Indices(indices.begin(), indices.size(), false, true);
@@ -460,14 +1070,20 @@ List BackwardBranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector o
   // Making sure that CurModel includes all variables 
   CurModel.replace(0, 1);
   
+  // Setting number of threads used to fit the candidate models
+  ThreadScope Threads(ChooseThreads(X->n_rows, X->n_cols, num.size(), nthreads));
+  
   // Getting X'WX
-  arma::mat XTWX = X.t() * X;
+  arma::mat XTWX = ParGramCpp(X);
   
-  // Setting number of threads if OpenMP is defined
-#ifdef _OPENMP
-  omp_set_num_threads(nthreads);
-#endif
+  // Getting X'y, y'y, and the cholesky factor of X'X for the initial model, 
+  // these are used to get linear regression models without refitting them
+  const LinRegCross Cross = GetLinRegCross(X, &XTWX, &Y, &Offset, Family);
+  LinRegChol Chol(&XTWX, &Cross, X->n_rows);
+  bool UseChol = IsLinReg(Family) && Chol.AddModel(&Indices, &CurModel);
   
+  // Creating workspaces used to fit models for each thread
+  std::vector<GLMWorkspace> Workspaces = MakeWorkspaces(X->n_rows, X->n_cols);
   
   // Getting size of model space to check
   unsigned int size = 0;
@@ -477,8 +1093,11 @@ List BackwardBranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector o
     }
   }
   
+  // Creating numchecked to keep track of the number of models fit
+  unsigned long long numchecked = 0;
+  
   // Creating object to report progress
-  Progress p(GetNum(size, size), display_progress);
+  Progress p(GetNum(size, size), display_progress, &numchecked);
   p.print();
   
   
@@ -492,77 +1111,159 @@ List BackwardBranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector o
     }
   }
   
-  // Fitting model with all variables included
-  arma::mat betaMat(X.n_cols, 1, arma::fill::zeros);
-  double CurMetric = MetricHelper(&X, &XTWX, &Y, &Offset, &Indices, &CurModel,
-                                     method, m, Link, Dist, 
-                                     tol, maxit, &Pen, 0, &betaMat);
-  
-  // Updating BestMetric and BestModel if CurMetric is better than BestMetric
-  if(CurMetric < BestMetrics.at(0)){
-    BestMetrics.at(0) = CurMetric;
-    BestModels.col(0) = betaMat.col(0);
+  // Open nodes that are written to checkpoint files
+  NodeQueue Queue;
+  SearchFrontier Frontier(&Queue, interval, &p);
+  SearchFrontier* Frontier1 = checkpoint.empty() ? nullptr : &Frontier;
+  uint64_t key = SearchKey(&Y, &Offset, X->n_cols, Dist, Link, "backward");
+  
+  if(resume){
+    // Reading the state of the search from the checkpoint file instead of 
+    // starting from the full model
+    LoadCheckpoint(checkpoint, &Queue, &BestModels, &BestMetrics, &numchecked, &p, 
+                   &Pen, cutoff, key);
+  }else{
+    // Fitting model with all variables included
+    arma::mat betaMat(X->n_cols + CurModel.n_elem, 1, arma::fill::zeros);
+    double CurMetric;
+    if(UseChol){
+      CurMetric = LinRegMetricHelper(&Chol, &CurModel, &Pen, 0, &betaMat);
+    }else{
+      CurMetric = MetricHelper(X, &XTWX, &Y, &Offset, &Indices, &CurModel,
+                               method, m, Family, 
+                               tol, maxit, &Pen, 0, &betaMat, nullptr, GetWorkspace(&Workspaces));
+    }
+    SetIndicators(&betaMat, &CurModel, 0);
+    
+    // Updating BestMetric and BestModel if CurMetric is better than BestMetric
+    if(CurMetric < BestMetrics.at(0)){
+      BestMetrics.at(0) = CurMetric;
+      BestModels.col(0) = betaMat.col(0);
+    }
+    
+    // Coefficients of the full model are used as initial values for its children
+    arma::vec CurBeta = betaMat.col(0);
+    const arma::vec* Init = std::isinf(CurMetric) ? nullptr : &CurBeta;
+    
+    // Incrementing numchecked
+    numchecked++;
+    
+    // Getting lower bound for all models
+    double LowerBound = BackwardGetBound(&Indices, &CurModel, &NewOrder, 
+                                         NewOrder.n_elem, CurMetric, &Pen);
+    
+    // The search starts from the full model
+    Queue.push(MakeNode(&CurModel, &NewOrder, NewOrder.n_elem - 1, 0, LowerBound, 
+                        Init, false));
   }
   
-  // Creating numchecked to keep track of the number of models fit
-  unsigned int numchecked = 1;
-  
-  // Getting lower bound for all models
-  double LowerBound = BackwardGetBound(&X, &Indices, &CurModel, &NewOrder, 
-                                          NewOrder.n_elem, CurMetric, &Pen);
+  // Starting the branching process, the tree is searched with tasks
+  // that are run by a team of threads
+  bool failed = false;
+  SearchNodes(X, &XTWX, &Y, &Offset, &Interactions, method, m, Family, 
+              &BestModels, &BestMetrics, &numchecked, &Indices, tol, maxit, 
+              &Pen, &p, cutoff, false, UseChol ? &Chol : nullptr, &Workspaces, 
+              &Queue, Frontier1, checkpoint, key, &failed, nullptr);
+  
+  // Warning if the checkpoint file couldn't be written
+  if(failed){
+    warning("the checkpoint file could not be written");
+  }
   
-  // Starting the branching process
-  BackwardBranch(&X, &XTWX, &Y, &Offset, &Interactions, method, m, Link, Dist, &CurModel, &BestModels, 
-                    &BestMetrics, &numchecked, &Indices, tol, maxit, NewOrder.n_elem - 1, &Pen, 
-                    LowerBound, &NewOrder, &p, cutoff);
+  // Stopping if the user interrupted the search
+  if(p.interrupted()){
+    throw Rcpp::internal::InterruptedException();
+  }
   
   // Printing off final update
   p.finalprint();
   
-  List FinalList = List::create(Named("bestmodels") = BestModels,
-                                Named("numchecked") = numchecked,
+  List FinalList = List::create(Named("bestmodels") = arma::mat(BestModels.rows(0, X->n_cols - 1)),
+                                Named("bestindicators") = 
+                                  arma::mat(BestModels.rows(X->n_cols, BestModels.n_rows - 1)),
+                                Named("numchecked") = (double)numchecked,
                                 Named("bestmetrics") = BestMetrics);
   
-  // Resetting number of threads if OpenMP is defined
-#ifdef _OPENMP
-  omp_set_num_threads(1);
-#endif
-  
   return(FinalList);
 }
 
-// Defining backward branching function for switch method
-// Forward declaration so this can be called by the forward switch branch
-void SwitchBackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
-                             const arma::imat* Interactions,
-                             std::string method, int m, std::string Link, std::string Dist,
-                             arma::ivec* CurModel, arma::mat* BestModels, arma::vec* BestMetrics, 
-                             unsigned int* numchecked, arma::ivec* indices, double tol, 
-                             int maxit, unsigned int cur, const arma::vec* pen, 
-                             double LowerBound, arma::uvec* NewOrder, Progress* p, 
-                             double LowerMetric, double cutoff);
+// Backward branch and bound method, x is either a numeric matrix or a dgCMatrix
+// If float32 is true, then the search uses a single precision copy of a dense x 
+// and the best models are refit with x
+// [[Rcpp::export]]
+List BackwardBranchAndBoundCpp(SEXP x, NumericVector y, NumericVector offset, 
+                               IntegerVector indices, IntegerVector num,
+                               IntegerMatrix interactions,
+                               std::string method, int m,
+                               std::string Link, std::string Dist,
+                               unsigned int nthreads, double tol, int maxit, 
+                               IntegerVector keep, NumericVector pen,
+                               bool display_progress, unsigned int NumBest, double cutoff, 
+                               std::string checkpoint, double interval, bool resume, 
+                               bool float32){
+  
+  // Sparse design matrices are dgCMatrix objects, these are kept in CSC form
+  if(Rf_isS4(x)){
+    const arma::sp_mat X = as<arma::sp_mat>(x);
+    return(BackwardBranchAndBoundHelper(&X, y, offset, indices, num, interactions,
+                                        method, m, Link, Dist, nthreads, tol, maxit,
+                                        keep, pen, display_progress, NumBest, cutoff, 
+                                        checkpoint, interval, resume));
+  }
+  // Dense design matrices are either numeric matrices or mapped design files
+  const DenseDesign X(x);
+  if(float32){
+    // The single precision copy is held in memory along with x, so mapped 
+    // design files which may not fit in memory can't be used
+    if(TYPEOF(x) == EXTPTRSXP){
+      stop("float32 can't be used with mapped design matrices");
+    }
+    
+    // The copy is freed before the best models are refit with x
+    List Search;
+    {
+      const arma::fmat XF = arma::conv_to<arma::fmat>::from(*X.get());
+      Search = BackwardBranchAndBoundHelper(&XF, y, offset, indices, num, interactions, 
+                                            method, m, Link, Dist, nthreads, tol, maxit, keep,
+                                            pen, display_progress, NumBest, cutoff, checkpoint,
+                                            interval, resume);
+    }
+    return(RefitBestModels(X.get(), Search, y, offset, indices, method, m, Link, Dist, 
+                           nthreads, tol, maxit, pen, cutoff));
+  }
+  return(BackwardBranchAndBoundHelper(X.get(), y, offset, indices, num, interactions, method,
+                                      m, Link, Dist, nthreads, tol, maxit, keep, pen,
+                                      display_progress, NumBest, cutoff, checkpoint, 
+                                      interval, resume));
+}
 
 // Function used to performing branching for forward part of switch branch
-void SwitchForwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+template<typename T>
+void SwitchForwardBranch(const T* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
                const arma::imat* Interactions,
-               std::string method, int m, std::string Link, std::string Dist,
+               std::string method, int m, GLMFamily Family,
                arma::ivec* CurModel, arma::mat* BestModels, arma::vec* BestMetrics, 
-               unsigned int* numchecked, arma::ivec* indices, double tol, 
+               unsigned long long* numchecked, arma::ivec* indices, double tol, 
                int maxit, unsigned int cur, const arma::vec* pen, 
                double LowerBound, arma::uvec* NewOrder, Progress* p, 
-               double UpperMetric, double cutoff){
+               double UpperMetric, double cutoff, const LinRegChol* Chol, 
+               std::vector<GLMWorkspace>* Workspaces, SearchFrontier* Frontier){
+  
+  // Adding this node to the queue instead of expanding it when the search is 
+  // suspended for a checkpoint
+  if(Frontier != nullptr && Frontier->Suspend()){
+    Frontier->Add(MakeNode(CurModel, NewOrder, cur, 0, LowerBound, nullptr, true, 
+                           UpperMetric));
+    return;
+  }
   
   // Checking for user interrupt
-  checkUserInterrupt();
+  if(p->interrupted()){
+    return;
+  }
   
   // Getting metric value used to cutoff branches
-  double metricCutoff;
-  if(cutoff == -1){
-    metricCutoff = BestMetrics->at(BestMetrics->n_elem - 1);
-  }
-  else{
-    metricCutoff = BestMetrics->at(0) + cutoff;
-  }
+  double metricCutoff = GetMetricCutoff(BestMetrics, cutoff);
   
   // Continuing branching process if lower bound is smaller than the best observed metric
   if(LowerBound < metricCutoff){
@@ -574,10 +1275,10 @@ void SwitchForwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::
     arma::uvec NewOrder2(NewOrder->n_elem - cur);
     arma::vec Metrics(NewOrder->n_elem - cur);
     arma::uvec Counts(NewOrder->n_elem - cur, arma::fill::zeros);
-    arma::mat NewModels(X->n_cols, NewOrder2.n_elem, arma::fill::zeros);
+    arma::mat NewModels(X->n_cols + CurModel->n_elem, NewOrder2.n_elem, arma::fill::zeros);
      
     // Getting metric values
-#pragma omp parallel for schedule(dynamic)
+#pragma omp taskloop default(shared) grainsize(1)
     for(unsigned int j = 0; j < NewOrder2.n_elem; j++){
       arma::ivec CurModel2 = *CurModel;
       CurModel2(NewOrder->at(j + cur)) = 1;
@@ -585,9 +1286,14 @@ void SwitchForwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::
       if(CheckModel(&CurModel2, Interactions)){
         // Only fitting model if it is valid
         Counts.at(j) = 1;
-        Metrics(j) = MetricHelper(X, XTWX, Y, Offset, indices, &CurModel2, 
-                   method, m, Link, Dist, 
-                   tol, maxit, pen, j, &NewModels);
+        SetIndicators(&NewModels, &CurModel2, j);
+        if(Chol != nullptr){
+          Metrics(j) = LinRegMetricHelper(Chol, indices, &CurModel2, pen, j, &NewModels);
+        }else{
+          Metrics(j) = MetricHelper(X, XTWX, Y, Offset, indices, &CurModel2, 
+                     method, m, Family, 
+                     tol, maxit, pen, j, &NewModels, nullptr, GetWorkspace(Workspaces));
+        }
       }
       else{
         // If model is not valid then set metric value to infinity
@@ -596,24 +1302,23 @@ void SwitchForwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::
     }
     
     // Updating numchecked and potentially updating the best model
+#pragma omp atomic
     *numchecked += arma::accu(Counts);
     arma::uvec sorted = sort_index(Metrics);
     NewOrder2 = NewOrder2(sorted);
     UpdateBestMetrics(BestModels, BestMetrics, &NewModels, &Metrics, cutoff);
     
     // Updating metric cutoff
-    if(cutoff == -1){
-      metricCutoff = BestMetrics->at(BestMetrics->n_elem - 1);
-    }
-    else{
-      metricCutoff = BestMetrics->at(0) + cutoff;
-    }
+    metricCutoff = GetMetricCutoff(BestMetrics, cutoff);
     
     // Updating metrics must be done before sorting
     Metrics = Metrics(sorted);
     
-    // Checking for user interrupt
-    checkUserInterrupt();
+    // Checking for user interrupt, when the search is checkpointed the node is 
+    // finished so none of its models are lost
+    if(p->interrupted() && Frontier == nullptr){
+      return;
+    }
     
     // Only need to calculate bounds and branch if NewOrder2.n_elem > 1
     if(NewOrder2.n_elem > 1){
@@ -627,9 +1332,9 @@ void SwitchForwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::
       arma::vec Metrics2(NewOrder2.n_elem - 1);
       arma::uvec Counts2(NewOrder2.n_elem - 1, arma::fill::zeros);
       Metrics2.fill(arma::datum::inf);
-      arma::mat NewModels(X->n_cols, Bounds.n_elem, arma::fill::zeros);
+      arma::mat NewModels(X->n_cols + CurModel->n_elem, Bounds.n_elem, arma::fill::zeros);
       
-#pragma omp parallel for schedule(dynamic)
+#pragma omp taskloop default(shared) grainsize(1)
       for(unsigned int j = 0; j < NewOrder2.n_elem - 1; j++){
         arma::ivec CurModel2 = *CurModel;
         bool flag = false;
@@ -644,11 +1349,16 @@ void SwitchForwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::
           // Only need to calculate bounds if this set of models is valid
           if(j > 0){
             Counts2.at(j) = 1;
+            
+            // Storing which variables are in the upper model
+            arma::ivec UpperModel = CurModel2;
+            UpperModel.elem(NewOrder2.subvec(j, NewOrder2.n_elem - 1)).ones();
+            SetIndicators(&NewModels, &UpperModel, j);
           
             // Getting lower bound of model without current variable necessarily included
-            Bounds.at(j) = GetBound(X, XTWX, Y, Offset, method, m, Link, Dist, &CurModel2,
+            Bounds.at(j) = GetBound(X, XTWX, Y, Offset, method, m, Family, &CurModel2,
                       indices, tol, maxit, pen, j, &NewOrder2, 
-                      LowerBound, &Metrics2, &NewModels);
+                      LowerBound, &Metrics2, &NewModels, nullptr, Chol, GetWorkspace(Workspaces));
             Bounds.at(j) += min(*pen);
             if(std::isinf(Bounds.at(j))){
               Bounds.at(j) = LowerBound;
@@ -668,12 +1378,16 @@ void SwitchForwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::
       }
       
       // Updating numchecked and potentially updating the best model based on upper models
+#pragma omp atomic
       (*numchecked) += arma::accu(Counts2);
       UpdateBestMetrics(BestModels, BestMetrics, &NewModels, &Metrics2, cutoff);
       Metrics2.at(0) = UpperMetric;
       
-      // Checking for user interrupt
-      checkUserInterrupt();
+      // Checking for user interrupt, when the search is checkpointed the node is 
+      // finished so none of its models are lost
+      if(p->interrupted() && Frontier == nullptr){
+        return;
+      }
       
       // Defining upper model to be used for possible switch to backward branching
       /// Reversing new order for possible switch to backward branching
@@ -694,22 +1408,30 @@ void SwitchForwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::
           UpperModel(revNewOrder2(j + 1)) = 0;
         }
         
-        if(Metrics.at(j) > Metrics2.at(j - 1)){
-          // If upper model is better than lower model then call backward
-        SwitchBackwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Link, Dist, &UpperModel, BestModels, 
-                                BestMetrics, numchecked, indices, tol, maxit, j - 1, pen, 
-                                Bounds.at(j - 1), &revNewOrder2, p, Metrics.at(j), cutoff);
-        }else{
-          // Creating new current model for next call to forward branch
-          arma::ivec CurModel2 = *CurModel;
-          CurModel2(revNewOrder2(j)) = 1;
+        // Each subtree is searched as a separate task, the upper model is copied 
+        // since it is changed by the next iteration
+#pragma omp task default(shared) firstprivate(j, UpperModel)
+        {
+          if(Metrics.at(j) > Metrics2.at(j - 1)){
+            // If upper model is better than lower model then call backward
+          SwitchBackwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Family, &UpperModel, BestModels, 
+                                  BestMetrics, numchecked, indices, tol, maxit, j - 1, pen, 
+                                  Bounds.at(j - 1), &revNewOrder2, p, Metrics.at(j), cutoff, Chol, Workspaces, 
+                                  Frontier);
+          }else{
+            // Creating new current model for next call to forward branch
+            arma::ivec CurModel2 = *CurModel;
+            CurModel2(revNewOrder2(j)) = 1;
           
-          // If lower model is better than upper model then call forward
-          SwitchForwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Link, Dist, &CurModel2, BestModels, 
-                                  BestMetrics, numchecked, indices, tol, maxit, NewOrder2.n_elem - j, pen, 
-                                  Bounds.at(j - 1), &NewOrder2, p, Metrics2.at(j - 1), cutoff);
+            // If lower model is better than upper model then call forward
+            SwitchForwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Family, &CurModel2, BestModels, 
+                                    BestMetrics, numchecked, indices, tol, maxit, NewOrder2.n_elem - j, pen, 
+                                    Bounds.at(j - 1), &NewOrder2, p, Metrics2.at(j - 1), cutoff, Chol, Workspaces, 
+                                    Frontier);
+          }
         }
       }
+#pragma omp taskwait
     }
   }
   else{
@@ -721,26 +1443,32 @@ void SwitchForwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::
 
 
 // Function used to performing branching for branch and bound method
-void SwitchBackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+template<typename T>
+void SwitchBackwardBranch(const T* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
                        const arma::imat* Interactions,
-                       std::string method, int m, std::string Link, std::string Dist,
+                       std::string method, int m, GLMFamily Family,
                        arma::ivec* CurModel, arma::mat* BestModels, arma::vec* BestMetrics, 
-                       unsigned int* numchecked, arma::ivec* indices, double tol, 
+                       unsigned long long* numchecked, arma::ivec* indices, double tol, 
                        int maxit, unsigned int cur, const arma::vec* pen, 
                        double LowerBound, arma::uvec* NewOrder, Progress* p, 
-                       double LowerMetric, double cutoff){
+                       double LowerMetric, double cutoff, const LinRegChol* Chol, 
+                       std::vector<GLMWorkspace>* Workspaces, SearchFrontier* Frontier){
+  
+  // Adding this node to the queue instead of expanding it when the search is 
+  // suspended for a checkpoint
+  if(Frontier != nullptr && Frontier->Suspend()){
+    Frontier->Add(MakeNode(CurModel, NewOrder, cur, 0, LowerBound, nullptr, false, 
+                           LowerMetric));
+    return;
+  }
   
   // Checking for user interrupt
-  checkUserInterrupt();
+  if(p->interrupted()){
+    return;
+  }
   
   // Getting metric value used to cutoff branches
-  double metricCutoff;
-  if(cutoff == -1){
-    metricCutoff = BestMetrics->at(BestMetrics->n_elem - 1);
-  }
-  else{
-    metricCutoff = BestMetrics->at(0) + cutoff;
-  }
+  double metricCutoff = GetMetricCutoff(BestMetrics, cutoff);
   
   // Continuing branching process if lower bound is smaller than the best observed metric
   if(LowerBound < metricCutoff){
@@ -752,10 +1480,10 @@ void SwitchBackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma:
     arma::uvec NewOrder2(cur + 1);
     arma::vec Metrics(cur + 1);
     arma::uvec Counts(cur + 1, arma::fill::zeros);
-    arma::mat NewModels(X->n_cols, NewOrder2.n_elem, arma::fill::zeros);
+    arma::mat NewModels(X->n_cols + CurModel->n_elem, NewOrder2.n_elem, arma::fill::zeros);
     
     // Getting metric values
-#pragma omp parallel for schedule(dynamic) 
+#pragma omp taskloop default(shared) grainsize(1)
     for(unsigned int j = 0; j < NewOrder2.n_elem; j++){
       arma::ivec CurModel2 = *CurModel;
       CurModel2(NewOrder->at(j)) = 0;
@@ -763,9 +1491,14 @@ void SwitchBackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma:
       if(CheckModel(&CurModel2, Interactions)){
         // Only fitting model if it is valid
         Counts.at(j) = 1;
-        Metrics(j) = MetricHelper(X, XTWX, Y, Offset, indices, &CurModel2,
-                   method, m, Link, Dist, 
-                   tol, maxit, pen, j, &NewModels);
+        SetIndicators(&NewModels, &CurModel2, j);
+        if(Chol != nullptr){
+          Metrics(j) = LinRegMetricHelper(Chol, indices, &CurModel2, pen, j, &NewModels);
+        }else{
+          Metrics(j) = MetricHelper(X, XTWX, Y, Offset, indices, &CurModel2,
+                     method, m, Family, 
+                     tol, maxit, pen, j, &NewModels, nullptr, GetWorkspace(Workspaces));
+        }
       }
       else{
         // Assigning infinity to metric value if model is not valid
@@ -779,24 +1512,22 @@ void SwitchBackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma:
     UpdateBestMetrics(BestModels, BestMetrics, &NewModels, &Metrics, cutoff);
     
     // Getting metric value used to cutoff branches
-    if(cutoff == -1){
-      metricCutoff = BestMetrics->at(BestMetrics->n_elem - 1);
-    }
-    else{
-      metricCutoff = BestMetrics->at(0) + cutoff;
-    }
+    metricCutoff = GetMetricCutoff(BestMetrics, cutoff);
     
     // Updating best metrics must be done before sorting
     Metrics = Metrics(sorted);
     
-    // Checking for user interrupt
-    checkUserInterrupt();
+    // Checking for user interrupt, when the search is checkpointed the node is 
+    // finished so none of its models are lost
+    if(p->interrupted() && Frontier == nullptr){
+      return;
+    }
     
     // Defining Bounds to store the lower bounds
     arma::vec Bounds(Metrics.n_elem - 1);
     
   // Computing lower bounds
-#pragma omp parallel for schedule(dynamic)
+#pragma omp taskloop default(shared) grainsize(1)
     for(unsigned int j = 1; j < NewOrder2.n_elem; j++){
       arma::ivec CurModel2 = *CurModel;
       CurModel2(NewOrder2(j)) = 0;
@@ -806,11 +1537,15 @@ void SwitchBackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma:
           // Fitting model for upper bound since it wasn't fit earlier
           // Only done when the upper model isn't valid, but the set is valid
           Counts.at(j - 1) = 1;
-          Metrics(j) = MetricHelper(X, XTWX, Y, Offset, indices, &CurModel2,
-                  method, m, Link, Dist, tol, maxit, pen, j, &NewModels);
+          if(Chol != nullptr){
+            Metrics(j) = LinRegMetricHelper(Chol, indices, &CurModel2, pen, j, &NewModels);
+          }else{
+            Metrics(j) = MetricHelper(X, XTWX, Y, Offset, indices, &CurModel2,
+                    method, m, Family, tol, maxit, pen, j, &NewModels, nullptr, GetWorkspace(Workspaces));
+          }
         }
         if(!std::isinf(Metrics.at(j))){
-          Bounds(j - 1) = BackwardGetBound(X, indices, &CurModel2, &NewOrder2, 
+          Bounds(j - 1) = BackwardGetBound(indices, &CurModel2, &NewOrder2, 
                  j, Metrics(j), pen);
         }else{
           Bounds(j - 1) = LowerBound;
@@ -823,10 +1558,14 @@ void SwitchBackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma:
     }
     
     // Updating numchecked
+#pragma omp atomic
     (*numchecked) += arma::accu(Counts);
     
-    // Checking for user interrupt
-    checkUserInterrupt();
+    // Checking for user interrupt, when the search is checkpointed the node is 
+    // finished so none of its models are lost
+    if(p->interrupted() && Frontier == nullptr){
+      return;
+    }
     
     // Defining lower model for switch
     arma::uvec revNewOrder2 = reverse(NewOrder2);
@@ -844,10 +1583,10 @@ void SwitchBackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma:
       arma::vec Lower(Bounds.n_elem);
       Lower.fill(arma::datum::inf);
       arma::uvec Counts2(Bounds.n_elem, arma::fill::zeros);
-      arma::mat NewModels(X->n_cols, Bounds.n_elem, arma::fill::zeros);
+      arma::mat NewModels(X->n_cols + CurModel->n_elem, Bounds.n_elem, arma::fill::zeros);
       
       // Fitting lower models
-#pragma omp parallel for schedule(dynamic)
+#pragma omp taskloop default(shared) grainsize(1)
       for(int j = revNewOrder2.n_elem - 2; j >= 0; j--){
         if(j > 0 && Bounds.at(j) < metricCutoff){
           // Getting lower model
@@ -859,9 +1598,14 @@ void SwitchBackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma:
           if(CheckModel(&NewLowerModel, Interactions)){
             // Only fitting model if it is valid
             Counts2.at(j) = 1;
-            Lower.at(j) = MetricHelper(X, XTWX, Y, Offset, indices, &NewLowerModel,
-                                         method, m, Link, Dist, 
-                                         tol, maxit, pen, j, &NewModels);
+            SetIndicators(&NewModels, &NewLowerModel, j);
+            if(Chol != nullptr){
+              Lower.at(j) = LinRegMetricHelper(Chol, indices, &NewLowerModel, pen, j, &NewModels);
+            }else{
+              Lower.at(j) = MetricHelper(X, XTWX, Y, Offset, indices, &NewLowerModel,
+                                           method, m, Family, 
+                                           tol, maxit, pen, j, &NewModels, nullptr, GetWorkspace(Workspaces));
+            }
           }
           
           // Tightening lower bound since we fit lower model
@@ -870,6 +1614,7 @@ void SwitchBackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma:
       }
       
       // Updating numchecked
+#pragma omp atomic
       (*numchecked) += arma::accu(Counts2);
       
       // Checking if we need to update bounds
@@ -884,24 +1629,32 @@ void SwitchBackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma:
           // Updating lower model for current iteration
           LowerModel(revNewOrder2(j)) = 0;
           
-          if(Metrics.at(j) > Lower.at(j)){
-            // If Lower model has better metric value than upper model use forward
-          SwitchForwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Link, Dist, &LowerModel, BestModels, 
-                            BestMetrics, numchecked, indices, tol, maxit, j + 1, pen, 
-                            Bounds.at(j), &revNewOrder2, p, Metrics.at(j), cutoff);
-          }
-          else{
-            // Creating new CurModel for next set of models
-            arma::ivec CurModel2 = *CurModel;
-            CurModel2.at(revNewOrder2.at(j)) = 0;
+          // Each subtree is searched as a separate task, the lower model is copied 
+          // since it is changed by the next iteration
+#pragma omp task default(shared) firstprivate(j, LowerModel)
+          {
+            if(Metrics.at(j) > Lower.at(j)){
+              // If Lower model has better metric value than upper model use forward
+            SwitchForwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Family, &LowerModel, BestModels, 
+                              BestMetrics, numchecked, indices, tol, maxit, j + 1, pen, 
+                              Bounds.at(j), &revNewOrder2, p, Metrics.at(j), cutoff, Chol, Workspaces, 
+                              Frontier);
+            }
+            else{
+              // Creating new CurModel for next set of models
+              arma::ivec CurModel2 = *CurModel;
+              CurModel2.at(revNewOrder2.at(j)) = 0;
             
-            // If upper model has better metric value than lower model use backward
-            SwitchBackwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Link, Dist, &CurModel2, BestModels, 
-                                   BestMetrics, numchecked, indices, tol, maxit, 
-                                   revNewOrder2.n_elem - 2 - j, pen, 
-                                   Bounds.at(j), &NewOrder2, p, Lower.at(j), cutoff);
+              // If upper model has better metric value than lower model use backward
+              SwitchBackwardBranch(X, XTWX, Y, Offset, Interactions, method, m, Family, &CurModel2, BestModels, 
+                                     BestMetrics, numchecked, indices, tol, maxit, 
+                                     revNewOrder2.n_elem - 2 - j, pen, 
+                                     Bounds.at(j), &NewOrder2, p, Lower.at(j), cutoff, Chol, Workspaces, 
+                                     Frontier);
+            }
           }
         }
+#pragma omp taskwait
       }
     }
   }
@@ -914,25 +1667,28 @@ void SwitchBackwardBranch(const arma::mat* X, const arma::mat* XTWX, const arma:
 
 
 // Switch Branch and bound method
-// [[Rcpp::export]]
-List SwitchBranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector offset, 
-                             IntegerVector indices, IntegerVector num,
-                             IntegerMatrix interactions,
-                             std::string method, int m,
-                             std::string Link, std::string Dist,
-                             unsigned int nthreads, double tol, int maxit, 
-                             IntegerVector keep, NumericVector pen,
-                             bool display_progress, unsigned int NumBest, 
-                             double cutoff){
+template<typename T>
+List SwitchBranchAndBoundHelper(const T* X, NumericVector y, NumericVector offset, 
+                                IntegerVector indices, IntegerVector num,
+                                IntegerMatrix interactions,
+                                std::string method, int m,
+                                std::string Link, std::string Dist,
+                                unsigned int nthreads, double tol, int maxit, 
+                                IntegerVector keep, NumericVector pen,
+                                bool display_progress, unsigned int NumBest, 
+                                double cutoff, std::string checkpoint, double interval, 
+                                bool resume){
+  
+  // Getting family and link used by the fitting functions
+  const GLMFamily Family = GetFamily(Dist, Link);
   
   // Creating necessary vectors/matrices
-  const arma::mat X(x.begin(), x.rows(), x.cols(), false, true);
   const arma::vec Y(y.begin(), y.size(), false, true);
   const arma::vec Offset(offset.begin(), offset.size(), false, true);
   const arma::vec Pen(pen.begin(), pen.size(), false, true);
   const arma::imat Interactions(interactions.begin(), interactions.rows(), 
                                 interactions.cols(), false, true);
-  arma::mat BestModels(X.n_cols, NumBest, arma::fill::zeros);
+  arma::mat BestModels(X->n_cols + keep.size(), NumBest, arma::fill::zeros);
   arma::vec BestMetrics(NumBest);
   BestMetrics.fill(arma::datum::inf);
   arma::ivec Indices(indices.begin(), indices.size(), false, true);
@@ -940,17 +1696,24 @@ List SwitchBranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector off
   CurModel.replace(1, 0);
   
   
+  // Setting number of threads used to fit the candidate models
+  ThreadScope Threads(ChooseThreads(X->n_rows, X->n_cols, num.size(), nthreads));
+  
   // Getting X'WX
-  arma::mat XTWX = X.t() * X;
+  arma::mat XTWX = ParGramCpp(X);
+  
+  // Getting X'y and y'y, linear regression models are found from these and X'X 
+  // so X is only used to fit the other families
+  const LinRegCross Cross = GetLinRegCross(X, &XTWX, &Y, &Offset, Family);
+  LinRegChol Chol(&XTWX, &Cross, X->n_rows);
+  const LinRegChol* Base = IsLinReg(Family) ? &Chol : nullptr;
   
   // Creating necessary scalars
-  unsigned int numchecked = 0;
+  unsigned long long numchecked = 0;
   unsigned int size = 0;
   
-  // Changing number of threads if OpenMP is available
-#ifdef _OPENMP
-  omp_set_num_threads(nthreads);
-#endif
+  // Creating workspaces used to fit models for each thread
+  std::vector<GLMWorkspace> Workspaces = MakeWorkspaces(X->n_rows, X->n_cols);
   
   // Getting size of model space to check
   for(unsigned int j = 0; j < CurModel.n_elem; j++){
@@ -960,7 +1723,7 @@ List SwitchBranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector off
   }
   
   // Creating object to report progress
-  Progress p(GetNum(size, size), display_progress);
+  Progress p(GetNum(size, size), display_progress, &numchecked);
   p.print();
   
   
@@ -976,74 +1739,151 @@ List SwitchBranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector off
   // Checking for user interrupt
   checkUserInterrupt();
   
-  // Fitting lower model
-  arma::mat betaMat(X.n_cols, 1, arma::fill::zeros);
-  double CurMetric = MetricHelper(&X, &XTWX, &Y, &Offset, &Indices, 
-                                       &CurModel, method, m, Link, Dist, 
-                                       tol, maxit, &Pen, 0, &betaMat);
-  
-  // Updating BestMetric and BestModel if CurMetric is better than BestMetric
-  if(CurMetric < BestMetrics.at(0)){
-    BestMetrics.at(0) = CurMetric;
-    BestModels.col(0) = betaMat.col(0);
-  }
-  
-  // Incrementing numchecked  
-  numchecked++;
-  
-  // Finding initial lower bound
-  double LowerBound = -arma::datum::inf;
-  arma::vec Metrics(1);
-  Metrics.at(0) = arma::datum::inf;
-  LowerBound = GetBound(&X, &XTWX, &Y, &Offset, method, m, Link, Dist, &CurModel,
-                           &Indices, tol, maxit, &Pen, 
-                           0, &NewOrder, LowerBound, 
-                           &Metrics, &betaMat, true) + min(Pen);
-  // Defining Upper model
-  arma::ivec UpperModel = CurModel;
-  for(unsigned int i = 0; i < NewOrder.n_elem; i++){
-    UpperModel.at(NewOrder.at(i)) = 1;
-  }
-  
-  // Updating BestMetric and BestModel if metric from upper model is better than BestMetric
-  UpdateBestMetrics(&BestModels, &BestMetrics, &betaMat, &Metrics, cutoff);
-  
-  // Incrementing numchecked
-  numchecked++;
-  
-  // Starting branching process
-  if(Metrics.at(0) < CurMetric && NewOrder.n_elem > 1){
-    // Branching forward if lower model has better metric value than upper model
-    SwitchForwardBranch(&X, &XTWX, &Y, &Offset, &Interactions, method, m, Link, Dist, &CurModel, &BestModels, 
-            &BestMetrics, &numchecked, &Indices, tol, maxit, 0, &Pen, 
-            LowerBound, &NewOrder, &p, Metrics.at(0), cutoff);
-  }else if(NewOrder.n_elem > 1){
-    // Branching backward if upper model has better metric value than lower model
+  // Open nodes that are written to checkpoint files
+  NodeQueue Queue;
+  SearchFrontier Frontier(&Queue, interval, &p);
+  SearchFrontier* Frontier1 = checkpoint.empty() ? nullptr : &Frontier;
+  uint64_t key = SearchKey(&Y, &Offset, X->n_cols, Dist, Link, "switch");
+  
+  if(resume){
+    // Reading the state of the search from the checkpoint file instead of 
+    // starting from the lower and upper models
+    LoadCheckpoint(checkpoint, &Queue, &BestModels, &BestMetrics, &numchecked, &p, 
+                   &Pen, cutoff, key);
+  }else{
+    // Fitting lower model
+    arma::mat betaMat(X->n_cols + CurModel.n_elem, 1, arma::fill::zeros);
+    double CurMetric;
+    if(Base != nullptr){
+      CurMetric = LinRegMetricHelper(Base, &Indices, &CurModel, &Pen, 0, &betaMat);
+    }else{
+      CurMetric = MetricHelper(X, &XTWX, &Y, &Offset, &Indices, 
+                               &CurModel, method, m, Family, 
+                               tol, maxit, &Pen, 0, &betaMat, nullptr, GetWorkspace(&Workspaces));
+    }
+    SetIndicators(&betaMat, &CurModel, 0);
+    
+    // Updating BestMetric and BestModel if CurMetric is better than BestMetric
+    if(CurMetric < BestMetrics.at(0)){
+      BestMetrics.at(0) = CurMetric;
+      BestModels.col(0) = betaMat.col(0);
+    }
+    
+    // Incrementing numchecked  
+    numchecked++;
+    
+    // Finding initial lower bound
+    double LowerBound = -arma::datum::inf;
+    arma::vec Metrics(1);
+    Metrics.at(0) = arma::datum::inf;
+    LowerBound = GetBound(X, &XTWX, &Y, &Offset, method, m, Family, &CurModel,
+                          &Indices, tol, maxit, &Pen, 
+                          0, &NewOrder, LowerBound, 
+                          &Metrics, &betaMat, nullptr, Base, GetWorkspace(&Workspaces), true) + min(Pen);
+    // Defining Upper model
     arma::ivec UpperModel = CurModel;
     for(unsigned int i = 0; i < NewOrder.n_elem; i++){
       UpperModel.at(NewOrder.at(i)) = 1;
     }
+    SetIndicators(&betaMat, &UpperModel, 0);
     
-    SwitchBackwardBranch(&X, &XTWX, &Y, &Offset, &Interactions, method, m, Link, Dist, &UpperModel, &BestModels, 
-                           &BestMetrics, &numchecked, &Indices, tol, maxit, NewOrder.n_elem - 1, &Pen, 
-                           LowerBound, &NewOrder, &p, CurMetric, cutoff);
-  }else{
-    p.update(2);
+    // Updating BestMetric and BestModel if metric from upper model is better than BestMetric
+    UpdateBestMetrics(&BestModels, &BestMetrics, &betaMat, &Metrics, cutoff);
+    
+    // Incrementing numchecked
+    numchecked++;
+    
+    if(Metrics.at(0) < CurMetric && NewOrder.n_elem > 1){
+      // Branching forward if lower model has better metric value than upper model
+      Queue.push(MakeNode(&CurModel, &NewOrder, 0, 0, LowerBound, nullptr, true, 
+                          Metrics.at(0)));
+    }else if(NewOrder.n_elem > 1){
+      // Branching backward if upper model has better metric value than lower model
+      Queue.push(MakeNode(&UpperModel, &NewOrder, NewOrder.n_elem - 1, 0, LowerBound, 
+                          nullptr, false, CurMetric));
+    }else{
+      p.update(2);
+    }
+  }
+  
+  // Starting branching process, the tree is searched with tasks
+  // that are run by a team of threads
+  bool failed = false;
+  SearchNodes(X, &XTWX, &Y, &Offset, &Interactions, method, m, Family, 
+              &BestModels, &BestMetrics, &numchecked, &Indices, tol, maxit, 
+              &Pen, &p, cutoff, true, Base, &Workspaces, &Queue, Frontier1, 
+              checkpoint, key, &failed, nullptr);
+  
+  // Warning if the checkpoint file couldn't be written
+  if(failed){
+    warning("the checkpoint file could not be written");
+  }
+  
+  // Stopping if the user interrupted the search
+  if(p.interrupted()){
+    throw Rcpp::internal::InterruptedException();
   }
   
   // Printing off final update
   p.finalprint();
   
-  List FinalList = List::create(Named("bestmodels") = BestModels,
-                                Named("numchecked") = numchecked,
+  List FinalList = List::create(Named("bestmodels") = arma::mat(BestModels.rows(0, X->n_cols - 1)),
+                                Named("bestindicators") = 
+                                  arma::mat(BestModels.rows(X->n_cols, BestModels.n_rows - 1)),
+                                Named("numchecked") = (double)numchecked,
                                 Named("bestmetrics") = BestMetrics);
   
-  // Resetting number of threads if OpenMP is defined
-#ifdef _OPENMP
-  omp_set_num_threads(1);
-#endif
-  
   return(FinalList);
 }
 
+// Switch branch and bound method, x is either a numeric matrix or a dgCMatrix
+// If float32 is true, then the search uses a single precision copy of a dense x 
+// and the best models are refit with x
+// [[Rcpp::export]]
+List SwitchBranchAndBoundCpp(SEXP x, NumericVector y, NumericVector offset, 
+                             IntegerVector indices, IntegerVector num,
+                             IntegerMatrix interactions,
+                             std::string method, int m,
+                             std::string Link, std::string Dist,
+                             unsigned int nthreads, double tol, int maxit, 
+                             IntegerVector keep, NumericVector pen,
+                             bool display_progress, unsigned int NumBest, 
+                             double cutoff, std::string checkpoint, double interval, 
+                             bool resume, bool float32){
+  
+  // Sparse design matrices are dgCMatrix objects, these are kept in CSC form
+  if(Rf_isS4(x)){
+    const arma::sp_mat X = as<arma::sp_mat>(x);
+    return(SwitchBranchAndBoundHelper(&X, y, offset, indices, num, interactions, method,
+                                      m, Link, Dist, nthreads, tol, maxit, keep, pen,
+                                      display_progress, NumBest, cutoff, checkpoint, 
+                                      interval, resume));
+  }
+  // Dense design matrices are either numeric matrices or mapped design files
+  const DenseDesign X(x);
+  if(float32){
+    // The single precision copy is held in memory along with x, so mapped 
+    // design files which may not fit in memory can't be used
+    if(TYPEOF(x) == EXTPTRSXP){
+      stop("float32 can't be used with mapped design matrices");
+    }
+    
+    // The copy is freed before the best models are refit with x
+    List Search;
+    {
+      const arma::fmat XF = arma::conv_to<arma::fmat>::from(*X.get());
+      Search = SwitchBranchAndBoundHelper(&XF, y, offset, indices, num, interactions, 
+                                          method, m, Link, Dist, nthreads, tol, maxit, keep,
+                                          pen, display_progress, NumBest, cutoff, checkpoint,
+                                          interval, resume);
+    }
+    return(RefitBestModels(X.get(), Search, y, offset, indices, method, m, Link, Dist, 
+                           nthreads, tol, maxit, pen, cutoff));
+  }
+  return(SwitchBranchAndBoundHelper(X.get(), y, offset, indices, num, interactions, method,
+                                    m, Link, Dist, nthreads, tol, maxit, keep, pen,
+                                    display_progress, NumBest, cutoff, checkpoint, 
+                                    interval, resume));
+}
+
 
@@ -1,5 +1,9 @@
 #include <RcppArmadillo.h>
 #include "CrossProducts.h"
+#include "GLMFamily.h"
+#include "ChunkedMatrix.h"
+#include "MappedMatrix.h"
+#include "ThreadPolicy.h"
 #include <cmath>
 #include <boost/math/special_functions/digamma.hpp>
 #include <boost/math/special_functions/trigamma.hpp>
@@ -26,206 +30,175 @@ double LogFact(const arma::vec* y){
   return(sum);
 }
 
-// Checking bounds and modifying values that are out of bounds
-void CheckBounds(arma::vec* mu, std::string Dist){
-  
-  if(Dist == "binomial"){
-    mu->transform([](double val){
-      if(val <= 0){val = FLT_EPSILON;}
-      else if(val >= 1) {val = 1 - FLT_EPSILON;}
-      return(val);
-    });
+// Calculates linear predictors
+void LinPredCpp(const arma::mat* X, const arma::vec* beta, const arma::vec* Offset, 
+                arma::vec* eta){
+  *eta = *Offset;
+  *eta += *X * *beta;
+}
+
+void LinPredCpp(const ChunkedMatrix* X, const arma::vec* beta, const arma::vec* Offset, 
+                arma::vec* eta){
+  X->LinPred(beta, Offset, eta);
+}
+
+void LinPredCpp(const arma::sp_mat* X, const arma::vec* beta, const arma::vec* Offset, 
+                arma::vec* eta){
+  *eta = *Offset;
+  *eta += *X * *beta;
+}
+
+// Calculates X'v
+arma::vec CrossProdCpp(const arma::mat* X, const arma::vec* v){
+  return(X->t() * *v);
+}
+
+arma::vec CrossProdCpp(const ChunkedMatrix* X, const arma::vec* v){
+  return(X->XTr(v));
+}
+
+arma::vec CrossProdCpp(const arma::sp_mat* X, const arma::vec* v){
+  arma::vec FinalVec(X->n_cols);
+  CrossProdCpp(X, v, &FinalVec);
+  return(FinalVec);
+}
+
+// Versions that write X'v into out, so repeated products don't allocate memory 
+// for dense and sparse design matrices
+void CrossProdCpp(const arma::mat* X, const arma::vec* v, arma::vec* out){
+  *out = X->t() * *v;
+}
+
+void CrossProdCpp(const ChunkedMatrix* X, const arma::vec* v, arma::vec* out){
+  *out = X->XTr(v);
+}
+
+// Only the nonzero elements of each column of X are used
+void CrossProdCpp(const arma::sp_mat* X, const arma::vec* v, arma::vec* out){
+  
+#pragma omp parallel for schedule(dynamic, 64) if(DataParallel(X->n_nonzero))
+  for(unsigned int j = 0; j < X->n_cols; j++){
+    double temp = 0;
+    for(arma::uword k = X->col_ptrs[j]; k < X->col_ptrs[j + 1]; k++){
+      temp += X->values[k] * v->at(X->row_indices[k]);
+    }
+    out->at(j) = temp;
   }
-  else if(Dist == "poisson" || Dist == "gamma"){
-    mu->transform([](double val){
-      if(val <= 0){val = FLT_EPSILON;}
-      return(val);
-    });
+}
+
+// Calculates X'X
+arma::mat GramCpp(const arma::mat* X, unsigned int nthreads){
+  if(nthreads > 1){
+    return(ParXTX(X));
   }
+  return(XTX(X, 16));
+}
+
+arma::mat GramCpp(const ChunkedMatrix* X, unsigned int nthreads){
+  arma::vec w(X->n_rows, arma::fill::ones);
+  return(X->WeightedXTX(&w));
+}
+
+arma::mat GramCpp(const arma::sp_mat* X, unsigned int nthreads){
+  arma::vec w(X->n_rows, arma::fill::ones);
+  return(WeightedXTX(X, &w));
 }
 
 // Defining Link functions
-arma::vec LinkCpp(const arma::mat* X, arma::vec* beta, const arma::vec* Offset, 
-                  std::string Link, std::string Dist){
+template<typename T>
+arma::vec LinkCpp(const T* X, arma::vec* beta, const arma::vec* Offset, 
+                  GLMFamily Family){
   
   // Calculating linear predictors and initializing vector for mu
-  arma::vec XBeta = (*X * *beta) + *Offset;
+  arma::vec XBeta(X->n_rows);
+  LinPredCpp(X, beta, Offset, &XBeta);
   arma::vec mu(XBeta.n_elem);
   
-  // Calculating mu
-  if(Link == "log"){
-#pragma omp parallel for
-    for(unsigned int i = 0; i < Offset->n_elem; i++){
-      mu.at(i) = exp(XBeta.at(i));
-    }
-  }
-  else if(Link == "logit"){
-#pragma omp parallel for
-    for(unsigned int i = 0; i < Offset->n_elem; i++){
-      mu.at(i) = 1 / (1 + exp(-XBeta.at(i)));
-    }
-  }
-  else if(Link == "probit"){
-    mu = arma::normcdf(XBeta);
-  }
-  else if(Link == "cloglog"){
-#pragma omp parallel for
-    for(unsigned int i = 0; i < Offset->n_elem; i++){
-      mu.at(i) = 1 - exp(-exp(XBeta.at(i)));
-    }
-  }
-  else if(Link == "inverse"){
-#pragma omp parallel for
-    for(unsigned int i = 0; i < Offset->n_elem; i++){
-      mu.at(i) = 1 / (XBeta.at(i));
-    }
-  }
-  else if(Link == "identity"){
-    mu = XBeta;
-  }
-  else if(Link == "sqrt"){
-#pragma omp parallel for
-    for(unsigned int i = 0; i < Offset->n_elem; i++){
-      mu.at(i) = pow(XBeta.at(i), 2);
-    }
-  }
-  
-  // Checking bounds and modifying values that are out of bounds
-  CheckBounds(&mu, Dist);
+  // Calculating mu and checking bounds for mu
+  FamilyDispatch<MuKernel>(Family, &XBeta, &mu, DataParallel(mu.n_elem));
   
   return(mu);
 }
 
 // Defining Derivative functions for each link function
-arma::vec DerivativeCpp(const arma::mat* X, arma::vec* beta, const arma::vec* Offset,
-                        arma::vec* mu, std::string Link, std::string Dist){
+template<typename T>
+arma::vec DerivativeCpp(const T* X, arma::vec* beta, const arma::vec* Offset,
+                        arma::vec* mu, GLMFamily Family){
   
   // Initializing vector to store derivative
   arma::vec Deriv(mu->n_elem);
   
-  // Calculating derivative
-  if(Link == "log"){
-    Deriv = *mu; 
+  // Calculating derivative, linear predictors are only needed for probit
+  if(Family.Link == GLMLink::probit){
+    arma::vec XBeta(X->n_rows);
+    LinPredCpp(X, beta, Offset, &XBeta);
+    FamilyDispatch<DerivKernel>(Family, &XBeta, mu, &Deriv, DataParallel(mu->n_elem));
   }
-  else if(Link == "logit"){
-#pragma omp parallel for
-    for(unsigned int i = 0; i < mu->n_elem; i++){
-      Deriv.at(i) = mu->at(i) * (1 - mu->at(i));
-    }
-  }
-  else if(Link == "probit"){
-    Deriv = arma::normpdf(*X * *beta + *Offset);
-  }
-  else if(Link == "cloglog"){
-#pragma omp parallel for
-    for(unsigned int i = 0; i < mu->n_elem; i++){
-      Deriv.at(i) = -(1 - mu->at(i)) * log(1 - mu->at(i));
-    }
-  }
-  else if(Link == "inverse"){
-#pragma omp parallel for
-    for(unsigned int i = 0; i < mu->n_elem; i++){
-      Deriv.at(i) = -pow(mu->at(i), 2);
-    }
-  }
-  else if(Link == "identity"){
-    Deriv.fill(1);
-  }else if(Link == "sqrt"){
-#pragma omp parallel for
-    for(unsigned int i = 0; i < mu->n_elem; i++){
-      Deriv.at(i) = 2 * sqrt(mu->at(i));
-    }
+  else{
+    FamilyDispatch<DerivKernel>(Family, mu, mu, &Deriv, DataParallel(mu->n_elem));
   }
   
   return(Deriv);
 }
 
 // Defining Variance functions for each family
-arma::vec Variance(arma::vec* mu, std::string Dist){
+arma::vec Variance(arma::vec* mu, GLMFamily Family){
   
   // Initializing vector to store variance
   arma::vec Var(mu->n_elem);
   
-  
-  // Calculating variance
-  if(Dist == "poisson"){
-    Var = *mu; 
-  }
-  else if(Dist == "binomial"){
-#pragma omp parallel for
-    for(unsigned int i = 0; i < mu->n_elem; i++){
-      Var.at(i) = mu->at(i) * (1 - mu->at(i));
-    }
-  }
-  else if(Dist == "gamma"){
-#pragma omp parallel for
-    for(unsigned int i = 0; i < mu->n_elem; i++){
-      Var.at(i) = pow(mu->at(i), 2);
-    }
-  }
-  else{
-    Var.fill(1);
-  }
-  
-  // Replacing zeros with FLT_epsilon
-  Var.replace(0, FLT_EPSILON);
+  // Calculating variance, zeros are replaced with FLT_EPSILON
+  FamilyDispatch<VarKernel>(Family, mu, &Var, DataParallel(mu->n_elem));
   
   return(Var);
   
 }
 
 // Defining log likelihood function
-double LogLikelihoodCpp(const arma::mat* X, const arma::vec* Y, 
-                        arma::vec* mu, std::string Dist){
-  
-  // Initializing double to store log-likelihood
-  double LogLik = 0;
+double LogLikelihoodCpp(const arma::vec* Y, arma::vec* mu, GLMFamily Family){
   
   // Calculating log-likelihood
-  if(Dist == "poisson"){
-#pragma omp parallel for reduction(+:LogLik)
-    for(unsigned int i = 0; i < Y->n_elem; i++){
-      LogLik += -Y->at(i) * log(mu->at(i)) + mu->at(i);
-    }
-  }
-  else if(Dist == "binomial"){
-#pragma omp parallel for reduction(+:LogLik)
-    for(unsigned int i = 0; i < Y->n_elem; i++){
-      double theta = mu->at(i) / (1 - mu->at(i));
-      LogLik += -Y->at(i) * log(theta) + log1p(theta);
-    }
-  }else if(Dist == "gamma"){
-#pragma omp parallel for reduction(+:LogLik)
-    for(unsigned int i = 0; i < Y->n_elem; i++){
-      double theta = -1 / mu->at(i);
-      LogLik += -Y->at(i) * theta - log(-theta);
-    }
-  }else{
-#pragma omp parallel for reduction(+:LogLik)
-    for(unsigned int i = 0; i < Y->n_elem; i++){
-      LogLik += pow(Y->at(i) - mu->at(i), 2) /2;
-    }
-  }
-  return(LogLik);
+  return(FamilyDispatch<LogLikKernel>(Family, Y, mu, DataParallel(Y->n_elem)));
+}
+
+// Calculates mu, weights, score contributions, and log-likelihood in one pass 
+// from linear predictors that have already been calculated, eta and mu can be 
+// the same vector
+double IRLSEtaCpp(const arma::vec* eta, const arma::vec* Y, arma::vec* mu, 
+                  arma::vec* w, arma::vec* r, GLMFamily Family){
+  return(FamilyDispatch<IRLSKernel>(Family, eta, Y, mu, w, r, DataParallel(Y->n_elem)));
+}
+
+// Calculates mu, weights, score contributions, and log-likelihood in one pass
+template<typename T>
+double IRLSCpp(const T* X, const arma::vec* Y, const arma::vec* Offset, 
+               arma::vec* beta, arma::vec* mu, arma::vec* w, arma::vec* r, 
+               GLMFamily Family){
+  
+  // Calculating linear predictors in place, these are overwritten by mu
+  LinPredCpp(X, beta, Offset, mu);
+  
+  // Calculating mu, weights, score contributions, and log-likelihood
+  return(IRLSEtaCpp(mu, Y, mu, w, r, Family));
 }
 
 // Defining log likelihood for saturated model
-double LogLikelihoodSat(const arma::mat* X, const arma::vec* Y, std::string Dist){
+double LogLikelihoodSat(const arma::vec* Y, GLMFamily Family){
   
   // Initializing double to hold saturated log-likelihood
   double LogLik = 0;
   
   // Calculating saturated log-likelihood
-  if(Dist == "poisson"){
+  if(Family.Dist == GLMDist::poisson){
     for(unsigned int i = 0; i< Y->n_elem;i++){
       if(Y->at(i) != 0){
         LogLik += Y->at(i) * (log(Y->at(i)) - 1);
       }
     }
   }
-  else if(Dist == "binomial"){
+  else if(Family.Dist == GLMDist::binomial){
     LogLik = 0;
-  }else if(Dist == "gamma"){
+  }else if(Family.Dist == GLMDist::gamma){
     arma::vec theta = -1 / *Y;
     LogLik = arma::dot(*Y, theta) + arma::accu(log(-theta));
   }else{
@@ -235,61 +208,130 @@ double LogLikelihoodSat(const arma::mat* X, const arma::vec* Y, std::string Dist
   return(LogLik);
 }
 
-// Defining score function
-arma::vec ScoreCpp(const arma::mat* X, const arma::vec* Y, arma::vec* Deriv,
-                   arma::vec* Var, arma::vec* mu){
+// Calculates score from score contributions
+arma::vec WeightedScoreCpp(const arma::mat* X, const arma::vec* r){
   
   // Initializing vector for score
   arma::vec FinalVec(X->n_cols);
   
-  // Calculating w and diff for score computation
-  arma::vec w = *Deriv / *Var;
-  arma::vec diff = *Y - *mu;
-  w.replace(arma::datum::nan, 0);
-  
   // Calculating score
-#pragma omp parallel for
+#pragma omp parallel for if(DataParallel(X->n_rows))
   for(unsigned int i = 0; i < X->n_cols; i++){
     
-    FinalVec(i) = -arma::dot(X->col(i) % w, diff);
+    FinalVec(i) = -arma::dot(X->col(i), *r);
     
   }
   return FinalVec;
 }
 
+arma::vec WeightedScoreCpp(const ChunkedMatrix* X, const arma::vec* r){
+  return(-X->XTr(r));
+}
+
+arma::vec WeightedScoreCpp(const arma::sp_mat* X, const arma::vec* r){
+  return(-CrossProdCpp(X, r));
+}
+
+// Defining score function
+arma::vec ScoreCpp(const arma::mat* X, const arma::vec* Y, arma::vec* Deriv,
+                   arma::vec* Var, arma::vec* mu){
+  
+  // Calculating score contributions
+  arma::vec r = *Deriv / *Var;
+  r.replace(arma::datum::nan, 0);
+  r %= *Y - *mu;
+  
+  // Calculating score
+  return(WeightedScoreCpp(X, &r));
+}
+
+// Calculates X'WX from the diagonal of the W matrix
+arma::mat WeightedInfoCpp(const arma::mat* X, const arma::vec* w){
+  
+  checkUserInterrupt();
+  
+  // Calculating X'WX with blocked symmetric rank-k updates
+  return(WeightedXTX(X, w));
+}
+
+arma::mat WeightedInfoCpp(const ChunkedMatrix* X, const arma::vec* w){
+  
+  checkUserInterrupt();
+  
+  // Calculating X'WX one chunk at a time
+  return(X->WeightedXTX(w));
+}
+
+arma::mat WeightedInfoCpp(const arma::sp_mat* X, const arma::vec* w){
+  
+  checkUserInterrupt();
+  
+  // Calculating X'WX from the nonzero elements of each column
+  return(WeightedXTX(X, w));
+}
+
+// Calculates the diagonal of X'WX, this only takes O(np) so it can be used 
+// when X'WX is too expensive to form
+arma::vec WeightedInfoDiagCpp(const arma::mat* X, const arma::vec* w){
+  arma::vec d(X->n_cols);
+  for(unsigned int j = 0; j < X->n_cols; j++){
+    const double* xcol = X->colptr(j);
+    double temp = 0;
+    for(unsigned int i = 0; i < X->n_rows; i++){
+      temp += w->at(i) * xcol[i] * xcol[i];
+    }
+    d.at(j) = temp;
+  }
+  return(d);
+}
+
+arma::vec WeightedInfoDiagCpp(const ChunkedMatrix* X, const arma::vec* w){
+  
+  // Getting the diagonal one chunk at a time
+  arma::vec d(X->n_cols, arma::fill::zeros);
+  arma::mat Block;
+  for(unsigned int b = 0; b < X->n_chunks(); b++){
+    X->GetChunk(b, &Block);
+    unsigned int start = X->ChunkStart(b);
+    d += arma::square(Block).t() * w->subvec(start, start + X->ChunkRows(b) - 1);
+  }
+  return(d);
+}
+
+arma::vec WeightedInfoDiagCpp(const arma::sp_mat* X, const arma::vec* w){
+  
+  // Only the nonzero elements of each column are used
+  arma::vec d(X->n_cols);
+  for(unsigned int j = 0; j < X->n_cols; j++){
+    double temp = 0;
+    for(arma::uword k = X->col_ptrs[j]; k < X->col_ptrs[j + 1]; k++){
+      temp += w->at(X->row_indices[k]) * X->values[k] * X->values[k];
+    }
+    d.at(j) = temp;
+  }
+  return(d);
+}
+
 // Defining fisher information function
-arma::mat FisherInfoCpp(const arma::mat* X, arma::vec* Deriv, 
+template<typename T>
+arma::mat FisherInfoCpp(const T* X, arma::vec* Deriv, 
                         arma::vec* Var){
   
-  // Initializing matrix to store results
-  arma::mat FinalMat(X->n_cols, X->n_cols);
-  
   // Calculating weight vector, this is the diagonal of the W matrix
   arma::vec w = pow(*Deriv, 2) / *Var;
   w.replace(arma::datum::nan, 0);
-  checkUserInterrupt();
   
   // Calculating X'WX
-#pragma omp parallel for schedule(dynamic, 1)
-  for(unsigned int i = 0; i < X->n_cols; i++){
-    
-    FinalMat(i, i) = arma::dot((X->col(i) % w), X->col(i));
-    
-    for(unsigned int j = i + 1; j < X->n_cols; j++){
-      
-      FinalMat(i, j) = arma::dot((X->col(j) % w), X->col(i));
-      FinalMat(j, i) = FinalMat(i, j);
-      
-    } 
-  }
-  return FinalMat;
+  return(WeightedInfoCpp(X, &w));
 }
 
 // Function used to get step size
-void GetStepSize(const arma::mat* X, const arma::vec* Y, const arma::vec* Offset,
-                 arma::vec* mu, arma::vec* Deriv, arma::vec* Var, arma::vec* g1, 
+// eta holds the linear predictors for beta and is updated along with beta and mu
+template<typename T>
+void GetStepSize(const T* X, const arma::vec* Y, const arma::vec* Offset,
+                 arma::vec* mu, arma::vec* eta, arma::vec* w, arma::vec* r, arma::vec* g1, 
                  arma::vec* p, arma::vec* beta, 
-                 std::string Dist, std::string Link, 
+                 GLMFamily Family, 
                  double* f0, double* f1, double* t, double* alpha, 
                  std::string method){
   
@@ -309,12 +351,18 @@ void GetStepSize(const arma::mat* X, const arma::vec* Y, const arma::vec* Offset
   double temp = *alpha;
   double tempf1 = *f1;
   arma::vec tempbeta = *beta;
-  arma::vec tempmu = *mu;
+  arma::vec tempmu(mu->n_elem);
+  arma::vec tempeta(mu->n_elem);
+  arma::vec Xp(mu->n_elem);
   
   // Checking condition for initial alpha
+  // w and r are calculated along with mu and the log-likelihood for each step size
+  // X * p is found from the linear predictors for the full step, so the linear 
+  // predictors for each step halving are eta + temp * X * p and X is only used once
   tempbeta = *beta + temp * *p;
-  tempmu = LinkCpp(X, &tempbeta, Offset, Link, Dist);
-  tempf1 = LogLikelihoodCpp(X, Y, &tempmu, Dist);
+  LinPredCpp(X, &tempbeta, Offset, &tempeta);
+  Xp = tempeta - *eta;
+  tempf1 = IRLSEtaCpp(&tempeta, Y, &tempmu, w, r, Family);
   
   // Checking for descent direction
   if(*t <= 0){
@@ -331,9 +379,7 @@ void GetStepSize(const arma::mat* X, const arma::vec* Y, const arma::vec* Offset
       if(*f0 >= tempf1 + C1 * temp * *t){
         
         // Calculating stuff to check second strong wolfe condition
-        *Deriv = DerivativeCpp(X, &tempbeta, Offset, &tempmu, Link, Dist);
-        *Var = Variance(&tempmu, Dist);
-        *g1 = ScoreCpp(X, Y, Deriv, Var, &tempmu);
+        *g1 = WeightedScoreCpp(X, r);
         
         // Checking 2nd wolfe condition
         if(std::fabs(arma::dot(*p, *g1) <= C2 * std::fabs(*t))){
@@ -345,8 +391,8 @@ void GetStepSize(const arma::mat* X, const arma::vec* Y, const arma::vec* Offset
       if(k < maxiter - 1){
         temp /= 2;
         tempbeta = *beta + temp * *p;
-        tempmu = LinkCpp(X, &tempbeta, Offset, Link, Dist);
-        tempf1 = LogLikelihoodCpp(X, Y, &tempmu, Dist);
+        tempeta = *eta + temp * Xp;
+        tempf1 = IRLSEtaCpp(&tempeta, Y, &tempmu, w, r, Family);
       }
     }
     
@@ -355,7 +401,8 @@ void GetStepSize(const arma::mat* X, const arma::vec* Y, const arma::vec* Offset
     if(k < maxiter){
       *alpha = temp;
       *beta = tempbeta;
-      *mu = tempmu;
+      mu->swap(tempmu);
+      eta->swap(tempeta);
       *f1 = tempf1;
     }else if(k == maxiter){
       *alpha = 0;
@@ -367,65 +414,105 @@ void GetStepSize(const arma::mat* X, const arma::vec* Y, const arma::vec* Offset
   }
 }
 
-// LBFGS helper function
-arma::vec LBFGSHelperCpp(arma::vec* g1, arma::mat* s, arma::mat* y, 
-                         int* k, int* m, 
-                         arma::vec* r, arma::vec* alpha, const arma::mat* Info){
-  if(*k > 0){
-    unsigned int max = std::min(*k, *m);
-    unsigned int index;
-    
-    // Performing L-BFGS update
-    for(unsigned int i = 1; i <= max; i++){
-      index = (*k - i) % *m;
-      alpha->at(index) = arma::dot(s->col(index), *g1)/arma::dot(y->col(index), s->col(index));
-      *g1 -= alpha->at(index) * y->col(index);
-      
+// Performs the BFGS update of the approximate inverse hessian H in place
+// Since H is symmetric, (I - rho * s * y') * H * (I - rho * y * s') + rho * s * s' 
+// is H - rho * (s * Hy' + Hy * s') + (rho^2 * y'Hy + rho) * s * s', which only 
+// takes O(p^2) operations, Hy is used to store H * y
+void BFGSUpdateCpp(arma::mat* H, const arma::vec* s, const arma::vec* y, arma::vec* Hy){
+  double rho = 1 / arma::dot(*s, *y);
+  *Hy = *H * *y;
+  double c = rho * rho * arma::dot(*y, *Hy) + rho;
+  
+  // Only the rank-two correction is added to H, so no p x p temporaries are made
+  unsigned int p = H->n_rows;
+  for(unsigned int j = 0; j < p; j++){
+    double* Hcol = H->colptr(j);
+    double sj = s->at(j);
+    double Hyj = Hy->at(j);
+    for(unsigned int i = 0; i < p; i++){
+      Hcol[i] += c * s->at(i) * sj - rho * (s->at(i) * Hyj + Hy->at(i) * sj);
     }
-    index = (*k - 1)% *m;
-    *r = *Info * *g1;
-    //*r *= arma::dot(s->col(index), y->col(index)) / arma::dot(y->col(index), y->col(index));
-    
-    for(unsigned int j = max; j > 0; j--){
-      index = (*k - j) % *m;
-      *r += s->col(index) * (alpha->at(index) - arma::dot(y->col(index), *r)/arma::dot(y->col(index), s->col(index)));
+  }
+}
+
+// Gets the L-BFGS search direction -H * g in p with the two-loop recursion
+// s and y are a ring buffer of the last m steps and changes in the score, k is 
+// the number of pairs that were kept, the ith pair is in column i % m and rho 
+// holds 1 / y's for each pair
+// Diag holds the inverse of the diagonal of the fisher info, the initial inverse 
+// hessian is diag(Diag) for the first step and gamma * diag(Diag) after that with 
+// gamma = s'y / y'diag(Diag)y from the latest pair, so the full information 
+// matrix is never needed
+// q and alpha are used as workspace, so this does not allocate any memory
+void LBFGSDirectionCpp(const arma::vec* g, const arma::mat* s, const arma::mat* y, 
+                       const arma::vec* rho, int k, int m, const arma::vec* Diag, 
+                       arma::vec* q, arma::vec* alpha, arma::vec* p){
+  unsigned int max = std::min(k, m);
+  unsigned int index;
+  *q = *g;
+  
+  // Going from the newest pair to the oldest
+  for(unsigned int i = 1; i <= max; i++){
+    index = (k - i) % m;
+    alpha->at(index) = rho->at(index) * arma::dot(s->col(index), *q);
+    *q -= alpha->at(index) * y->col(index);
+  }
+  
+  // Applying initial inverse hessian
+  *p = *Diag % *q;
+  if(max > 0){
+    index = (k - 1) % m;
+    double yDy = 0;
+    for(unsigned int i = 0; i < q->n_elem; i++){
+      yDy += Diag->at(i) * y->at(i, index) * y->at(i, index);
     }
-    
-    return *r;
+    *p *= arma::dot(s->col(index), y->col(index)) / yDy;
   }
   
-  // Returns this if no prior gradients have been evaluated yet
-  return *Info * *g1;
+  // Going from the oldest pair to the newest
+  for(unsigned int j = max; j > 0; j--){
+    index = (k - j) % m;
+    *p += s->col(index) * (alpha->at(index) - rho->at(index) * arma::dot(y->col(index), *p));
+  }
+  *p *= -1;
 }
 
 // LBFGS
-int LBFGSGLMCpp(arma::vec* beta, const arma::mat* X, 
+template<typename T>
+int LBFGSGLMCpp(arma::vec* beta, const T* X, 
                 const arma::vec* Y, const arma::vec* Offset,
-                std::string Link, std::string Dist, 
+                GLMFamily Family, 
                 double tol, int maxit, int m){
   
   // Initializing vectors and matrices 
-  arma::vec mu = LinkCpp(X, beta, Offset, Link, Dist);
-  arma::vec Deriv = DerivativeCpp(X, beta, Offset, &mu, Link, Dist);
-  arma::vec Var = Variance(&mu, Dist);
+  arma::vec mu(X->n_rows);
+  arma::vec w(X->n_rows);
+  arma::vec r(X->n_rows);
+  arma::vec eta(X->n_rows);
+  LinPredCpp(X, beta, Offset, &eta);
+  double f1 = IRLSEtaCpp(&eta, Y, &mu, &w, &r, Family);
   arma::vec p(beta->n_elem);
   arma::vec g0(beta->n_elem);
-  arma::vec g1 = ScoreCpp(X, Y, &Deriv, &Var, &mu);
-  arma::vec r(beta->n_elem);
+  arma::vec g1 = WeightedScoreCpp(X, &r);
+  arma::vec q(beta->n_elem);
   arma::vec alphavec(m);
+  arma::vec rho(m);
   arma::mat s(beta->n_elem, m);
   arma::mat y(beta->n_elem, m);
-  arma::mat Info(beta->n_elem, beta->n_elem);
-  if(!solve(Info, FisherInfoCpp(X, &Deriv, &Var), arma::eye(arma::size(Info)), 
-            arma::solve_opts::no_approx + arma::solve_opts::likely_sympd)){
+  
+  // The initial inverse hessian is scaled by the inverse of the diagonal of the 
+  // fisher info, so the full info is never formed
+  arma::vec Diag = WeightedInfoDiagCpp(X, &w);
+  if(any(Diag <= 0)){
     warning("Fisher info not invertible");
     return(-2);
   }
+  Diag = 1 / Diag;
   
   // Initializing int and doubles
   int k = 0;
+  int npairs = 0;
   double f0;
-  double f1 = LogLikelihoodCpp(X, Y, &mu, Dist);
   double t;
   double alpha = 1;
   
@@ -445,12 +532,12 @@ int LBFGSGLMCpp(arma::vec* beta, const arma::mat* X,
     g0 = g1;
     
     // Calculating p (search direction) based on L-BFGS approximation to inverse info
-    p = -LBFGSHelperCpp(&g1, &s, &y, &k, &m, &r, &alphavec, &Info);
+    LBFGSDirectionCpp(&g1, &s, &y, &rho, npairs, m, &Diag, &q, &alphavec, &p);
     t = -arma::dot(g0, p);
     
     // Finding alpha with backtracking linesearch using strong wolfe conditions
-    // This function also calculates mu, Deriv, Var, and g1 for the selected step size
-    GetStepSize(X, Y, Offset, &mu, &Deriv, &Var, &g1, &p, beta, Dist, Link, &f0 ,&f1, &t, &alpha, "backtrack");
+    // This function also calculates mu, w, r, and g1 for the selected step size
+    GetStepSize(X, Y, Offset, &mu, &eta, &w, &r, &g1, &p, beta, Family, &f0 ,&f1, &t, &alpha, "backtrack");
     
     // Checking for convergence or nan/inf
     if(std::fabs(f1 -  f0) < tol || all(abs(alpha * p) < tol) || alpha == 0){
@@ -461,9 +548,15 @@ int LBFGSGLMCpp(arma::vec* beta, const arma::mat* X,
       k++;
       break;}
     
-    // Updating s and y for L-BFGS update
-    s.col(k % m) = alpha * p;
-    y.col(k % m) = g1 - g0;
+    // Updating s and y for L-BFGS update, the pair is skipped when s'y <= 0 
+    // since the approximate inverse hessian wouldn't be positive definite
+    s.col(npairs % m) = alpha * p;
+    y.col(npairs % m) = g1 - g0;
+    double sy = arma::dot(s.col(npairs % m), y.col(npairs % m));
+    if(sy > 0){
+      rho.at(npairs % m) = 1 / sy;
+      npairs++;
+    }
     
     // Incrementing iteration number
     k++;
@@ -473,22 +566,27 @@ int LBFGSGLMCpp(arma::vec* beta, const arma::mat* X,
 
 
 // BFGS
-int BFGSGLMCpp(arma::vec* beta, const arma::mat* X, 
+template<typename T>
+int BFGSGLMCpp(arma::vec* beta, const T* X, 
                const arma::vec* Y, const arma::vec* Offset,
-               std::string Link, std::string Dist,
+               GLMFamily Family,
                double tol, int maxit){
   
   // Initializing vectors and matrices
-  arma::vec mu = LinkCpp(X, beta, Offset, Link, Dist);
-  arma::vec Deriv = DerivativeCpp(X, beta, Offset, &mu, Link, Dist);
-  arma::vec Var = Variance(&mu, Dist);
-  arma::vec g1 = ScoreCpp(X, Y, &Deriv, &Var, &mu);
+  arma::vec mu(X->n_rows);
+  arma::vec w(X->n_rows);
+  arma::vec r(X->n_rows);
+  arma::vec eta(X->n_rows);
+  LinPredCpp(X, beta, Offset, &eta);
+  double f1 = IRLSEtaCpp(&eta, Y, &mu, &w, &r, Family);
+  arma::vec g1 = WeightedScoreCpp(X, &r);
   arma::vec p(beta->n_elem);
   arma::vec s(beta->n_elem);
   arma::vec y(beta->n_elem);
+  arma::vec Hy(beta->n_elem);
   arma::vec g0(beta->n_elem);
   arma::mat H1(beta->n_elem, beta->n_elem);
-  if(!solve(H1, FisherInfoCpp(X, &Deriv, &Var), arma::eye(arma::size(H1)), 
+  if(!solve(H1, WeightedInfoCpp(X, &w), arma::eye(arma::size(H1)), 
                 arma::solve_opts::no_approx + arma::solve_opts::likely_sympd)){
     warning("Fisher info not invertible");
     return(-2);
@@ -496,8 +594,6 @@ int BFGSGLMCpp(arma::vec* beta, const arma::mat* X,
   // Initializing int and doubles
   int k = 0;
   double f0;
-  double f1 = LogLikelihoodCpp(X, Y, &mu, Dist);
-  double rho;
   double alpha = 1;
   double t;
   
@@ -521,8 +617,8 @@ int BFGSGLMCpp(arma::vec* beta, const arma::mat* X,
     t = -arma::dot(g0, p);
     
     // Finding alpha with backtracking linesearch using strong wolfe conditions
-    // This function also calculates mu, Deriv, Var, and g1 for the selected step size
-    GetStepSize(X, Y, Offset, &mu, &Deriv, &Var, &g1, &p, beta, Dist, Link, &f0 ,&f1, &t, &alpha, "backtrack");
+    // This function also calculates mu, w, r, and g1 for the selected step size
+    GetStepSize(X, Y, Offset, &mu, &eta, &w, &r, &g1, &p, beta, Family, &f0 ,&f1, &t, &alpha, "backtrack");
     
     // Checking for convergence or non-convergence
     if(std::fabs(f1 -  f0) < tol || all(abs(alpha * p) < tol) || alpha == 0){
@@ -536,10 +632,7 @@ int BFGSGLMCpp(arma::vec* beta, const arma::mat* X,
     // Performing BFGS update
     s = alpha * p;
     y = g1 - g0;
-    rho = 1/arma::dot(s, y);
-    
-    H1 = (arma::diagmat(arma::ones(beta->n_elem)) - rho * s * y.t()) * H1 * 
-      (arma::diagmat(arma::ones(beta->n_elem)) - rho * y * s.t()) + rho * s * s.t();
+    BFGSUpdateCpp(&H1, &s, &y, &Hy);
     
     // Incrementing iteration counter
     k++;
@@ -551,23 +644,26 @@ int BFGSGLMCpp(arma::vec* beta, const arma::mat* X,
 
 // Fisher's scoring
 
-int FisherScoringGLMCpp(arma::vec* beta, const arma::mat* X, 
+template<typename T>
+int FisherScoringGLMCpp(arma::vec* beta, const T* X, 
                         const arma::vec* Y, const arma::vec* Offset,
-                        std::string Link, std::string Dist,
+                        GLMFamily Family,
                         double tol, int maxit){
   
   // Initializing vector and matrices
-  arma::vec mu = LinkCpp(X, beta, Offset, Link, Dist);
-  arma::vec Deriv = DerivativeCpp(X, beta, Offset, &mu, Link, Dist);
-  arma::vec Var = Variance(&mu, Dist);
-  arma::vec g1 = ScoreCpp(X, Y, &Deriv, &Var, &mu);
+  arma::vec mu(X->n_rows);
+  arma::vec w(X->n_rows);
+  arma::vec r(X->n_rows);
+  arma::vec eta(X->n_rows);
+  LinPredCpp(X, beta, Offset, &eta);
+  double f1 = IRLSEtaCpp(&eta, Y, &mu, &w, &r, Family);
+  arma::vec g1 = WeightedScoreCpp(X, &r);
   arma::vec p(beta->n_elem);
-  arma::mat H1 = FisherInfoCpp(X, &Deriv, &Var);
+  arma::mat H1 = WeightedInfoCpp(X, &w);
   
   // Initializing int and doubles
   int k = 0;
   double f0;
-  double f1 = LogLikelihoodCpp(X, Y, &mu, Dist);
   double alpha = 1;
   double t;
   
@@ -594,8 +690,8 @@ int FisherScoringGLMCpp(arma::vec* beta, const arma::mat* X,
     t = -arma::dot(g1, p);
     
     // Finding alpha with backtracking linesearch using strong wolfe conditions
-    // This function also calculates mu, Deriv, Var, and g1 for the selected step size
-    GetStepSize(X, Y, Offset, &mu, &Deriv, &Var, &g1, &p, beta, Dist, Link, &f0 ,&f1, &t, &alpha, "backtrack");
+    // This function also calculates mu, w, r, and g1 for the selected step size
+    GetStepSize(X, Y, Offset, &mu, &eta, &w, &r, &g1, &p, beta, Family, &f0 ,&f1, &t, &alpha, "backtrack");
     
     // Checking for convergence or non-convergence
     if(std::fabs(f1 -  f0) < tol || all(abs(alpha * p) < tol) || alpha == 0){
@@ -607,7 +703,7 @@ int FisherScoringGLMCpp(arma::vec* beta, const arma::mat* X,
       break;}
     
     // Calculating information
-    H1 = FisherInfoCpp(X, &Deriv, &Var);
+    H1 = WeightedInfoCpp(X, &w);
     
     // Incrementing iteration number
     k++;
@@ -615,18 +711,422 @@ int FisherScoringGLMCpp(arma::vec* beta, const arma::mat* X,
   return(k);
 }
 
+// Splits a dense design matrix into blocks of rows so it can be streamed the 
+// same way as a ChunkedMatrix, this is used for mapped design files so only the 
+// pages of the file for the current blocks are needed
+class DenseRowBlocks{
+public:
+  unsigned int n_rows;
+  unsigned int n_cols;
+  unsigned int chunksize;
+  DenseRowBlocks(const arma::mat* X, unsigned int chunksize):
+  n_rows(X->n_rows), n_cols(X->n_cols), chunksize(chunksize), X(X){}
+  unsigned int n_chunks() const{
+    return((n_rows + chunksize - 1) / chunksize);
+  }
+  unsigned int ChunkStart(unsigned int b) const{
+    return(b * chunksize);
+  }
+  unsigned int ChunkRows(unsigned int b) const{
+    return(std::min(chunksize, n_rows - b * chunksize));
+  }
+  
+  // Copies a block of rows into the first rows of Block
+  void GetChunk(unsigned int b, arma::mat* Block) const{
+    unsigned int start = ChunkStart(b);
+    unsigned int rows = ChunkRows(b);
+    for(unsigned int j = 0; j < n_cols; j++){
+      std::copy(X->colptr(j) + start, X->colptr(j) + start + rows, Block->colptr(j));
+    }
+  }
+private:
+  const arma::mat* X;
+};
+
+// Number of rows in each block when a dense design matrix is streamed
+const unsigned int StreamRows = 4096;
+
+// Calculates the negative log-likelihood, score, and fisher info in one pass 
+// over the blocks of rows of X, the fisher info is only found when H isn't null
+// Each block is decoded, used, and then overwritten by the next one, so only 
+// one block of X and p x p matrices are kept for each thread
+// The blocks are split among threads when there are enough observations
+template<typename S>
+double StreamIRLSPass(const S* X, const arma::vec* Y, const arma::vec* Offset, 
+                      const arma::vec* beta, GLMFamily Family, arma::vec* g, 
+                      arma::mat* H){
+  
+  unsigned int p = X->n_cols;
+  double f = 0;
+  bool Info = H != nullptr;
+  g->zeros(p);
+  if(Info){
+    H->zeros(p, p);
+  }
+  
+  // Using all columns of each block
+  arma::uvec Cols(p);
+  for(unsigned int j = 0; j < p; j++){
+    Cols.at(j) = j;
+  }
+  
+  // Each thread accumulates its blocks into its own score and info
+#pragma omp parallel if(DataParallel(X->n_rows))
+{
+  arma::mat Block(X->chunksize, p);
+  arma::mat Buffer;
+  arma::vec eta(X->chunksize);
+  arma::vec w(X->chunksize);
+  arma::vec r(X->chunksize);
+  arma::vec TempVec(p, arma::fill::zeros);
+  arma::mat TempMat;
+  if(Info){
+    Buffer.set_size(X->chunksize, p + 1);
+    TempMat.zeros(p, p);
+  }
+  double Tempf = 0;
+  
+#pragma omp for schedule(dynamic, 1)
+  for(unsigned int b = 0; b < X->n_chunks(); b++){
+    unsigned int start = X->ChunkStart(b);
+    unsigned int rows = X->ChunkRows(b);
+    arma::mat CurBlock(Block.memptr(), rows, p, false, true);
+    arma::vec eta1(eta.memptr(), rows, false, true);
+    arma::vec w1(w.memptr(), rows, false, true);
+    arma::vec r1(r.memptr(), rows, false, true);
+    const arma::vec Y1(const_cast<double*>(Y->memptr()) + start, rows, false, true);
+    X->GetChunk(b, &CurBlock);
+    
+    // Calculating linear predictors, the offset is added first
+    std::copy(Offset->begin() + start, Offset->begin() + start + rows, eta1.begin());
+    for(unsigned int j = 0; j < p; j++){
+      const double* Xcol = CurBlock.colptr(j);
+      double betaj = beta->at(j);
+      for(unsigned int i = 0; i < rows; i++){
+        eta1.at(i) += betaj * Xcol[i];
+      }
+    }
+    
+    // Calculating weights and score contributions, mu overwrites eta
+    Tempf += FamilyDispatch<IRLSKernel>(Family, &eta1, &Y1, &eta1, &w1, &r1, false);
+    
+    // Adding this block to the score and info
+    for(unsigned int j = 0; j < p; j++){
+      const double* Xcol = CurBlock.colptr(j);
+      double temp = 0;
+      for(unsigned int i = 0; i < rows; i++){
+        temp += Xcol[i] * r1.at(i);
+      }
+      TempVec.at(j) -= temp;
+    }
+    if(Info && p > 0){
+      WeightedXTXBlock(&CurBlock, &Cols, &w1, &Buffer, &TempMat, 0);
+    }
+  }
+  
+#pragma omp critical
+{
+  f += Tempf;
+  *g += TempVec;
+  if(Info){
+    *H += TempMat;
+  }
+}
+}
+  
+  if(Info){
+    *H = symmatu(*H);
+  }
+  return(f);
+}
+
+// Fisher's scoring that streams through the blocks of rows of X
+// Only the negative log-likelihood and score are found for each step size that 
+// is tried, the fisher info takes O(np^2) so it is found in another pass once a 
+// step is accepted, and only p x p matrices are kept between passes
+template<typename S>
+int StreamingFisherCpp(arma::vec* beta, const S* X, 
+                       const arma::vec* Y, const arma::vec* Offset,
+                       GLMFamily Family, double tol, int maxit){
+  
+  // Maximum number of step halvings and constants for the strong wolfe conditions
+  unsigned int maxiter = 40;
+  double C1 = pow(10, -4);
+  double C2 = 0.9;
+  
+  // Initializing vectors and matrices
+  arma::vec g1(beta->n_elem);
+  arma::mat H1(beta->n_elem, beta->n_elem);
+  arma::vec g(beta->n_elem);
+  arma::vec p(beta->n_elem);
+  arma::vec tempbeta(beta->n_elem);
+  double f1 = StreamIRLSPass(X, Y, Offset, beta, Family, &g1, &H1);
+  
+  // Initializing int and doubles
+  int k = 0;
+  double f0;
+  double f;
+  double alpha;
+  double t;
+  unsigned int halvings;
+  
+  // Fitting the model
+  while(arma::norm(g1) > tol){
+    checkUserInterrupt();
+    
+    // Checks if we've reached maxit iterations and stops if we have
+    if(k == maxit){ 
+      warning("Fisher Scoring failed to converge");
+      k = -1;
+      break;
+    }
+    
+    // Re-assigning likelihood
+    f0 = f1;
+    
+    // Solving for newton direction
+    if(!arma::solve(p, -H1, g1, arma::solve_opts::no_approx + arma::solve_opts::likely_sympd)){
+      warning("Fisher info not invertible");
+      return(-2);
+    };
+    
+    t = -arma::dot(g1, p);
+    
+    // Finding alpha with backtracking linesearch using strong wolfe conditions
+    alpha = 1;
+    for(halvings = 0; halvings < maxiter; halvings++){
+      tempbeta = *beta + alpha * p;
+      f = StreamIRLSPass(X, Y, Offset, &tempbeta, Family, &g, nullptr);
+      if(f0 >= f + C1 * alpha * t && arma::dot(p, g) <= C2 * t){
+        break;
+      }
+      alpha /= 2;
+    }
+    // No step size was found, so this is a failure like a singular fisher info
+    if(halvings == maxiter){
+      warning("Fisher Scoring failed to converge");
+      k = -2;
+      break;
+    }
+    
+    // Taking the step, the score was found for it in the line search
+    beta->swap(tempbeta);
+    g1.swap(g);
+    f1 = f;
+    k++;
+    
+    // Checking for convergence or non-convergence
+    if(std::fabs(f1 -  f0) < tol || all(abs(alpha * p) < tol)){
+      if(!std::isfinite(f1) || beta->has_nan()){
+        warning("Fisher Scoring failed to converge");
+        k = -2;
+      }
+      break;
+    }
+    
+    // Getting the fisher info for the accepted step
+    StreamIRLSPass(X, Y, Offset, beta, Family, &g, &H1);
+  }
+  return(k);
+}
+
+// Streams the blocks of rows of X through Fisher's scoring, sparse design 
+// matrices aren't split into blocks of rows so they use FisherScoringGLMCpp
+int StreamFisherCpp(arma::vec* beta, const ChunkedMatrix* X, 
+                    const arma::vec* Y, const arma::vec* Offset,
+                    GLMFamily Family, double tol, int maxit){
+  return(StreamingFisherCpp(beta, X, Y, Offset, Family, tol, maxit));
+}
+
+int StreamFisherCpp(arma::vec* beta, const arma::mat* X, 
+                    const arma::vec* Y, const arma::vec* Offset,
+                    GLMFamily Family, double tol, int maxit){
+  const DenseRowBlocks Blocks(X, StreamRows);
+  return(StreamingFisherCpp(beta, &Blocks, Y, Offset, Family, tol, maxit));
+}
+
+int StreamFisherCpp(arma::vec* beta, const arma::sp_mat* X, 
+                    const arma::vec* Y, const arma::vec* Offset,
+                    GLMFamily Family, double tol, int maxit){
+  return(FisherScoringGLMCpp(beta, X, Y, Offset, Family, tol, maxit));
+}
+
+// Solves X'WX * s = b by conjugate gradients, each product with X'WX is done 
+// as X'(w % (X * d)) so X'WX is never formed
+// The iterations stop when the norm of the residual is at most cgtol, after 
+// maxcg iterations, or when s reaches the boundary of the trust region with 
+// radius Delta, Delta can be infinite
+// res is set to the residual b - X'WX * s, Zero is a vector of zeros used as 
+// the offset for X * d, and Xd, d, and Hd are used as workspace so the 
+// iterations don't allocate memory
+// true is returned if s is on the boundary of the trust region
+template<typename T>
+bool TruncatedCGCpp(const T* X, const arma::vec* w, const arma::vec* b, 
+                    double Delta, double cgtol, unsigned int maxcg, 
+                    arma::vec* s, arma::vec* res, const arma::vec* Zero, 
+                    arma::vec* Xd, arma::vec* d, arma::vec* Hd){
+  s->zeros();
+  *res = *b;
+  *d = *res;
+  double rr = arma::dot(*res, *res);
+  
+  for(unsigned int i = 0; i < maxcg && sqrt(rr) > cgtol; i++){
+    
+    // Calculating X'WX * d
+    LinPredCpp(X, d, Zero, Xd);
+    *Xd %= *w;
+    CrossProdCpp(X, Xd, Hd);
+    double dHd = arma::dot(*d, *Hd);
+    
+    // X'WX may be singular, then there is no more progress along d unless 
+    // there is a trust region to stop at
+    if(dHd <= 0 && std::isinf(Delta)){
+      break;
+    }
+    
+    // Stopping at the boundary of the trust region if the step along d leaves it
+    double a = rr / dHd;
+    double sd = arma::dot(*s, *d);
+    double dd = arma::dot(*d, *d);
+    double ss = arma::dot(*s, *s);
+    if(dHd <= 0 || ss + 2 * a * sd + a * a * dd >= Delta * Delta){
+      double tau = (-sd + sqrt(sd * sd + dd * (Delta * Delta - ss))) / dd;
+      *s += tau * *d;
+      *res -= tau * *Hd;
+      return(true);
+    }
+    
+    // Updating s, the residual, and the search direction
+    *s += a * *d;
+    *res -= a * *Hd;
+    double rr1 = arma::dot(*res, *res);
+    *d *= rr1 / rr;
+    *d += *res;
+    rr = rr1;
+  }
+  return(false);
+}
+
+// Newton-CG
+// This is a trust region newton method, the newton direction is found with 
+// TruncatedCGCpp so the fisher info is never formed and only O(n + p) memory 
+// is used on top of X, each CG iteration takes two passes over X
+template<typename T>
+int NewtonCGGLMCpp(arma::vec* beta, const T* X, 
+                   const arma::vec* Y, const arma::vec* Offset,
+                   GLMFamily Family,
+                   double tol, int maxit){
+  
+  // Defining constants for the trust region, steps are taken when the actual 
+  // reduction in the negative log-likelihood is at least eta0 times the 
+  // reduction predicted by the quadratic model, the radius is shrunk when it is 
+  // less than eta1 times the prediction and grown when it is more than eta2 times
+  double eta0 = 1e-4;
+  double eta1 = 0.25;
+  double eta2 = 0.75;
+  
+  // Initializing vectors, the temporary vectors hold mu, w, r, and the linear 
+  // predictors for the trial step
+  arma::vec mu(X->n_rows);
+  arma::vec w(X->n_rows);
+  arma::vec r(X->n_rows);
+  arma::vec eta(X->n_rows);
+  arma::vec tempmu(X->n_rows);
+  arma::vec tempw(X->n_rows);
+  arma::vec tempr(X->n_rows);
+  arma::vec tempeta(X->n_rows);
+  const arma::vec Zero(X->n_rows, arma::fill::zeros);
+  LinPredCpp(X, beta, Offset, &eta);
+  double f1 = IRLSEtaCpp(&eta, Y, &mu, &w, &r, Family);
+  arma::vec g1 = WeightedScoreCpp(X, &r);
+  arma::vec b(beta->n_elem);
+  arma::vec s(beta->n_elem);
+  arma::vec res(beta->n_elem);
+  arma::vec d(beta->n_elem);
+  arma::vec Hd(beta->n_elem);
+  
+  // Initializing int and doubles
+  int k = 0;
+  double f0;
+  double gnorm = arma::norm(g1);
+  double Delta = gnorm;
+  
+  // Fitting the model
+  while(gnorm > tol){
+    checkUserInterrupt();
+    
+    // Checks if we've reached maxit iterations and stops if we have
+    if(k == maxit){ 
+      warning("Newton-CG failed to converge");
+      k = -1;
+      break;
+    }
+    
+    // Finding the newton direction in the trust region, the tolerance for CG 
+    // gets smaller along with the score so the steps become exact newton steps
+    b = -g1;
+    bool Boundary = TruncatedCGCpp(X, &w, &b, Delta, std::min(0.5, sqrt(gnorm)) * gnorm, 
+                                   beta->n_elem, &s, &res, &Zero, &tempeta, &d, &Hd);
+    double pred = -0.5 * (arma::dot(g1, s) - arma::dot(s, res));
+    double snorm = arma::norm(s);
+    
+    // Getting the actual reduction for the step
+    LinPredCpp(X, &s, &Zero, &tempeta);
+    tempeta += eta;
+    double tempf1 = IRLSEtaCpp(&tempeta, Y, &tempmu, &tempw, &tempr, Family);
+    double actual = f1 - tempf1;
+    
+    // Updating radius of the trust region, this also handles non-finite values
+    if(!(actual >= eta1 * pred)){
+      Delta = eta1 * snorm;
+    }
+    else if(actual > eta2 * pred && Boundary){
+      Delta *= 2;
+    }
+    
+    // Incrementing iteration number
+    k++;
+    
+    // Taking the step if it reduced the negative log-likelihood enough
+    if(actual >= eta0 * pred && pred > 0){
+      *beta += s;
+      eta.swap(tempeta);
+      mu.swap(tempmu);
+      w.swap(tempw);
+      r.swap(tempr);
+      f0 = f1;
+      f1 = tempf1;
+      g1 = WeightedScoreCpp(X, &r);
+      gnorm = arma::norm(g1);
+      
+      // Checking for convergence or nan/inf
+      if(std::fabs(f1 - f0) < tol || all(abs(s) < tol)){
+        if(std::isinf(f1) || beta->has_nan()){
+          warning("Newton-CG failed to converge");
+          k = -2;
+        }
+        break;
+      }
+    }
+    else if(Delta < tol || all(abs(s) < tol)){
+      // The step was rejected and the trust region or the step is already 
+      // smaller than tol, so no more progress can be made before converging
+      warning("Newton-CG failed to converge");
+      k = -1;
+      break;
+    }
+  }
+  return(k);
+}
+
 // Linear regression used when SEs need to be calculated
-int LinRegCpp(arma::vec* beta, const arma::mat* x, const arma::mat* y,
+template<typename T>
+int LinRegCpp(arma::vec* beta, const T* x, const arma::vec* y,
               const arma::vec* offset, arma::vec* SE1, arma::mat* InfoInv,
               unsigned int nthreads){
   
-  // Creating initial mat and calculating X'X
-  arma::mat FinalMat(x->n_cols, x->n_cols);
-  if(nthreads > 1){
-    FinalMat = ParXTX(x);
-  }else{
-    FinalMat = XTX(x, 16);
-  }
+  // Calculating X'X
+  arma::mat FinalMat = GramCpp(x, nthreads);
   
   // calculating inverse of X'X
   arma::mat InvXX(x->n_cols, x->n_cols, arma::fill::zeros);
@@ -636,24 +1136,48 @@ int LinRegCpp(arma::vec* beta, const arma::mat* x, const arma::mat* y,
   }
   
   // Calculating beta and beta variances
-  *beta = InvXX * x->t() * (*y - *offset);
+  const arma::vec NewY = *y - *offset;
+  *beta = InvXX * CrossProdCpp(x, &NewY);
   *InfoInv = InvXX;
   *SE1 = arma::diagvec(InvXX);
   return(1);
 } 
 
+// Linear regression with conjugate gradients, this is used for initial values 
+// when X'X is too large to form
+template<typename T>
+int LinRegCGShort(arma::vec* beta, const T* x, const arma::vec* y,
+                  const arma::vec* offset){
+  
+  // Solving X'X * beta = X'(y - offset)
+  const arma::vec NewY = *y - *offset;
+  arma::vec XY = CrossProdCpp(x, &NewY);
+  const arma::vec w(x->n_rows, arma::fill::ones);
+  const arma::vec Zero(x->n_rows, arma::fill::zeros);
+  arma::vec res(beta->n_elem);
+  arma::vec Xd(x->n_rows);
+  arma::vec d(beta->n_elem);
+  arma::vec Hd(beta->n_elem);
+  TruncatedCGCpp(x, &w, &XY, arma::datum::inf, 1e-6 * arma::norm(XY), beta->n_elem, 
+                 beta, &res, &Zero, &Xd, &d, &Hd);
+  if(!beta->is_finite()){
+    beta->zeros();
+    return(-2);
+  }
+  
+  return(1);
+}
+
 // Linear regression used when SEs are not necessary
-int LinRegCppShort(arma::vec* beta, const arma::mat* x, const arma::mat* y,
+template<typename T>
+int LinRegCppShort(arma::vec* beta, const T* x, const arma::vec* y,
                    const arma::vec* offset, unsigned int nthreads){
   
-  arma::mat FinalMat(x->n_cols, x->n_cols);
-  if(nthreads > 1){
-    FinalMat = ParXTX(x);
-  }else{
-    FinalMat = XTX(x, 16);
-  }
+  arma::mat FinalMat = GramCpp(x, nthreads);
+  
   // Solving for beta
-  arma::vec XY = x->t() * (*y - *offset);  
+  const arma::vec NewY = *y - *offset;
+  arma::vec XY = CrossProdCpp(x, &NewY);
   arma::vec tempbeta = *beta;
   if(!solve(*beta, FinalMat, XY, arma::solve_opts::no_approx + arma::solve_opts::likely_sympd)){
     warning("Fisher info not invertible");
@@ -664,26 +1188,25 @@ int LinRegCppShort(arma::vec* beta, const arma::mat* x, const arma::mat* y,
   return(1);
 }
 
-double GetDispersion(const arma::mat* X, const arma::vec* Y, 
-                     arma::vec* mu, double LogLik, std::string Dist, 
-                     double tol){
+double GetDispersion(const arma::vec* Y, arma::vec* mu, double LogLik, 
+                     GLMFamily Family, double tol){
   // Setting default value for dispersion parameter
   double dispersion = 1;
   
-  if(Dist == "gaussian"){
+  if(Family.Dist == GLMDist::gaussian){
     // Dispersion parameter for gaussian glm is the MSE
-    dispersion = arma::accu(pow(*Y - *mu, 2)) / (X->n_rows);
-  }else if(Dist == "gamma"){
+    dispersion = arma::accu(pow(*Y - *mu, 2)) / (Y->n_elem);
+  }else if(Family.Dist == GLMDist::gamma){
     
     // Initializing values
     unsigned int it = 0;
     double alpha = 1;
     double dispersion2 = dispersion + 2 * tol;
-    double fixed = LogLik + arma::accu(log(*Y)) + X->n_rows;
+    double fixed = LogLik + arma::accu(log(*Y)) + Y->n_elem;
     
     // Initializing score and info
-    double score = fixed + X->n_rows * (log(dispersion) - boost::math::digamma(dispersion)); 
-    double info = X->n_rows * (-1 / dispersion + boost::math::trigamma(dispersion));
+    double score = fixed + Y->n_elem * (log(dispersion) - boost::math::digamma(dispersion)); 
+    double info = Y->n_elem * (-1 / dispersion + boost::math::trigamma(dispersion));
     
     // Using newton's method to find shape parameter
     while(std::fabs(score) > tol && std::fabs(dispersion - dispersion2) > tol && it < 25){
@@ -694,8 +1217,8 @@ double GetDispersion(const arma::mat* X, const arma::vec* Y,
         alpha /= 2;
         dispersion -= alpha * score / info; 
       }
-      score = fixed + X->n_rows * (log(dispersion) - boost::math::digamma(dispersion));
-      info = X->n_rows * (-1 / dispersion + boost::math::trigamma(dispersion));
+      score = fixed + Y->n_elem * (log(dispersion) - boost::math::digamma(dispersion));
+      info = Y->n_elem * (-1 / dispersion + boost::math::trigamma(dispersion));
       it++;
     }
     
@@ -705,17 +1228,30 @@ double GetDispersion(const arma::mat* X, const arma::vec* Y,
   return(dispersion);
 }
 
+// Gets initial values from a linear regression on the transformed response, 
+// X'X is only formed when MatrixFree is false
+template<typename T>
+int InitLinRegCpp(arma::vec* beta, const T* X, const arma::vec* y, 
+                  const arma::vec* Offset, unsigned int nthreads, bool MatrixFree){
+  if(MatrixFree){
+    return(LinRegCGShort(beta, X, y, Offset));
+  }
+  return(LinRegCppShort(beta, X, y, Offset, nthreads));
+}
+
 // Gets initial values for gamma, poisson, and gaussian regression
-void getInit(arma::vec* beta, const arma::mat* X, const arma::vec* Y, 
-             const arma::vec* Offset, std::string Dist, std::string Link, 
-             unsigned int nthreads){
+// MatrixFree is used for Newton-CG, so conjugate gradients is used instead of X'X
+template<typename T>
+void getInit(arma::vec* beta, const T* X, const arma::vec* Y, 
+             const arma::vec* Offset, GLMFamily Family, 
+             unsigned int nthreads, bool MatrixFree){
   int iter = 0;
-  if(Link == "log"){
+  if(Family.Link == GLMLink::log){
     arma::vec NewY = *Y;
     NewY = log(NewY.clamp(1e-4, arma::datum::inf));
-    iter = LinRegCppShort(beta, X, &NewY, Offset, nthreads);
+    iter = InitLinRegCpp(beta, X, &NewY, Offset, nthreads, MatrixFree);
     
-  }else if(Link == "inverse"){
+  }else if(Family.Link == GLMLink::inverse){
     arma::vec NewY = *Y;
     NewY.transform( [](double val) {
       if(std::fabs(val) <= 1e-2){
@@ -724,22 +1260,22 @@ void getInit(arma::vec* beta, const arma::mat* X, const arma::vec* Y,
       return(val);
       } );
     NewY = 1 / (NewY);
-    iter = LinRegCppShort(beta, X, &NewY, Offset, nthreads);
+    iter = InitLinRegCpp(beta, X, &NewY, Offset, nthreads, MatrixFree);
     
-  }else if(Link == "sqrt"){
+  }else if(Family.Link == GLMLink::sqrt){
     const arma::vec NewY = sqrt(*Y);
-    iter = LinRegCppShort(beta, X, &NewY, Offset, nthreads);
+    iter = InitLinRegCpp(beta, X, &NewY, Offset, nthreads, MatrixFree);
     
-  }else if(Link == "identity" && (Dist != "gaussian")){
-    iter = LinRegCppShort(beta, X, Y, Offset, nthreads);
+  }else if(Family.Link == GLMLink::identity && (Family.Dist != GLMDist::gaussian)){
+    iter = InitLinRegCpp(beta, X, Y, Offset, nthreads, MatrixFree);
     
-  }else if(Link == "logit"){
+  }else if(Family.Link == GLMLink::logit){
     arma::vec NewY = *Y;
     NewY = NewY.clamp(1e-4, 1 - 1e-4);
     NewY = log(NewY / (1 - NewY));
-    iter = LinRegCppShort(beta, X, &NewY, Offset, nthreads);
+    iter = InitLinRegCpp(beta, X, &NewY, Offset, nthreads, MatrixFree);
     
-  }else if(Link == "probit"){
+  }else if(Family.Link == GLMLink::probit){
     arma::vec NewY = *Y;
     double val0 = boost::math::quantile(boost::math::normal(0.0, 1.0), 1e-4);
     double val1 = boost::math::quantile(boost::math::normal(0.0, 1.0), 1 - 1e-4);
@@ -750,12 +1286,12 @@ void getInit(arma::vec* beta, const arma::mat* X, const arma::vec* Y,
         NewY.at(i) = val1;
       }
     }
-    iter = LinRegCppShort(beta, X, &NewY, Offset, nthreads);
-  }else if(Link == "cloglog"){
+    iter = InitLinRegCpp(beta, X, &NewY, Offset, nthreads, MatrixFree);
+  }else if(Family.Link == GLMLink::cloglog){
     arma::vec NewY = *Y;
     NewY = NewY.clamp(1e-4, 1 - 1e-4);
     NewY = log(-log(1 - NewY));
-    iter = LinRegCppShort(beta, X, &NewY, Offset, nthreads);
+    iter = InitLinRegCpp(beta, X, &NewY, Offset, nthreads, MatrixFree);
   }
   // Checking for failure
   if(iter == -2){
@@ -763,66 +1299,79 @@ void getInit(arma::vec* beta, const arma::mat* X, const arma::vec* Y,
   }
 }
 
-// [[Rcpp::export]]
-List BranchGLMfit(NumericMatrix x, NumericVector y, NumericVector offset,
-                  NumericVector init,
-                  std::string method,  unsigned int m, std::string Link, 
-                  std::string Dist,
-                  unsigned int nthreads, double tol, int maxit, bool GetInit){
+// Fits a GLM and calculates the results that are returned to R
+template<typename T>
+List GLMFitHelper(const T* X, const arma::vec* Y, const arma::vec* Offset, 
+                  arma::vec beta, std::string method, unsigned int m, 
+                  GLMFamily Family, unsigned int nthreads, double tol, int maxit, 
+                  bool GetInit, bool Stream){
   
+  // Newton-CG is used for models that are too wide to form the fisher info, 
+  // so the SEs and the variance-covariance matrix are not found for it
+  bool MatrixFree = method == "NewtonCG" && !IsLinReg(Family);
+  
+  // Stream is true when X is read by blocks of rows, then Fisher's scoring only 
+  // keeps p x p matrices between passes over X
   
   // Initializing vectors and matrices
-  const arma::mat X(x.begin(), x.rows(), x.cols(), false, true);
-  const arma::vec Y(y.begin(), y.size(), false, true); 
-  const arma::vec Offset(offset.begin(), offset.size(), false, true);
-  const arma::vec Init(init.begin(), init.size(), false, true);
-  arma::vec beta = Init;
-  arma::mat Info(beta.n_elem, beta.n_elem);
-  arma::mat InfoInv(beta.n_elem, beta.n_elem);
+  arma::mat Info;
+  arma::mat InfoInv;
   arma::vec SE1(beta.n_elem);
+  SE1.fill(NA_REAL);
   
   // Initializing doubles
   double Iter;
   double dispersion = 1;
-#ifdef _OPENMP
-  omp_set_num_threads(nthreads);
-#endif
+  
+  // The loops over observations are only split among threads when there are 
+  // enough of them to make up for starting a parallel region
+  ThreadScope Threads(ChooseThreads(X->n_rows, X->n_cols, 1, nthreads));
+  nthreads = Threads.Plan.nthreads;
   
   // Getting initial values
   if(GetInit){
-    getInit(&beta, &X, &Y, &Offset, Dist, Link, nthreads);
+    getInit(&beta, X, Y, Offset, Family, nthreads, MatrixFree);
   }
   
   // Fitting model
-  if(Dist == "gaussian" && Link == "identity"){
-    Iter = LinRegCpp(&beta, &X, &Y, &Offset, &SE1, &InfoInv, nthreads);
+  if(IsLinReg(Family)){
+    Iter = LinRegCpp(&beta, X, Y, Offset, &SE1, &InfoInv, nthreads);
   }else if(method == "BFGS"){
-    Iter = BFGSGLMCpp(&beta, &X, &Y, &Offset, Link, Dist, tol, maxit);
+    Iter = BFGSGLMCpp(&beta, X, Y, Offset, Family, tol, maxit);
   }
   else if(method == "LBFGS"){
-    Iter = LBFGSGLMCpp(&beta, &X, &Y, &Offset, Link, Dist, tol, maxit, m);
+    Iter = LBFGSGLMCpp(&beta, X, Y, Offset, Family, tol, maxit, m);
+  }
+  else if(MatrixFree){
+    Iter = NewtonCGGLMCpp(&beta, X, Y, Offset, Family, tol, maxit);
+  }
+  else if(Stream){
+    Iter = StreamFisherCpp(&beta, X, Y, Offset, Family, tol, maxit);
   }
   else{
-    Iter = FisherScoringGLMCpp(&beta, &X, &Y, &Offset, Link, Dist, tol, maxit);
+    Iter = FisherScoringGLMCpp(&beta, X, Y, Offset, Family, tol, maxit);
   }
   
   // Checking for non-invertible fisher info error
-  if(Iter == -2){
+  if(Iter == -2 && MatrixFree){
+    stop("Algorithm failed to converge");
+  }
+  else if(Iter == -2){
     stop("Algorithm failed to converge because the fisher info was not invertible");
   }
   
   // Calculating means
-  arma::vec mu = LinkCpp(&X, &beta, &Offset, Link, Dist);
+  arma::vec mu = LinkCpp(X, &beta, Offset, Family);
   
   // Calculating variances for betas for non-linear regression
-  if(Dist != "gaussian" || Link != "identity"){
+  if(!IsLinReg(Family) && !MatrixFree){
     
     // Calculating derivatives, and variances to be used for info
-    arma::vec Deriv = DerivativeCpp(&X, &beta, &Offset, &mu, Link, Dist);
-    arma::vec Var = Variance(&mu, Dist);
+    arma::vec Deriv = DerivativeCpp(X, &beta, Offset, &mu, Family);
+    arma::vec Var = Variance(&mu, Family);
     
     // Calculating info and initaliazing inverse info
-    Info = FisherInfoCpp(&X, &Deriv, &Var);
+    Info = FisherInfoCpp(X, &Deriv, &Var);
     InfoInv = Info;
     
     // Calculating inverse info and returning error if not invertible
@@ -836,68 +1385,63 @@ List BranchGLMfit(NumericMatrix x, NumericVector y, NumericVector offset,
   
   // Getting SE
   NumericVector SE = NumericVector(SE1.begin(), SE1.end());
-  NumericMatrix vcov = NumericMatrix(InfoInv.n_rows, InfoInv.n_cols, InfoInv.begin());
   
   // Converting variances to SEs
   SE = sqrt(SE);
   
   // Returning results
-  double satLogLik = LogLikelihoodSat(&X, &Y, Dist);
-  double LogLik = -LogLikelihoodCpp(&X, &Y, &mu, Dist);
+  double satLogLik = LogLikelihoodSat(Y, Family);
+  double LogLik = -LogLikelihoodCpp(Y, &mu, Family);
   double resDev = -2 * (LogLik - satLogLik);
-  double AIC = -2 * LogLik + 2 * X.n_cols;
+  double AIC = -2 * LogLik + 2 * X->n_cols;
   
   NumericVector beta1 = NumericVector(beta.begin(), beta.end());
   
-  arma::vec linPreds = X * beta + Offset;
+  arma::vec linPreds(X->n_rows);
+  LinPredCpp(X, &beta, Offset, &linPreds);
   
   NumericVector linPreds1 = NumericVector(linPreds.begin(), linPreds.end());
   
   // Getting dispersion parameter
-  dispersion = GetDispersion(&X, &Y, &mu, LogLik, Dist, tol);
+  dispersion = GetDispersion(Y, &mu, LogLik, Family, tol);
   
   // Checking for valid dispersion parameter
   if(dispersion <= 0 || std::isinf(dispersion)){
     stop("dispersion parameter was estimated to be non-positive or infinite");
   }
   
-  if(Dist == "gaussian"){
-    double temp = Y.n_elem/2. * log(2*M_PI*dispersion);
+  if(Family.Dist == GLMDist::gaussian){
+    double temp = Y->n_elem/2. * log(2*M_PI*dispersion);
     LogLik = LogLik / dispersion - temp;
-    AIC = -2 * LogLik + 2 * (X.n_cols + 1);
+    AIC = -2 * LogLik + 2 * (X->n_cols + 1);
   }
-  else if(Dist == "poisson"){
-    LogLik -=  LogFact(&Y);
-    AIC = -2 * LogLik + 2 * (X.n_cols);
-  }else if(Dist == "gamma"){
+  else if(Family.Dist == GLMDist::poisson){
+    LogLik -=  LogFact(Y);
+    AIC = -2 * LogLik + 2 * (X->n_cols);
+  }else if(Family.Dist == GLMDist::gamma){
     double shape = 1 / dispersion;
     LogLik = shape * LogLik + 
-      X.n_rows * (shape * log(shape) - lgamma(shape)) + 
-      (shape - 1) * arma::accu(log(Y));
-    AIC = -2 * LogLik + 2 * (X.n_cols + 1);
+      X->n_rows * (shape * log(shape) - lgamma(shape)) + 
+      (shape - 1) * arma::accu(log(*Y));
+    AIC = -2 * LogLik + 2 * (X->n_cols + 1);
   }
   
   // Calculating SE with dispersion parameter
   SE = sqrt(dispersion) * SE;
-  vcov = vcov * dispersion;
   
   // Calculating z-values
   NumericVector z = NumericVector(beta.begin(), beta.end()) / SE;
   NumericVector p(z.length());
   
   // Calculating p-values
-  if(Dist == "gaussian" || Dist == "gamma"){
-    p = 2 * pt(abs(z), X.n_rows - X.n_cols, false, false);
+  if(Family.Dist == GLMDist::gaussian || Family.Dist == GLMDist::gamma){
+    p = 2 * pt(abs(z), X->n_rows - X->n_cols, false, false);
   }
   else{
     p = 2 * pnorm(abs(z), 0, 1, false, false);
   }
   
-#ifdef _OPENMP
-  omp_set_num_threads(1);
-#endif
-  
-  return List::create(Named("coefficients") = DataFrame::create(Named("Estimate") = beta1,  
+  List Results = List::create(Named("coefficients") = DataFrame::create(Named("Estimate") = beta1,  
                             Named("SE") = SE,
                             Named("z") = z, 
                             Named("p-values") = p),
@@ -907,6 +1451,62 @@ List BranchGLMfit(NumericMatrix x, NumericVector y, NumericVector offset,
                             Named("resDev") = resDev,
                             Named("AIC") = AIC,
                             Named("preds") = NumericVector(mu.begin(), mu.end()),
-                            Named("linpreds") = linPreds1, 
-                            Named("vcov") = vcov);
+                            Named("linpreds") = linPreds1);
+  
+  // Getting variance-covariance matrix, this is left out for Newton-CG
+  if(!MatrixFree){
+    NumericMatrix vcov = NumericMatrix(InfoInv.n_rows, InfoInv.n_cols, InfoInv.begin());
+    vcov = vcov * dispersion;
+    Results.push_back(vcov, "vcov");
+  }
+  return(Results);
+}
+
+// [[Rcpp::export]]
+List BranchGLMfit(SEXP x, NumericVector y, NumericVector offset,
+                  NumericVector init,
+                  std::string method,  unsigned int m, std::string Link, std::string Dist,
+                  unsigned int nthreads, double tol, int maxit, bool GetInit){
+  
+  // Getting family and link used by the fitting functions
+  const GLMFamily Family = GetFamily(Dist, Link);
+  
+  // Initializing vectors and matrices
+  const arma::vec Y(y.begin(), y.size(), false, true); 
+  const arma::vec Offset(offset.begin(), offset.size(), false, true);
+  const arma::vec Init(init.begin(), init.size(), false, true);
+  
+  // Sparse design matrices are dgCMatrix objects, these are kept in CSC form
+  if(Rf_isS4(x)){
+    const arma::sp_mat X = as<arma::sp_mat>(x);
+    return(GLMFitHelper(&X, &Y, &Offset, Init, method, m, Family, nthreads, tol, 
+                        maxit, GetInit, false));
+  }
+  // Dense design matrices are either numeric matrices or mapped design files, 
+  // Fisher's scoring streams through blocks of rows for mapped design files
+  const DenseDesign X(x);
+  return(GLMFitHelper(X.get(), &Y, &Offset, Init, method, m, Family, nthreads, tol, 
+                      maxit, GetInit, TYPEOF(x) == EXTPTRSXP));
+}
+
+// Fits a GLM with a design matrix that is stored in chunks
+// [[Rcpp::export]]
+List BranchGLMfitChunked(SEXP x, NumericVector y, NumericVector offset,
+                         NumericVector init,
+                         std::string method,  unsigned int m, std::string Link, 
+                         std::string Dist, unsigned int nthreads, double tol, 
+                         int maxit, bool GetInit){
+  
+  // Getting family and link used by the fitting functions
+  const GLMFamily Family = GetFamily(Dist, Link);
+  
+  // Initializing vectors and matrices
+  XPtr<ChunkedMatrix> Chunks(x);
+  const ChunkedMatrix* X = Chunks.checked_get();
+  const arma::vec Y(y.begin(), y.size(), false, true); 
+  const arma::vec Offset(offset.begin(), offset.size(), false, true);
+  const arma::vec Init(init.begin(), init.size(), false, true);
+  
+  return(GLMFitHelper(X, &Y, &Offset, Init, method, m, Family, nthreads, tol, 
+                      maxit, GetInit, true));
 }
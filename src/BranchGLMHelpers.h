@@ -2,64 +2,119 @@
 #define BranchGLMHelpers_H
 
 #include <RcppArmadillo.h>
+#include "GLMFamily.h"
+#include "ChunkedMatrix.h"
 using namespace Rcpp;
 
 double LogFact(const arma::vec* y);
 
-void CheckBounds(arma::vec* mu, std::string Dist);
 
-arma::vec LinkCpp(const arma::mat* X, arma::vec* beta, const arma::vec* Offset, 
-                  std::string Link, std::string Dist);
+void LinPredCpp(const arma::mat* X, const arma::vec* beta, const arma::vec* Offset, 
+                arma::vec* eta);
 
-arma::vec DerivativeCpp(const arma::mat* X, arma::vec* beta, const arma::vec* Offset,
-                        arma::vec* mu, std::string Link, std::string Dist);
+void LinPredCpp(const ChunkedMatrix* X, const arma::vec* beta, const arma::vec* Offset, 
+                arma::vec* eta);
 
-arma::vec Variance(arma::vec* mu, std::string Dist);
+void LinPredCpp(const arma::sp_mat* X, const arma::vec* beta, const arma::vec* Offset, 
+                arma::vec* eta);
 
-double LogLikelihoodCpp(const arma::mat* X, const arma::vec* Y, 
-                        arma::vec* mu, std::string Dist);
+arma::vec CrossProdCpp(const arma::mat* X, const arma::vec* v);
 
-double LogLikelihoodNull(const arma::mat* X, const arma::vec* Y, std::string Dist);
+arma::vec CrossProdCpp(const ChunkedMatrix* X, const arma::vec* v);
 
-double LogLikelihoodSat(const arma::mat* X, const arma::vec* Y, std::string Dist);
+arma::vec CrossProdCpp(const arma::sp_mat* X, const arma::vec* v);
+
+void CrossProdCpp(const arma::mat* X, const arma::vec* v, arma::vec* out);
+
+void CrossProdCpp(const ChunkedMatrix* X, const arma::vec* v, arma::vec* out);
+
+void CrossProdCpp(const arma::sp_mat* X, const arma::vec* v, arma::vec* out);
+
+arma::mat GramCpp(const arma::mat* X, unsigned int nthreads);
+
+arma::mat GramCpp(const ChunkedMatrix* X, unsigned int nthreads);
+
+arma::mat GramCpp(const arma::sp_mat* X, unsigned int nthreads);
+
+template<typename T>
+arma::vec LinkCpp(const T* X, arma::vec* beta, const arma::vec* Offset, 
+                  GLMFamily Family);
+
+template<typename T>
+arma::vec DerivativeCpp(const T* X, arma::vec* beta, const arma::vec* Offset,
+                        arma::vec* mu, GLMFamily Family);
+
+arma::vec Variance(arma::vec* mu, GLMFamily Family);
+
+double LogLikelihoodCpp(const arma::vec* Y, arma::vec* mu, GLMFamily Family);
+
+double LogLikelihoodNull(const arma::mat* X, const arma::vec* Y, GLMFamily Family);
+
+double LogLikelihoodSat(const arma::vec* Y, GLMFamily Family);
+
+template<typename T>
+double IRLSCpp(const T* X, const arma::vec* Y, const arma::vec* Offset, 
+               arma::vec* beta, arma::vec* mu, arma::vec* w, arma::vec* r, 
+               GLMFamily Family);
+
+arma::vec WeightedScoreCpp(const arma::mat* X, const arma::vec* r);
+
+arma::vec WeightedScoreCpp(const ChunkedMatrix* X, const arma::vec* r);
+
+arma::vec WeightedScoreCpp(const arma::sp_mat* X, const arma::vec* r);
+
+arma::mat WeightedInfoCpp(const arma::mat* X, const arma::vec* w);
+
+arma::mat WeightedInfoCpp(const ChunkedMatrix* X, const arma::vec* w);
+
+arma::mat WeightedInfoCpp(const arma::sp_mat* X, const arma::vec* w);
+
+arma::vec WeightedInfoDiagCpp(const arma::mat* X, const arma::vec* w);
+
+arma::vec WeightedInfoDiagCpp(const ChunkedMatrix* X, const arma::vec* w);
+
+arma::vec WeightedInfoDiagCpp(const arma::sp_mat* X, const arma::vec* w);
 
 arma::vec ScoreCpp(const arma::mat* X, const arma::vec* Y, arma::vec* Deriv,
                    arma::vec* Var, arma::vec* mu);
 
-arma::mat FisherInfoCpp(const arma::mat* X, arma::vec* Deriv, 
+template<typename T>
+arma::mat FisherInfoCpp(const T* X, arma::vec* Deriv, 
                         arma::vec* Var);
 
-arma::vec LBFGSHelperCpp(arma::vec* g1, arma::mat* s, arma::mat* y, 
-                         int* k, unsigned int* m, 
-                         arma::vec* r, arma::vec* alpha, const arma::mat* Info);
+void LBFGSDirectionCpp(const arma::vec* g, const arma::mat* s, const arma::mat* y, 
+                       const arma::vec* rho, int k, int m, const arma::vec* Diag, 
+                       arma::vec* q, arma::vec* alpha, arma::vec* p);
 
-int LBFGSGLMCpp(arma::vec* beta, const arma::mat* X, 
+template<typename T>
+int LBFGSGLMCpp(arma::vec* beta, const T* X, 
                    const arma::vec* Y, const arma::vec* Offset,
-                   std::string Link, std::string Dist, 
+                   GLMFamily Family, 
                    double tol, int maxit, int m = 5);
 
-int BFGSGLMCpp(arma::vec* beta, const arma::mat* X, 
+template<typename T>
+int BFGSGLMCpp(arma::vec* beta, const T* X, 
                   const arma::vec* Y, const arma::vec* Offset,
-                  std::string Link, std::string Dist,
+                  GLMFamily Family,
                   double tol, int maxit);
 
-int FisherScoringGLMCpp(arma::vec* beta, const arma::mat* X, 
+template<typename T>
+int FisherScoringGLMCpp(arma::vec* beta, const T* X, 
                                const arma::vec* Y, const arma::vec* Offset,
-                               std::string Link, std::string Dist,
+                               GLMFamily Family,
                                double tol, int maxit);
 
 List BranchGLMFitCpp(const arma::mat* X, const arma::vec* Y, const arma::vec* Offset,
-                std::string method,  unsigned int m, std::string Link, std::string Dist,
+                std::string method,  unsigned int m, GLMFamily Family,
                 unsigned int nthreads, double tol, int maxit, bool GetInit = true);
 
 int LinRegCppShort(arma::vec* beta, const arma::mat* x, const arma::mat* y,
               const arma::vec* offset);
 
-double GetDispersion(const arma::mat* X, const arma::vec* Y, 
-                     arma::vec* mu, double LogLik, std::string Dist, 
-                     double tol);
+double GetDispersion(const arma::vec* Y, arma::vec* mu, double LogLik, 
+                     GLMFamily Family, double tol);
 
 void getInit(arma::vec* beta, const arma::mat* X, const arma::vec* Y, 
-             const arma::vec* Offset, std::string Dist, std::string Link);
+             const arma::vec* Offset, GLMFamily Family);
 
 #endif
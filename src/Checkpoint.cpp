@@ -0,0 +1,303 @@
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "VariableSelection.h"
+#include "Checkpoint.h"
+using namespace Rcpp;
+
+// Checkpoint files start with this string followed by the format version
+static const char CheckpointMagic[8] = {'B', 'G', 'L', 'M', 'C', 'K', 'P', 'T'};
+static const uint32_t CheckpointVersion = 2;
+
+// Makes a node from the arguments of a call to one of the branching functions
+BranchNode MakeNode(const arma::ivec* CurModel, const arma::uvec* NewOrder,
+                    unsigned int cur, int maxsize, double LowerBound,
+                    const arma::vec* Init, bool Forward, double Metric){
+  BranchNode Node;
+  Node.CurModel = *CurModel;
+  Node.NewOrder = *NewOrder;
+  Node.cur = cur;
+  Node.maxsize = maxsize;
+  Node.LowerBound = LowerBound;
+  Node.Metric = Metric;
+  Node.Forward = Forward;
+  if(Init != nullptr){
+    Node.Init = *Init;
+  }
+  return(Node);
+}
+
+// Checks if a checkpoint is due, once it is due the search stays suspended 
+// until Restart is called
+bool SearchFrontier::Due(){
+  bool temp;
+#pragma omp atomic read
+  temp = due;
+  if(!temp && std::chrono::duration<double>(std::chrono::steady_clock::now() - 
+     last).count() >= interval){
+#pragma omp atomic write
+    due = true;
+    temp = true;
+  }
+  return(temp);
+}
+
+// Checks if a node that is reached should be added to the queue instead of 
+// being expanded, at least one node is expanded after each restart so the 
+// search keeps moving when checkpoints are written often
+bool SearchFrontier::Suspend(){
+  if(p->interrupted()){
+    return(true);
+  }
+  unsigned long long n;
+#pragma omp atomic capture
+  n = started++;
+  return(n > 0 && Due());
+}
+
+// Adds a node to the queue, this is called by the tasks searching the tree
+void SearchFrontier::Add(BranchNode Node){
+#pragma omp critical(Frontier)
+  Queue->push(Node);
+}
+
+// Continues the search after a checkpoint has been written
+void SearchFrontier::Restart(){
+  due = false;
+  started = 0;
+  last = std::chrono::steady_clock::now();
+}
+
+// Hashes the values that identify a search, so checkpoint files aren't resumed
+// with different data, family, link, or type of search
+// This is the 64 bit FNV-1a hash of the bytes of each value
+static void HashBytes(uint64_t* hash, const void* x, size_t n){
+  const unsigned char* bytes = static_cast<const unsigned char*>(x);
+  for(size_t i = 0; i < n; i++){
+    *hash ^= bytes[i];
+    *hash *= 1099511628211ULL;
+  }
+}
+
+uint64_t SearchKey(const arma::vec* Y, const arma::vec* Offset, unsigned int p,
+                   std::string Dist, std::string Link, std::string type){
+  uint64_t hash = 14695981039346656037ULL;
+  uint64_t dims[2] = {Y->n_elem, p};
+  HashBytes(&hash, dims, sizeof(dims));
+  HashBytes(&hash, Y->memptr(), sizeof(double) * Y->n_elem);
+  HashBytes(&hash, Offset->memptr(), sizeof(double) * Offset->n_elem);
+  std::string names = Dist + "/" + Link + "/" + type;
+  HashBytes(&hash, names.data(), names.size());
+  return(hash);
+}
+
+// Functions used to write and read values in binary
+template<typename T>
+void WriteValue(std::ofstream* out, T val){
+  out->write(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+template<typename T>
+T ReadValue(std::ifstream* in){
+  T val;
+  in->read(reinterpret_cast<char*>(&val), sizeof(T));
+  if(!(*in)){
+    stop("checkpoint file is incomplete");
+  }
+  return(val);
+}
+
+// Vectors are written as their length followed by their elements, the
+// elements are converted to type T
+template<typename T, typename V>
+void WriteVector(std::ofstream* out, const V* x){
+  WriteValue<uint64_t>(out, x->n_elem);
+  for(unsigned int i = 0; i < x->n_elem; i++){
+    WriteValue<T>(out, x->at(i));
+  }
+}
+
+// The length is checked against maxn before memory is allocated for the vector
+template<typename T, typename V>
+void ReadVector(std::ifstream* in, V* x, uint64_t maxn){
+  uint64_t n = ReadValue<uint64_t>(in);
+  if(n > maxn){
+    stop("checkpoint file was written by a different search");
+  }
+  x->set_size(n);
+  for(unsigned int i = 0; i < n; i++){
+    x->at(i) = ReadValue<T>(in);
+  }
+}
+
+// Writes the state of a best-first search to a file
+// The state is written to a temporary file which then replaces the old
+// checkpoint, so the old checkpoint is kept if writing fails part way through
+bool SaveCheckpoint(std::string file, const NodeQueue* Queue,
+                    const arma::mat* BestModels, const arma::vec* BestMetrics,
+                    unsigned long long numchecked, const Progress* p,
+                    const arma::vec* pen, double cutoff, uint64_t key){
+
+  std::string tempfile = file + ".tmp";
+  std::ofstream out(tempfile.c_str(), std::ios::binary | std::ios::trunc);
+  if(!out){
+    return(false);
+  }
+
+  // Writing header, the key, penalties, and cutoff are used to check that a
+  // checkpoint is resumed with the same search
+  out.write(CheckpointMagic, sizeof(CheckpointMagic));
+  WriteValue<uint32_t>(&out, CheckpointVersion);
+  WriteValue<uint64_t>(&out, key);
+  WriteVector<double>(&out, pen);
+  WriteValue<double>(&out, cutoff);
+
+  // Writing progress and the best models
+  double size, err;
+  p->getstate(&size, &err);
+  WriteValue<uint64_t>(&out, numchecked);
+  WriteValue<double>(&out, size);
+  WriteValue<double>(&out, err);
+  WriteValue<uint64_t>(&out, BestModels->n_rows);
+  WriteValue<uint64_t>(&out, BestModels->n_cols);
+  out.write(reinterpret_cast<const char*>(BestModels->memptr()),
+            sizeof(double) * BestModels->n_elem);
+  WriteVector<double>(&out, BestMetrics);
+
+  // Writing open nodes
+  const std::vector<BranchNode>* Nodes = Queue->nodes();
+  WriteValue<uint64_t>(&out, Nodes->size());
+  for(unsigned int i = 0; i < Nodes->size(); i++){
+    const BranchNode* Node = &Nodes->at(i);
+    WriteValue<uint32_t>(&out, Node->cur);
+    WriteValue<int32_t>(&out, Node->maxsize);
+    WriteValue<double>(&out, Node->LowerBound);
+    WriteValue<double>(&out, Node->Metric);
+    WriteValue<uint8_t>(&out, Node->Forward);
+    WriteVector<int32_t>(&out, &Node->CurModel);
+    WriteVector<uint32_t>(&out, &Node->NewOrder);
+    WriteVector<double>(&out, &Node->Init);
+  }
+
+  out.close();
+  if(!out){
+    std::remove(tempfile.c_str());
+    return(false);
+  }
+
+  // Replacing old checkpoint, rename doesn't replace existing files on windows
+  std::remove(file.c_str());
+  return(std::rename(tempfile.c_str(), file.c_str()) == 0);
+}
+
+// Writes each open node to its own checkpoint file, file_1, file_2, ..., so
+// that the nodes can be searched by separate processes
+// Only the first file has the best models and the number of models checked,
+// so they aren't counted more than once when the results are combined
+unsigned int SplitCheckpoint(std::string file, const NodeQueue* Queue,
+                             const arma::mat* BestModels, const arma::vec* BestMetrics,
+                             unsigned long long numchecked, const Progress* p,
+                             const arma::vec* pen, double cutoff, uint64_t key){
+
+  // Creating empty set of best models for the other files
+  unsigned int ncols = cutoff < 0 ? BestMetrics->n_elem : 1;
+  arma::mat EmptyModels(BestModels->n_rows, ncols, arma::fill::zeros);
+  arma::vec EmptyMetrics(ncols);
+  EmptyMetrics.fill(arma::datum::inf);
+  Progress Empty(1, false);
+
+  const std::vector<BranchNode>* Nodes = Queue->nodes();
+  for(unsigned int i = 0; i < Nodes->size(); i++){
+    NodeQueue Part;
+    Part.push(Nodes->at(i));
+    std::string partfile = file + "_" + std::to_string(i + 1);
+    bool Success;
+    if(i == 0){
+      Success = SaveCheckpoint(partfile, &Part, BestModels, BestMetrics,
+                               numchecked, p, pen, cutoff, key);
+    }else{
+      Success = SaveCheckpoint(partfile, &Part, &EmptyModels, &EmptyMetrics,
+                               0, &Empty, pen, cutoff, key);
+    }
+    if(!Success){
+      stop("could not write checkpoint file");
+    }
+  }
+  return(Nodes->size());
+}
+
+// Reads the state of a search from a file written by SaveCheckpoint
+// Every node is checked before it is added to the queue, so a file from a 
+// different search can't make the branching functions index out of bounds
+void LoadCheckpoint(std::string file, NodeQueue* Queue,
+                    arma::mat* BestModels, arma::vec* BestMetrics,
+                    unsigned long long* numchecked, Progress* p,
+                    const arma::vec* pen, double cutoff, uint64_t key){
+
+  std::ifstream in(file.c_str(), std::ios::binary);
+  if(!in){
+    stop("could not open checkpoint file");
+  }
+
+  // Checking header
+  char magic[sizeof(CheckpointMagic)];
+  in.read(magic, sizeof(magic));
+  if(!in || !std::equal(magic, magic + sizeof(magic), CheckpointMagic)){
+    stop("supplied file is not a checkpoint file");
+  }
+  if(ReadValue<uint32_t>(&in) != CheckpointVersion){
+    stop("checkpoint file was written by a different version of BranchGLM");
+  }
+  if(ReadValue<uint64_t>(&in) != key){
+    stop("checkpoint file was written by a search with different data or a different type");
+  }
+  arma::vec pen2;
+  ReadVector<double>(&in, &pen2, pen->n_elem);
+  double cutoff2 = ReadValue<double>(&in);
+  if(pen2.n_elem != pen->n_elem || any(pen2 != *pen) || cutoff2 != cutoff){
+    stop("checkpoint file was written by a different search");
+  }
+
+  // Reading progress and the best models
+  *numchecked = ReadValue<uint64_t>(&in);
+  double size = ReadValue<double>(&in);
+  double err = ReadValue<double>(&in);
+  p->setstate(size, err);
+  uint64_t nrows = ReadValue<uint64_t>(&in);
+  uint64_t ncols = ReadValue<uint64_t>(&in);
+  if(nrows != BestModels->n_rows || (cutoff < 0 && ncols != BestModels->n_cols) || 
+     ncols > std::max<uint64_t>(*numchecked, BestModels->n_cols)){
+    stop("checkpoint file was written by a different search");
+  }
+  BestModels->set_size(nrows, ncols);
+  in.read(reinterpret_cast<char*>(BestModels->memptr()),
+          sizeof(double) * BestModels->n_elem);
+  ReadVector<double>(&in, BestMetrics, ncols);
+  if(!in || BestMetrics->n_elem != ncols){
+    stop("checkpoint file is incomplete");
+  }
+
+  // Reading open nodes
+  uint64_t nnodes = ReadValue<uint64_t>(&in);
+  for(uint64_t i = 0; i < nnodes; i++){
+    BranchNode Node;
+    Node.cur = ReadValue<uint32_t>(&in);
+    Node.maxsize = ReadValue<int32_t>(&in);
+    Node.LowerBound = ReadValue<double>(&in);
+    Node.Metric = ReadValue<double>(&in);
+    Node.Forward = ReadValue<uint8_t>(&in) != 0;
+    ReadVector<int32_t>(&in, &Node.CurModel, pen->n_elem);
+    ReadVector<uint32_t>(&in, &Node.NewOrder, pen->n_elem);
+    ReadVector<double>(&in, &Node.Init, nrows);
+    if(Node.CurModel.n_elem != pen->n_elem || any(Node.CurModel < -1) || 
+       any(Node.CurModel > 1) || any(Node.NewOrder >= pen->n_elem) || 
+       Node.cur >= Node.NewOrder.n_elem || 
+       (Node.Init.n_elem != 0 && Node.Init.n_elem != nrows)){
+      stop("checkpoint file was written by a different search");
+    }
+    Queue->push(Node);
+  }
+}
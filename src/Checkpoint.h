@@ -0,0 +1,88 @@
+#ifndef Checkpoint_H
+#define Checkpoint_H
+
+#include <RcppArmadillo.h>
+#include <chrono>
+#include <cstdint>
+#include <queue>
+#include <vector>
+#include "VariableSelection.h"
+using namespace Rcpp;
+
+// Node of the branch and bound tree that has not been searched yet, these are
+// stored by the best-first search and written to checkpoint files
+// Forward is false for nodes of the backward searches, Metric is the metric
+// value of the model at the other end of the set of models for the switch search
+struct BranchNode{
+  arma::ivec CurModel;
+  arma::uvec NewOrder;
+  unsigned int cur;
+  int maxsize;
+  double LowerBound;
+  double Metric = 0;
+  bool Forward = true;
+  arma::vec Init;
+};
+
+BranchNode MakeNode(const arma::ivec* CurModel, const arma::uvec* NewOrder,
+                    unsigned int cur, int maxsize, double LowerBound,
+                    const arma::vec* Init, bool Forward = true, double Metric = 0);
+
+// Orders nodes so that the node with the smallest lower bound is on top
+struct CompareNodes{
+  bool operator()(const BranchNode& a, const BranchNode& b) const{
+    return(a.LowerBound > b.LowerBound);
+  }
+};
+
+// Queue of open nodes, the nodes can be read directly so they can be written
+// to a checkpoint file without emptying the queue
+class NodeQueue : public std::priority_queue<BranchNode, std::vector<BranchNode>,
+                                             CompareNodes>{
+public:
+  const std::vector<BranchNode>* nodes() const{
+    return(&c);
+  }
+};
+
+// Suspends a search so its state can be written to a checkpoint file
+// Once a checkpoint is due or the search is interrupted, nodes that are reached
+// are added to Queue instead of being expanded, while nodes that were already
+// being expanded are finished. So once every task has returned, Queue holds the
+// part of the tree that is left and each model that was checked is counted once
+class SearchFrontier{
+private:
+  double interval;
+  Progress* p;
+  bool due = false;
+  unsigned long long started = 0;
+  std::chrono::steady_clock::time_point last;
+public:
+  NodeQueue* Queue;
+  SearchFrontier(NodeQueue* Queue, double interval, Progress* p):
+  interval(interval), p(p), last(std::chrono::steady_clock::now()), Queue(Queue){}
+  bool Due();
+  bool Suspend();
+  void Add(BranchNode Node);
+  void Restart();
+};
+
+uint64_t SearchKey(const arma::vec* Y, const arma::vec* Offset, unsigned int p,
+                   std::string Dist, std::string Link, std::string type);
+
+bool SaveCheckpoint(std::string file, const NodeQueue* Queue,
+                    const arma::mat* BestModels, const arma::vec* BestMetrics,
+                    unsigned long long numchecked, const Progress* p,
+                    const arma::vec* pen, double cutoff, uint64_t key);
+
+unsigned int SplitCheckpoint(std::string file, const NodeQueue* Queue,
+                             const arma::mat* BestModels, const arma::vec* BestMetrics,
+                             unsigned long long numchecked, const Progress* p,
+                             const arma::vec* pen, double cutoff, uint64_t key);
+
+void LoadCheckpoint(std::string file, NodeQueue* Queue,
+                    arma::mat* BestModels, arma::vec* BestMetrics,
+                    unsigned long long* numchecked, Progress* p,
+                    const arma::vec* pen, double cutoff, uint64_t key);
+
+#endif
@@ -0,0 +1,281 @@
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cmath>
+#include "ChunkedMatrix.h"
+#include "CrossProducts.h"
+#include "ThreadPolicy.h"
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+using namespace Rcpp;
+
+// Splits the rows of X into blocks of chunksize rows and adds them to the end
+// of the matrix, each column of a block is compressed separately
+void ChunkedMatrix::Append(const arma::mat* X){
+  if(X->n_cols != n_cols){
+    stop("the number of columns in each chunk must be the same");
+  }
+
+  for(unsigned int start = 0; start < X->n_rows; start += chunksize){
+    Chunk NewChunk;
+    NewChunk.start = n_rows + start;
+    NewChunk.rows = std::min((unsigned int)(X->n_rows - start), chunksize);
+    NewChunk.Cols.resize(n_cols);
+
+    for(unsigned int j = 0; j < n_cols; j++){
+      const double* xcol = X->colptr(j) + start;
+      ChunkColumn* Col = &NewChunk.Cols.at(j);
+
+      // Checking if the column is constant or only has zeros and ones
+      bool constant = true;
+      bool binary = true;
+      size_t count = 0;
+      for(unsigned int i = 0; i < NewChunk.rows; i++){
+        constant = constant && xcol[i] == xcol[0];
+        binary = binary && (xcol[i] == 0 || xcol[i] == 1);
+        count += xcol[i] == 1;
+      }
+
+      // Storing column
+      if(constant){
+        Col->Type = ColType::constant;
+        Col->Begin = NewChunk.Dense.size();
+        Col->Count = 1;
+        NewChunk.Dense.push_back(xcol[0]);
+      }else if(binary && 2 * count < NewChunk.rows){
+        Col->Type = ColType::ones;
+        Col->Begin = NewChunk.Ones.size();
+        Col->Count = count;
+        for(unsigned int i = 0; i < NewChunk.rows; i++){
+          if(xcol[i] == 1){
+            NewChunk.Ones.push_back(i);
+          }
+        }
+      }else if(UseFloat){
+        Col->Type = ColType::single;
+        Col->Begin = NewChunk.Single.size();
+        Col->Count = NewChunk.rows;
+        NewChunk.Single.insert(NewChunk.Single.end(), xcol, xcol + NewChunk.rows);
+      }else{
+        Col->Type = ColType::dense;
+        Col->Begin = NewChunk.Dense.size();
+        Col->Count = NewChunk.rows;
+        NewChunk.Dense.insert(NewChunk.Dense.end(), xcol, xcol + NewChunk.rows);
+      }
+    }
+
+    // Releasing extra capacity since the chunk is not changed again
+    NewChunk.Dense.shrink_to_fit();
+    NewChunk.Single.shrink_to_fit();
+    NewChunk.Ones.shrink_to_fit();
+    Chunks.push_back(std::move(NewChunk));
+  }
+  n_rows += X->n_rows;
+}
+
+unsigned int ChunkedMatrix::n_chunks() const{
+  return(Chunks.size());
+}
+
+// First row of X that is in block b
+unsigned int ChunkedMatrix::ChunkStart(unsigned int b) const{
+  return(Chunks.at(b).start);
+}
+
+unsigned int ChunkedMatrix::ChunkRows(unsigned int b) const{
+  return(Chunks.at(b).rows);
+}
+
+// Decodes a block of rows into the first rows of Block
+void ChunkedMatrix::GetChunk(unsigned int b, arma::mat* Block) const{
+  const Chunk* CurChunk = &Chunks.at(b);
+  for(unsigned int j = 0; j < n_cols; j++){
+    const ChunkColumn* Col = &CurChunk->Cols.at(j);
+    double* Blockcol = Block->colptr(j);
+    switch(Col->Type){
+    case ColType::constant:
+      std::fill(Blockcol, Blockcol + CurChunk->rows, CurChunk->Dense.at(Col->Begin));
+      break;
+    case ColType::ones:
+      std::fill(Blockcol, Blockcol + CurChunk->rows, 0.0);
+      for(size_t i = Col->Begin; i < Col->Begin + Col->Count; i++){
+        Blockcol[CurChunk->Ones[i]] = 1;
+      }
+      break;
+    case ColType::single:
+      std::copy(CurChunk->Single.begin() + Col->Begin,
+                CurChunk->Single.begin() + Col->Begin + Col->Count, Blockcol);
+      break;
+    default:
+      std::copy(CurChunk->Dense.begin() + Col->Begin,
+                CurChunk->Dense.begin() + Col->Begin + Col->Count, Blockcol);
+    }
+  }
+}
+
+// Calculates X * beta + Offset, the blocks are done in parallel since they
+// write to different rows of eta
+void ChunkedMatrix::LinPred(const arma::vec* beta, const arma::vec* Offset,
+                            arma::vec* eta) const{
+  *eta = *Offset;
+
+#pragma omp parallel for schedule(dynamic, 1) if(DataParallel(n_rows))
+  for(unsigned int b = 0; b < Chunks.size(); b++){
+    const Chunk* CurChunk = &Chunks.at(b);
+    double* etachunk = eta->memptr() + CurChunk->start;
+    for(unsigned int j = 0; j < n_cols; j++){
+      const ChunkColumn* Col = &CurChunk->Cols.at(j);
+      double betaj = beta->at(j);
+      if(betaj == 0){
+        continue;
+      }
+      switch(Col->Type){
+      case ColType::constant:{
+        double val = betaj * CurChunk->Dense[Col->Begin];
+        for(unsigned int i = 0; i < CurChunk->rows; i++){
+          etachunk[i] += val;
+        }
+        break;
+      }
+      case ColType::ones:
+        for(size_t i = Col->Begin; i < Col->Begin + Col->Count; i++){
+          etachunk[CurChunk->Ones[i]] += betaj;
+        }
+        break;
+      case ColType::single:{
+        const float* xcol = CurChunk->Single.data() + Col->Begin;
+        for(unsigned int i = 0; i < CurChunk->rows; i++){
+          etachunk[i] += betaj * xcol[i];
+        }
+        break;
+      }
+      default:{
+        const double* xcol = CurChunk->Dense.data() + Col->Begin;
+        for(unsigned int i = 0; i < CurChunk->rows; i++){
+          etachunk[i] += betaj * xcol[i];
+        }
+      }
+      }
+    }
+  }
+}
+
+// Calculates X'r
+arma::vec ChunkedMatrix::XTr(const arma::vec* r) const{
+  arma::vec FinalVec(n_cols, arma::fill::zeros);
+
+  // Each thread accumulates its blocks into its own vector
+#pragma omp parallel if(DataParallel(n_rows))
+{
+  arma::vec TempVec(n_cols, arma::fill::zeros);
+
+#pragma omp for schedule(dynamic, 1)
+  for(unsigned int b = 0; b < Chunks.size(); b++){
+    const Chunk* CurChunk = &Chunks.at(b);
+    const double* rchunk = r->memptr() + CurChunk->start;
+    for(unsigned int j = 0; j < n_cols; j++){
+      const ChunkColumn* Col = &CurChunk->Cols.at(j);
+      double temp = 0;
+      switch(Col->Type){
+      case ColType::constant:
+        for(unsigned int i = 0; i < CurChunk->rows; i++){
+          temp += rchunk[i];
+        }
+        temp *= CurChunk->Dense[Col->Begin];
+        break;
+      case ColType::ones:
+        for(size_t i = Col->Begin; i < Col->Begin + Col->Count; i++){
+          temp += rchunk[CurChunk->Ones[i]];
+        }
+        break;
+      case ColType::single:{
+        const float* xcol = CurChunk->Single.data() + Col->Begin;
+        for(unsigned int i = 0; i < CurChunk->rows; i++){
+          temp += xcol[i] * rchunk[i];
+        }
+        break;
+      }
+      default:{
+        const double* xcol = CurChunk->Dense.data() + Col->Begin;
+        for(unsigned int i = 0; i < CurChunk->rows; i++){
+          temp += xcol[i] * rchunk[i];
+        }
+      }
+      }
+      TempVec.at(j) += temp;
+    }
+  }
+
+#pragma omp critical
+  FinalVec += TempVec;
+}
+
+  return(FinalVec);
+}
+
+// Calculates X'WX, each block is decoded and then added with a symmetric
+// rank-k update
+arma::mat ChunkedMatrix::WeightedXTX(const arma::vec* w) const{
+
+  arma::mat FinalMat(n_cols, n_cols, arma::fill::zeros);
+  if(n_cols == 0){
+    return(FinalMat);
+  }
+
+  // Using all columns of each block
+  arma::uvec Cols(n_cols);
+  for(unsigned int j = 0; j < n_cols; j++){
+    Cols.at(j) = j;
+  }
+
+  // Each thread accumulates its blocks into its own matrix
+#pragma omp parallel if(DataParallel(n_rows))
+{
+  arma::mat Block(chunksize, n_cols);
+  arma::mat Buffer(chunksize, n_cols + 1);
+  arma::mat TempMat(n_cols, n_cols, arma::fill::zeros);
+
+#pragma omp for schedule(dynamic, 1)
+  for(unsigned int b = 0; b < Chunks.size(); b++){
+    const Chunk* CurChunk = &Chunks.at(b);
+    arma::mat CurBlock(Block.memptr(), CurChunk->rows, n_cols, false, true);
+    GetChunk(b, &CurBlock);
+    const arma::vec wchunk(const_cast<double*>(w->memptr()) + CurChunk->start,
+                           CurChunk->rows, false, true);
+    WeightedXTXBlock(&CurBlock, &Cols, &wchunk, &Buffer, &TempMat, 0);
+  }
+
+#pragma omp critical
+  FinalMat += TempMat;
+}
+
+  return(symmatu(FinalMat));
+}
+
+// Number of bytes used to store the blocks
+double ChunkedMatrix::Bytes() const{
+  double bytes = 0;
+  for(unsigned int b = 0; b < Chunks.size(); b++){
+    bytes += Chunks.at(b).Cols.size() * sizeof(ChunkColumn) +
+      Chunks.at(b).Dense.size() * sizeof(double) +
+      Chunks.at(b).Single.size() * sizeof(float) +
+      Chunks.at(b).Ones.size() * sizeof(uint32_t);
+  }
+  return(bytes);
+}
+
+// Creates an empty chunked matrix that rows are added to with AppendChunkCpp
+// [[Rcpp::export]]
+SEXP ChunkedMatrixCpp(unsigned int ncols, unsigned int chunksize, bool usefloat){
+  XPtr<ChunkedMatrix> ptr(new ChunkedMatrix(ncols, chunksize, usefloat), true);
+  return(ptr);
+}
+
+// Adds the rows of x to a chunked matrix
+// [[Rcpp::export]]
+double AppendChunkCpp(SEXP ptr, NumericMatrix x){
+  XPtr<ChunkedMatrix> Chunks(ptr);
+  const arma::mat X(x.begin(), x.rows(), x.cols(), false, true);
+  Chunks.checked_get()->Append(&X);
+  return(Chunks->Bytes());
+}
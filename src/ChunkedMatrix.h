@@ -0,0 +1,50 @@
+#ifndef ChunkedMatrix_H
+#define ChunkedMatrix_H
+
+#include <RcppArmadillo.h>
+#include <cstdint>
+#include <vector>
+using namespace Rcpp;
+
+// Design matrix stored as blocks of rows
+// Each column of a block is stored in the smallest form that represents it,
+// columns that are constant only store their value, 0/1 columns with few ones
+// such as the dummy variables from factors only store the rows that are one,
+// and the other columns are stored as doubles or as floats
+// The kernels stream through the blocks, so only one block of X is ever dense
+class ChunkedMatrix{
+public:
+  unsigned int n_rows;
+  unsigned int n_cols;
+  unsigned int chunksize;
+  bool UseFloat;
+  ChunkedMatrix(unsigned int n_cols, unsigned int chunksize, bool UseFloat):
+  n_rows(0), n_cols(n_cols), chunksize(chunksize), UseFloat(UseFloat){}
+  void Append(const arma::mat* X);
+  unsigned int n_chunks() const;
+  unsigned int ChunkStart(unsigned int b) const;
+  unsigned int ChunkRows(unsigned int b) const;
+  void GetChunk(unsigned int b, arma::mat* Block) const;
+  void LinPred(const arma::vec* beta, const arma::vec* Offset, arma::vec* eta) const;
+  arma::vec XTr(const arma::vec* r) const;
+  arma::mat WeightedXTX(const arma::vec* w) const;
+  double Bytes() const;
+private:
+  enum class ColType : uint8_t {constant, dense, single, ones};
+  struct ChunkColumn{
+    ColType Type;
+    size_t Begin;
+    size_t Count;
+  };
+  struct Chunk{
+    unsigned int start;
+    unsigned int rows;
+    std::vector<ChunkColumn> Cols;
+    std::vector<double> Dense;
+    std::vector<float> Single;
+    std::vector<uint32_t> Ones;
+  };
+  std::vector<Chunk> Chunks;
+};
+
+#endif
@@ -1,8 +1,14 @@
+#define USE_FC_LEN_T
 #include <RcppArmadillo.h>
+#include <R_ext/BLAS.h>
+#include "ThreadPolicy.h"
 #include <cmath>
 #ifdef _OPENMP
 # include <omp.h>
 #endif
+#ifndef FCONE
+# define FCONE
+#endif
 using namespace Rcpp;
 
 // Use this for parallel linear regression
@@ -11,7 +17,7 @@ arma::mat ParXTX(const arma::mat* x){
   arma::mat FinalMat(x->n_cols, x->n_cols);
   
   // Finding X'X
-#pragma omp parallel for schedule(dynamic, 1)
+#pragma omp parallel for schedule(dynamic, 1) if(DataParallel(x->n_rows))
   for(unsigned int i = 0; i < x->n_cols; i+=2){
     if(i == x->n_cols - 1){
       arma::vec temp = x->col(i);
@@ -115,3 +121,218 @@ arma::mat XTX(const arma::mat* x, unsigned int B = 16){
   return(symmatu(FinalMat));
 }
 
+// Adds the contribution of rows start to start + n - 1 to the upper triangle of X'WX
+// Only the columns of x in Cols are used, w holds the weights for these rows
+// Rows are scaled by sqrt(w) into the first columns of Buffer and then a symmetric 
+// rank-k update is done, the last column of Buffer holds sqrt(w) for the rows
+// x can be stored in single precision, the rows are widened to double as they are 
+// scaled since R's BLAS only has double precision routines
+template<typename eT>
+void WeightedXTXRowsHelper(const arma::Mat<eT>* x, const arma::uvec* Cols, 
+                           const double* w, arma::mat* Buffer, arma::mat* FinalMat, 
+                           unsigned int start, unsigned int n){
+  
+  unsigned int p = Cols->n_elem;
+  if(p == 0 || n == 0){
+    return;
+  }
+  
+  // Getting sqrt(w) for these rows
+  for(unsigned int i = 0; i < n; i++){
+    Buffer->at(i, p) = sqrt(w[i]);
+  }
+  
+  // Scaling rows by sqrt(w)
+  for(unsigned int j = 0; j < p; j++){
+    const eT* xcol = x->colptr(Cols->at(j)) + start;
+    for(unsigned int i = 0; i < n; i++){
+      Buffer->at(i, j) = xcol[i] * Buffer->at(i, p);
+    }
+  }
+  
+  // Updating upper triangle with dsyrk
+  int n1 = p;
+  int k = n;
+  int lda = Buffer->n_rows;
+  double one = 1;
+  F77_CALL(dsyrk)("U", "T", &n1, &k, &one, Buffer->memptr(), &lda, 
+           &one, FinalMat->memptr(), &n1 FCONE FCONE);
+}
+
+void WeightedXTXRows(const arma::mat* x, const arma::uvec* Cols, const double* w, 
+                     arma::mat* Buffer, arma::mat* FinalMat, unsigned int start, 
+                     unsigned int n){
+  WeightedXTXRowsHelper(x, Cols, w, Buffer, FinalMat, start, n);
+}
+
+void WeightedXTXRows(const arma::fmat* x, const arma::uvec* Cols, const double* w, 
+                     arma::mat* Buffer, arma::mat* FinalMat, unsigned int start, 
+                     unsigned int n){
+  WeightedXTXRowsHelper(x, Cols, w, Buffer, FinalMat, start, n);
+}
+
+// Adds the contribution of the block of rows starting at start to the upper 
+// triangle of X'WX, the block has as many rows as Buffer
+template<typename eT>
+void WeightedXTXBlockHelper(const arma::Mat<eT>* x, const arma::uvec* Cols, 
+                            const arma::vec* w, arma::mat* Buffer, 
+                            arma::mat* FinalMat, unsigned int start){
+  
+  // Getting rows for current block
+  unsigned int end = std::min(x->n_rows, start + Buffer->n_rows);
+  WeightedXTXRowsHelper(x, Cols, w->memptr() + start, Buffer, FinalMat, start, 
+                        end - start);
+}
+
+void WeightedXTXBlock(const arma::mat* x, const arma::uvec* Cols, const arma::vec* w, 
+                      arma::mat* Buffer, arma::mat* FinalMat, unsigned int start){
+  WeightedXTXBlockHelper(x, Cols, w, Buffer, FinalMat, start);
+}
+
+void WeightedXTXBlock(const arma::fmat* x, const arma::uvec* Cols, const arma::vec* w, 
+                      arma::mat* Buffer, arma::mat* FinalMat, unsigned int start){
+  WeightedXTXBlockHelper(x, Cols, w, Buffer, FinalMat, start);
+}
+
+// Use this for the fisher info with parallel computation
+arma::mat WeightedXTX(const arma::mat* x, const arma::vec* w, unsigned int B = 256){
+  
+  arma::mat FinalMat(x->n_cols, x->n_cols, arma::fill::zeros);
+  if(x->n_cols == 0){
+    return(FinalMat);
+  }
+  
+  // Using all columns of x and getting number of blocks
+  arma::uvec Cols(x->n_cols);
+  for(unsigned int j = 0; j < x->n_cols; j++){
+    Cols.at(j) = j;
+  }
+  unsigned int nblocks = (x->n_rows + B - 1) / B;
+  
+  // Each thread accumulates its blocks into its own matrix
+#pragma omp parallel if(DataParallel(x->n_rows))
+{
+  arma::mat Buffer(B, x->n_cols + 1);
+  arma::mat TempMat(x->n_cols, x->n_cols, arma::fill::zeros);
+  
+#pragma omp for schedule(static)
+  for(unsigned int b = 0; b < nblocks; b++){
+    WeightedXTXBlock(x, &Cols, w, &Buffer, &TempMat, b * B);
+  }
+  
+#pragma omp critical
+  FinalMat += TempMat;
+}
+  
+  return(symmatu(FinalMat));
+}
+
+// Use this for the fisher info without parallel computation, only the columns 
+// of x in Cols are used
+arma::mat ParWeightedXTX(const arma::mat* x, const arma::uvec* Cols, const arma::vec* w, 
+                         unsigned int B = 256){
+  
+  arma::mat FinalMat(Cols->n_elem, Cols->n_elem, arma::fill::zeros);
+  if(Cols->n_elem == 0){
+    return(FinalMat);
+  }
+  
+  // Initializing buffer for scaled rows
+  arma::mat Buffer(std::min(B, x->n_rows), Cols->n_elem + 1);
+  
+  // Accumulating blocks of rows
+  for(unsigned int start = 0; start < x->n_rows; start += Buffer.n_rows){
+    WeightedXTXBlock(x, Cols, w, &Buffer, &FinalMat, start);
+  }
+  
+  return(symmatu(FinalMat));
+}
+
+// Single precision version, this reads half as much memory as the double version
+arma::mat ParWeightedXTX(const arma::fmat* x, const arma::uvec* Cols, const arma::vec* w, 
+                         unsigned int B = 256){
+  
+  arma::mat FinalMat(Cols->n_elem, Cols->n_elem, arma::fill::zeros);
+  if(Cols->n_elem == 0){
+    return(FinalMat);
+  }
+  
+  // Initializing buffer for scaled rows
+  arma::mat Buffer(std::min(B, x->n_rows), Cols->n_elem + 1);
+  
+  // Accumulating blocks of rows
+  for(unsigned int start = 0; start < x->n_rows; start += Buffer.n_rows){
+    WeightedXTXBlock(x, Cols, w, &Buffer, &FinalMat, start);
+  }
+  
+  return(symmatu(FinalMat));
+}
+
+// Sets column j of the upper triangle of X'WX for a sparse x, only the columns 
+// of x in Cols are used
+// w * x_j is scattered into the dense vector wx, so each entry only costs the 
+// nonzero elements of one column, wx is all zeros again when this returns
+void SparseWeightedXTXCol(const arma::sp_mat* x, const arma::uvec* Cols, 
+                          const arma::vec* w, arma::vec* wx, arma::mat* FinalMat, 
+                          unsigned int j){
+  
+  // Scattering w * x_j
+  arma::uword col = Cols->at(j);
+  for(arma::uword k = x->col_ptrs[col]; k < x->col_ptrs[col + 1]; k++){
+    wx->at(x->row_indices[k]) = w->at(x->row_indices[k]) * x->values[k];
+  }
+  
+  // Getting x_i'Wx_j for i <= j
+  for(unsigned int i = 0; i <= j; i++){
+    arma::uword col2 = Cols->at(i);
+    double temp = 0;
+    for(arma::uword k = x->col_ptrs[col2]; k < x->col_ptrs[col2 + 1]; k++){
+      temp += x->values[k] * wx->at(x->row_indices[k]);
+    }
+    FinalMat->at(i, j) = temp;
+  }
+  
+  // Clearing wx
+  for(arma::uword k = x->col_ptrs[col]; k < x->col_ptrs[col + 1]; k++){
+    wx->at(x->row_indices[k]) = 0;
+  }
+}
+
+// Use this for the fisher info with a sparse x, the columns are done in parallel
+arma::mat WeightedXTX(const arma::sp_mat* x, const arma::vec* w){
+  
+  arma::mat FinalMat(x->n_cols, x->n_cols, arma::fill::zeros);
+  
+  // Using all columns of x
+  arma::uvec Cols(x->n_cols);
+  for(unsigned int j = 0; j < x->n_cols; j++){
+    Cols.at(j) = j;
+  }
+  
+  // Each thread has its own vector to scatter the columns into
+#pragma omp parallel if(DataParallel(x->n_nonzero))
+{
+  arma::vec wx(x->n_rows, arma::fill::zeros);
+  
+#pragma omp for schedule(dynamic, 1)
+  for(unsigned int j = 0; j < x->n_cols; j++){
+    SparseWeightedXTXCol(x, &Cols, w, &wx, &FinalMat, j);
+  }
+}
+  
+  return(symmatu(FinalMat));
+}
+
+// Use this for the fisher info with a sparse x without parallel computation, 
+// only the columns of x in Cols are used
+arma::mat ParWeightedXTX(const arma::sp_mat* x, const arma::uvec* Cols, 
+                         const arma::vec* w){
+  
+  arma::mat FinalMat(Cols->n_elem, Cols->n_elem, arma::fill::zeros);
+  arma::vec wx(x->n_rows, arma::fill::zeros);
+  for(unsigned int j = 0; j < Cols->n_elem; j++){
+    SparseWeightedXTXCol(x, Cols, w, &wx, &FinalMat, j);
+  }
+  
+  return(symmatu(FinalMat));
+}
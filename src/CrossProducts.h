@@ -8,4 +8,31 @@ arma::mat ParXTX(const arma::mat* x);
 
 arma::mat XTX(const arma::mat* x, unsigned int B = 16);
 
+void WeightedXTXRows(const arma::mat* x, const arma::uvec* Cols, const double* w, 
+                     arma::mat* Buffer, arma::mat* FinalMat, unsigned int start, 
+                     unsigned int n);
+
+void WeightedXTXRows(const arma::fmat* x, const arma::uvec* Cols, const double* w, 
+                     arma::mat* Buffer, arma::mat* FinalMat, unsigned int start, 
+                     unsigned int n);
+
+void WeightedXTXBlock(const arma::mat* x, const arma::uvec* Cols, const arma::vec* w, 
+                      arma::mat* Buffer, arma::mat* FinalMat, unsigned int start);
+
+void WeightedXTXBlock(const arma::fmat* x, const arma::uvec* Cols, const arma::vec* w, 
+                      arma::mat* Buffer, arma::mat* FinalMat, unsigned int start);
+
+arma::mat WeightedXTX(const arma::mat* x, const arma::vec* w, unsigned int B = 256);
+
+arma::mat ParWeightedXTX(const arma::mat* x, const arma::uvec* Cols, const arma::vec* w, 
+                         unsigned int B = 256);
+
+arma::mat ParWeightedXTX(const arma::fmat* x, const arma::uvec* Cols, const arma::vec* w, 
+                         unsigned int B = 256);
+
+arma::mat WeightedXTX(const arma::sp_mat* x, const arma::vec* w);
+
+arma::mat ParWeightedXTX(const arma::sp_mat* x, const arma::uvec* Cols, 
+                         const arma::vec* w);
+
 #endif
@@ -0,0 +1,476 @@
+#ifndef GLMFamily_H
+#define GLMFamily_H
+
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <cfloat>
+#include "VecMath.h"
+using namespace Rcpp;
+
+// Distributions and links supported by the fitting functions
+enum class GLMDist {gaussian, binomial, poisson, gamma};
+enum class GLMLink {identity, log, logit, probit, cloglog, inverse, sqrt};
+
+// Family and link for a model, this is resolved once from the strings
+// supplied by R and then passed by value to the fitting functions
+struct GLMFamily{
+  GLMDist Dist;
+  GLMLink Link;
+};
+
+// Converts the family and link strings from R into a GLMFamily
+inline GLMFamily GetFamily(std::string Dist, std::string Link){
+  GLMFamily Family;
+
+  // Getting distribution
+  if(Dist == "gaussian"){
+    Family.Dist = GLMDist::gaussian;
+  }
+  else if(Dist == "binomial"){
+    Family.Dist = GLMDist::binomial;
+  }
+  else if(Dist == "poisson"){
+    Family.Dist = GLMDist::poisson;
+  }
+  else if(Dist == "gamma"){
+    Family.Dist = GLMDist::gamma;
+  }
+  else{
+    stop("the supplied family is not supported");
+  }
+
+  // Getting link
+  if(Link == "identity"){
+    Family.Link = GLMLink::identity;
+  }
+  else if(Link == "log"){
+    Family.Link = GLMLink::log;
+  }
+  else if(Link == "logit"){
+    Family.Link = GLMLink::logit;
+  }
+  else if(Link == "probit"){
+    Family.Link = GLMLink::probit;
+  }
+  else if(Link == "cloglog"){
+    Family.Link = GLMLink::cloglog;
+  }
+  else if(Link == "inverse"){
+    Family.Link = GLMLink::inverse;
+  }
+  else if(Link == "sqrt"){
+    Family.Link = GLMLink::sqrt;
+  }
+  else{
+    stop("the supplied link is not supported");
+  }
+
+  return(Family);
+}
+
+// Checks for linear regression, which is fit by solving the normal equations
+inline bool IsLinReg(GLMFamily Family){
+  return(Family.Dist == GLMDist::gaussian && Family.Link == GLMLink::identity);
+}
+
+// Number of observations handled at a time by the kernels, the vectorized math 
+// functions are called once per block
+const unsigned int VecBlock = 256;
+
+// Distribution policies
+// Each one gives the bounds for mu, the variance function, and the contribution
+// of a single observation to the negative log-likelihood
+// LogLikBlock gives the sum of the contributions for a block of observations, 
+// tmp has room for n values
+template<class D>
+struct ScalarDistBlocks{
+  static double LogLikBlock(const double* y, const double* mu, double* tmp, 
+                            unsigned int n){
+    double LogLik = 0;
+    for(unsigned int i = 0; i < n; i++){
+      LogLik += D::LogLik(y[i], mu[i]);
+    }
+    return(LogLik);
+  }
+};
+
+struct GaussianDist : ScalarDistBlocks<GaussianDist>{
+  static double Bound(double mu){
+    return(mu);
+  }
+  static double Var(double mu){
+    return(1);
+  }
+  static double LogLik(double y, double mu){
+    return(pow(y - mu, 2) / 2);
+  }
+};
+
+struct BinomialDist : ScalarDistBlocks<BinomialDist>{
+  static double Bound(double mu){
+    if(mu <= 0){mu = FLT_EPSILON;}
+    else if(mu >= 1){mu = 1 - FLT_EPSILON;}
+    return(mu);
+  }
+  static double Var(double mu){
+    return(mu * (1 - mu));
+  }
+  static double LogLik(double y, double mu){
+    return(-y * log(mu) - (1 - y) * log1p(-mu));
+  }
+  static double LogLikBlock(const double* y, const double* mu, double* tmp, 
+                            unsigned int n){
+    double LogLik = 0;
+    VecLog(mu, tmp, n);
+    for(unsigned int i = 0; i < n; i++){
+      LogLik -= y[i] * tmp[i];
+      tmp[i] = -mu[i];
+    }
+    VecLog1p(tmp, tmp, n);
+    for(unsigned int i = 0; i < n; i++){
+      LogLik -= (1 - y[i]) * tmp[i];
+    }
+    return(LogLik);
+  }
+};
+
+struct PoissonDist : ScalarDistBlocks<PoissonDist>{
+  static double Bound(double mu){
+    if(mu <= 0){mu = FLT_EPSILON;}
+    return(mu);
+  }
+  static double Var(double mu){
+    return(mu);
+  }
+  static double LogLik(double y, double mu){
+    return(-y * log(mu) + mu);
+  }
+  static double LogLikBlock(const double* y, const double* mu, double* tmp, 
+                            unsigned int n){
+    double LogLik = 0;
+    VecLog(mu, tmp, n);
+    for(unsigned int i = 0; i < n; i++){
+      LogLik += -y[i] * tmp[i] + mu[i];
+    }
+    return(LogLik);
+  }
+};
+
+struct GammaDist : ScalarDistBlocks<GammaDist>{
+  static double Bound(double mu){
+    if(mu <= 0){mu = FLT_EPSILON;}
+    return(mu);
+  }
+  static double Var(double mu){
+    return(pow(mu, 2));
+  }
+  static double LogLik(double y, double mu){
+    double theta = -1 / mu;
+    return(-y * theta - log(-theta));
+  }
+  static double LogLikBlock(const double* y, const double* mu, double* tmp, 
+                            unsigned int n){
+    double LogLik = 0;
+    VecLog(mu, tmp, n);
+    for(unsigned int i = 0; i < n; i++){
+      LogLik += y[i] / mu[i] + tmp[i];
+    }
+    return(LogLik);
+  }
+};
+
+// Link policies
+// Each one gives the inverse link and the derivative of mu with respect to the
+// linear predictor, the derivative is given both the linear predictor and mu
+// MuBlock and DerivBlock do the same for a block of observations, links with 
+// transcendental functions replace these with ones using the vectorized math 
+// functions, eta may be the same as mu
+template<class L>
+struct ScalarLinkBlocks{
+  static void MuBlock(const double* eta, double* mu, unsigned int n){
+    for(unsigned int i = 0; i < n; i++){
+      mu[i] = L::Mu(eta[i]);
+    }
+  }
+  static void DerivBlock(const double* eta, const double* mu, double* Deriv, 
+                         unsigned int n){
+    for(unsigned int i = 0; i < n; i++){
+      Deriv[i] = L::Deriv(eta[i], mu[i]);
+    }
+  }
+};
+
+struct IdentityLink : ScalarLinkBlocks<IdentityLink>{
+  static double Mu(double eta){
+    return(eta);
+  }
+  static double Deriv(double eta, double mu){
+    return(1);
+  }
+};
+
+struct LogLink : ScalarLinkBlocks<LogLink>{
+  static double Mu(double eta){
+    return(exp(eta));
+  }
+  static double Deriv(double eta, double mu){
+    return(mu);
+  }
+  static void MuBlock(const double* eta, double* mu, unsigned int n){
+    VecExp(eta, mu, n);
+  }
+};
+
+struct LogitLink : ScalarLinkBlocks<LogitLink>{
+  static double Mu(double eta){
+    return(1 / (1 + exp(-eta)));
+  }
+  static void MuBlock(const double* eta, double* mu, unsigned int n){
+    for(unsigned int i = 0; i < n; i++){
+      mu[i] = -eta[i];
+    }
+    VecExp(mu, mu, n);
+    for(unsigned int i = 0; i < n; i++){
+      mu[i] = 1 / (1 + mu[i]);
+    }
+  }
+  static double Deriv(double eta, double mu){
+    return(mu * (1 - mu));
+  }
+};
+
+struct ProbitLink : ScalarLinkBlocks<ProbitLink>{
+  static double Mu(double eta){
+    return(arma::normcdf(eta));
+  }
+  static double Deriv(double eta, double mu){
+    return(arma::normpdf(eta));
+  }
+  static void MuBlock(const double* eta, double* mu, unsigned int n){
+    VecNormCdf(eta, mu, n);
+  }
+  static void DerivBlock(const double* eta, const double* mu, double* Deriv, 
+                         unsigned int n){
+    for(unsigned int i = 0; i < n; i++){
+      Deriv[i] = -eta[i] * eta[i] / 2;
+    }
+    VecExp(Deriv, Deriv, n);
+    for(unsigned int i = 0; i < n; i++){
+      Deriv[i] *= 0.398942280401432677939946059934;
+    }
+  }
+};
+
+struct CloglogLink : ScalarLinkBlocks<CloglogLink>{
+  static double Mu(double eta){
+    return(1 - exp(-exp(eta)));
+  }
+  static double Deriv(double eta, double mu){
+    return(-(1 - mu) * log(1 - mu));
+  }
+  static void MuBlock(const double* eta, double* mu, unsigned int n){
+    VecExp(eta, mu, n);
+    for(unsigned int i = 0; i < n; i++){
+      mu[i] = -mu[i];
+    }
+    VecExp(mu, mu, n);
+    for(unsigned int i = 0; i < n; i++){
+      mu[i] = 1 - mu[i];
+    }
+  }
+  static void DerivBlock(const double* eta, const double* mu, double* Deriv, 
+                         unsigned int n){
+    for(unsigned int i = 0; i < n; i++){
+      Deriv[i] = 1 - mu[i];
+    }
+    VecLog(Deriv, Deriv, n);
+    for(unsigned int i = 0; i < n; i++){
+      Deriv[i] *= -(1 - mu[i]);
+    }
+  }
+};
+
+struct InverseLink : ScalarLinkBlocks<InverseLink>{
+  static double Mu(double eta){
+    return(1 / eta);
+  }
+  static double Deriv(double eta, double mu){
+    return(-pow(mu, 2));
+  }
+};
+
+struct SqrtLink : ScalarLinkBlocks<SqrtLink>{
+  static double Mu(double eta){
+    return(pow(eta, 2));
+  }
+  static double Deriv(double eta, double mu){
+    return(2 * sqrt(mu));
+  }
+};
+
+// Kernels instantiated for each distribution and link combination
+// parallel is used to decide whether the loop is split among OpenMP threads
+// The observations are handled in blocks of VecBlock, each thread gets whole blocks
+inline unsigned int NumBlocks(unsigned int n){
+  return((n + VecBlock - 1) / VecBlock);
+}
+
+//// Calculates mu from linear predictors and checks bounds
+template<class D, class L>
+struct MuKernel{
+  static void Run(const arma::vec* eta, arma::vec* mu, bool parallel){
+    unsigned int n = eta->n_elem;
+    unsigned int nblocks = NumBlocks(n);
+#pragma omp parallel for if(parallel)
+    for(unsigned int b = 0; b < nblocks; b++){
+      unsigned int start = b * VecBlock;
+      unsigned int len = std::min(VecBlock, n - start);
+      double* mu1 = mu->memptr() + start;
+      L::MuBlock(eta->memptr() + start, mu1, len);
+      for(unsigned int i = 0; i < len; i++){
+        mu1[i] = D::Bound(mu1[i]);
+      }
+    }
+  }
+};
+
+//// Calculates derivative of mu with respect to the linear predictors
+template<class D, class L>
+struct DerivKernel{
+  static void Run(const arma::vec* eta, const arma::vec* mu, arma::vec* Deriv,
+                  bool parallel){
+    unsigned int n = mu->n_elem;
+    unsigned int nblocks = NumBlocks(n);
+#pragma omp parallel for if(parallel)
+    for(unsigned int b = 0; b < nblocks; b++){
+      unsigned int start = b * VecBlock;
+      unsigned int len = std::min(VecBlock, n - start);
+      L::DerivBlock(eta->memptr() + start, mu->memptr() + start, 
+                    Deriv->memptr() + start, len);
+    }
+  }
+};
+
+//// Calculates variance and replaces zeros with FLT_EPSILON
+template<class D, class L>
+struct VarKernel{
+  static void Run(const arma::vec* mu, arma::vec* Var, bool parallel){
+#pragma omp parallel for if(parallel)
+    for(unsigned int i = 0; i < mu->n_elem; i++){
+      double val = D::Var(mu->at(i));
+      if(val == 0){
+        val = FLT_EPSILON;
+      }
+      Var->at(i) = val;
+    }
+  }
+};
+
+//// Calculates negative log-likelihood
+template<class D, class L>
+struct LogLikKernel{
+  static double Run(const arma::vec* Y, const arma::vec* mu, bool parallel){
+    double LogLik = 0;
+    unsigned int n = Y->n_elem;
+    unsigned int nblocks = NumBlocks(n);
+#pragma omp parallel for reduction(+:LogLik) if(parallel)
+    for(unsigned int b = 0; b < nblocks; b++){
+      unsigned int start = b * VecBlock;
+      unsigned int len = std::min(VecBlock, n - start);
+      double tmp[VecBlock];
+      LogLik += D::LogLikBlock(Y->memptr() + start, mu->memptr() + start, tmp, len);
+    }
+    return(LogLik);
+  }
+};
+
+//// Calculates mu, working weights, score contributions, and the negative 
+//// log-likelihood in a single pass over the observations
+//// eta and mu may point to the same vector since eta is read before mu is written
+//// w holds Deriv^2 / Var and r holds Deriv * (Y - mu) / Var, so the score is 
+//// -X'r and the fisher info is X'WX
+template<class D, class L>
+struct IRLSKernel{
+  static double Run(const arma::vec* eta, const arma::vec* Y, arma::vec* mu, 
+                    arma::vec* w, arma::vec* r, bool parallel){
+    double LogLik = 0;
+    unsigned int n = Y->n_elem;
+    unsigned int nblocks = NumBlocks(n);
+#pragma omp parallel for reduction(+:LogLik) if(parallel)
+    for(unsigned int b = 0; b < nblocks; b++){
+      unsigned int start = b * VecBlock;
+      unsigned int len = std::min(VecBlock, n - start);
+      const double* eta1 = eta->memptr() + start;
+      const double* Y1 = Y->memptr() + start;
+      
+      // mu and its derivative are kept in buffers until eta is no longer needed
+      double mu1[VecBlock];
+      double Deriv[VecBlock];
+      double tmp[VecBlock];
+      L::MuBlock(eta1, mu1, len);
+      for(unsigned int i = 0; i < len; i++){
+        mu1[i] = D::Bound(mu1[i]);
+      }
+      L::DerivBlock(eta1, mu1, Deriv, len);
+      LogLik += D::LogLikBlock(Y1, mu1, tmp, len);
+      for(unsigned int i = 0; i < len; i++){
+        double Var = D::Var(mu1[i]);
+        if(Var == 0){
+          Var = FLT_EPSILON;
+        }
+        double DerivVar = Deriv[i] / Var;
+        double w1 = Deriv[i] * DerivVar;
+        if(std::isnan(DerivVar)){
+          DerivVar = 0;
+        }
+        if(std::isnan(w1)){
+          w1 = 0;
+        }
+        mu->at(start + i) = mu1[i];
+        w->at(start + i) = w1;
+        r->at(start + i) = DerivVar * (Y1[i] - mu1[i]);
+      }
+    }
+    return(LogLik);
+  }
+};
+
+// Calls the kernel specialized for the family and link
+//// The switch is only done once per call, not once per observation
+template<template<class, class> class Kernel, class D, typename... Args>
+auto LinkDispatch(GLMLink Link, Args... args) ->
+  decltype(Kernel<D, IdentityLink>::Run(args...)){
+  switch(Link){
+  case GLMLink::log:
+    return(Kernel<D, LogLink>::Run(args...));
+  case GLMLink::logit:
+    return(Kernel<D, LogitLink>::Run(args...));
+  case GLMLink::probit:
+    return(Kernel<D, ProbitLink>::Run(args...));
+  case GLMLink::cloglog:
+    return(Kernel<D, CloglogLink>::Run(args...));
+  case GLMLink::inverse:
+    return(Kernel<D, InverseLink>::Run(args...));
+  case GLMLink::sqrt:
+    return(Kernel<D, SqrtLink>::Run(args...));
+  default:
+    return(Kernel<D, IdentityLink>::Run(args...));
+  }
+}
+
+template<template<class, class> class Kernel, typename... Args>
+auto FamilyDispatch(GLMFamily Family, Args... args) ->
+  decltype(Kernel<GaussianDist, IdentityLink>::Run(args...)){
+  switch(Family.Dist){
+  case GLMDist::binomial:
+    return(LinkDispatch<Kernel, BinomialDist>(Family.Link, args...));
+  case GLMDist::poisson:
+    return(LinkDispatch<Kernel, PoissonDist>(Family.Link, args...));
+  case GLMDist::gamma:
+    return(LinkDispatch<Kernel, GammaDist>(Family.Link, args...));
+  default:
+    return(LinkDispatch<Kernel, GaussianDist>(Family.Link, args...));
+  }
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef GLMWorkspace_H
+#define GLMWorkspace_H
+
+#include <RcppArmadillo.h>
+#include <vector>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+using namespace Rcpp;
+
+// Buffers reused by a single thread for every model that it fits
+// These are sized once from the number of observations and the size of the
+// largest model, so fitting a candidate model does not allocate memory for 
+// X'WX or any of the n-length vectors used by the fitters
+class GLMWorkspace{
+public:
+  arma::mat XTWX;
+  arma::vec mu;
+  arma::vec tempmu;
+  arma::vec eta;
+  arma::vec tempeta;
+  arma::vec Xp;
+  arma::vec w;
+  arma::vec r;
+  GLMWorkspace(unsigned int n, unsigned int p = 0):XTWX(p, p),
+  mu(n), tempmu(n), eta(n), tempeta(n), Xp(n), w(n), r(n){}
+};
+
+// Creates one workspace for each thread
+inline std::vector<GLMWorkspace> MakeWorkspaces(unsigned int n, unsigned int p){
+#ifdef _OPENMP
+  unsigned int nthreads = omp_get_max_threads();
+#else
+  unsigned int nthreads = 1;
+#endif
+  return(std::vector<GLMWorkspace>(nthreads, GLMWorkspace(n, p)));
+}
+
+// Gets the workspace for the current thread
+inline GLMWorkspace* GetWorkspace(std::vector<GLMWorkspace>* Workspaces){
+#ifdef _OPENMP
+  return(&Workspaces->at(omp_get_thread_num()));
+#else
+  return(&Workspaces->at(0));
+#endif
+}
+
+#endif
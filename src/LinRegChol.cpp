@@ -0,0 +1,185 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <vector>
+#include "LinRegChol.h"
+using namespace Rcpp;
+
+// Adds a column of X to the model by appending a column to R
+// Returns false without changing the factor if the column is collinear with the
+// columns already in the model
+bool LinRegChol::Add(unsigned int col){
+
+  // Solving R's = X'x for the new column with forward substitution
+  double* s = R.colptr(k);
+  double xx = XTX->at(col, col);
+  double ss = 0;
+  double sz = 0;
+  double szc = 0;
+  for(unsigned int i = 0; i < k; i++){
+    const double* Ri = R.colptr(i);
+    double temp = XTX->at(Cols.at(i), col);
+    for(unsigned int l = 0; l < i; l++){
+      temp -= Ri[l] * s[l];
+    }
+    s[i] = temp / Ri[i];
+    ss += s[i] * s[i];
+    sz += s[i] * z.at(i);
+    szc += s[i] * zc.at(i);
+  }
+
+  // Checking that the new diagonal element is positive
+  double d2 = xx - ss;
+  if(xx <= 0 || d2 <= 1e-10 * xx){
+    return(false);
+  }
+
+  // Updating factor
+  double d = sqrt(d2);
+  s[k] = d;
+  z.at(k) = (Cross->XTY.at(col) - sz) / d;
+  zc.at(k) = (Cross->XTYc.at(col) - szc) / d;
+  HasInt = HasInt || (int)col == Cross->Int;
+  Cols.at(k++) = col;
+  return(true);
+}
+
+// Removes a column of X from the model, the columns of R after it are shifted
+// left and givens rotations are used to make R upper triangular again
+void LinRegChol::Drop(unsigned int col){
+
+  // Finding position of the column in the factor
+  unsigned int pos = 0;
+  while(pos < k && Cols.at(pos) != col){
+    pos++;
+  }
+  if(pos == k){
+    return;
+  }
+
+  // Shifting columns
+  for(unsigned int j = pos; j < k - 1; j++){
+    Cols.at(j) = Cols.at(j + 1);
+    double* Rj = R.colptr(j);
+    const double* Rj1 = R.colptr(j + 1);
+    for(unsigned int i = 0; i <= j + 1; i++){
+      Rj[i] = Rj1[i];
+    }
+  }
+
+  // Zeroing the subdiagonal from pos onwards, rotations are also applied to z 
+  // and zc
+  for(unsigned int i = pos; i < k - 1; i++){
+    double a = R.at(i, i);
+    double b = R.at(i + 1, i);
+    double r = std::hypot(a, b);
+    double c = a / r;
+    double s = b / r;
+    R.at(i, i) = r;
+    R.at(i + 1, i) = 0;
+    for(unsigned int j = i + 1; j < k - 1; j++){
+      double temp1 = R.at(i, j);
+      double temp2 = R.at(i + 1, j);
+      R.at(i, j) = c * temp1 + s * temp2;
+      R.at(i + 1, j) = -s * temp1 + c * temp2;
+    }
+    double temp1 = z.at(i);
+    double temp2 = z.at(i + 1);
+    z.at(i) = c * temp1 + s * temp2;
+    z.at(i + 1) = -s * temp1 + c * temp2;
+    temp1 = zc.at(i);
+    temp2 = zc.at(i + 1);
+    zc.at(i) = c * temp1 + s * temp2;
+    zc.at(i + 1) = -s * temp1 + c * temp2;
+  }
+  HasInt = HasInt && (int)col != Cross->Int;
+  k--;
+}
+
+// Adds every column of X that belongs to a variable
+bool LinRegChol::AddVar(const arma::ivec* Indices, int var){
+  for(unsigned int i = 0; i < Indices->n_elem; i++){
+    if(Indices->at(i) == var && !Add(i)){
+      return(false);
+    }
+  }
+  return(true);
+}
+
+// Drops every column of X that belongs to a variable
+void LinRegChol::DropVar(const arma::ivec* Indices, int var){
+  for(unsigned int i = 0; i < Indices->n_elem; i++){
+    if(Indices->at(i) == var){
+      Drop(i);
+    }
+  }
+}
+
+// Adds every variable in a model to an empty factor, returns false if X'X for
+// the model is singular
+bool LinRegChol::AddModel(const arma::ivec* Indices, const arma::ivec* CurModel){
+  k = 0;
+  HasInt = false;
+  for(unsigned int i = 0; i < Indices->n_elem; i++){
+    if(CurModel->at(Indices->at(i)) != 0 && !Add(i)){
+      return(false);
+    }
+  }
+  return(true);
+}
+
+// Adds the variables in a model that aren't in the factor yet, so a model that 
+// contains the current one is found in O(k^2) for each new column instead of 
+// rebuilding the factor, returns false if X'X for the model is singular
+bool LinRegChol::ExtendModel(const arma::ivec* Indices, const arma::ivec* CurModel){
+  std::vector<bool> InModel(XTX->n_cols, false);
+  for(unsigned int i = 0; i < k; i++){
+    InModel.at(Cols.at(i)) = true;
+  }
+  for(unsigned int i = 0; i < Indices->n_elem; i++){
+    if(CurModel->at(Indices->at(i)) != 0 && !InModel.at(i) && !Add(i)){
+      return(false);
+    }
+  }
+  return(true);
+}
+
+// Residual sum of squares for the current model, the centered response gives 
+// the same residuals when the column of ones is in the model
+// Most of the digits of y'y cancel when the model nearly fits y exactly, so the 
+// RSS is found from the residuals for these models
+double LinRegChol::RSS() const{
+  const arma::vec* z1 = HasInt ? &zc : &z;
+  double zz = 0;
+  for(unsigned int i = 0; i < k; i++){
+    zz += z1->at(i) * z1->at(i);
+  }
+  double yty = HasInt ? Cross->ytyc : Cross->yty;
+  double rss = yty - zz;
+  if(rss <= std::sqrt(arma::datum::eps) * yty && Cross->Residual != nullptr){
+    const arma::uvec Cols1 = Cols.head(k);
+    const arma::vec beta = GetBeta();
+    return(Cross->Residual(Cross->X, &Cross->r, &Cols1, &beta));
+  }
+  return(std::max(rss, 0.0));
+}
+
+// Solves R beta = z with back substitution, beta is in the order of Cols
+// When the column of ones is in the model the centered response is used and its 
+// mean is added back to the intercept
+arma::vec LinRegChol::GetBeta() const{
+  const arma::vec* z1 = HasInt ? &zc : &z;
+  arma::vec beta(k);
+  for(int i = k - 1; i >= 0; i--){
+    double temp = z1->at(i);
+    for(unsigned int l = i + 1; l < k; l++){
+      temp -= R.at(i, l) * beta.at(l);
+    }
+    beta.at(i) = temp / R.at(i, i);
+  }
+  for(unsigned int i = 0; i < k && HasInt; i++){
+    if((int)Cols.at(i) == Cross->Int){
+      beta.at(i) += Cross->shift;
+    }
+  }
+  return(beta);
+}
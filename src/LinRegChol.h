@@ -0,0 +1,114 @@
+#ifndef LinRegChol_H
+#define LinRegChol_H
+
+#include <RcppArmadillo.h>
+#include "GLMFamily.h"
+#include "ParBranchGLMHelpers.h"
+using namespace Rcpp;
+
+// Gets the RSS of a linear regression from its residuals, this is used when 
+// the RSS from X'X has lost too much precision
+template<typename T>
+double ExplicitRSS(const void* X, const arma::vec* r, const arma::uvec* Cols, 
+                   const arma::vec* beta){
+  const T* X1 = static_cast<const T*>(X);
+  const arma::vec negbeta = -*beta;
+  arma::vec res(X1->n_rows);
+  ParLinPredCpp(X1, Cols, &negbeta, r, &res);
+  return(arma::dot(res, res));
+}
+
+// X'y and y'y for a linear regression, y is the response minus the offset
+// When X has a column of ones, X'y and y'y are also found after subtracting the 
+// mean of y, the RSS of models with an intercept is found from these so it 
+// doesn't lose precision when the mean of y is large compared to its spread
+// X, r, and Residual are used to find the RSS from the residuals instead
+struct LinRegCross{
+  arma::vec XTY;
+  arma::vec XTYc;
+  double yty = 0;
+  double ytyc = 0;
+  double shift = 0;
+  int Int = -1;
+  const void* X = nullptr;
+  arma::vec r;
+  double (*Residual)(const void*, const arma::vec*, const arma::uvec*, 
+          const arma::vec*) = nullptr;
+};
+
+// Gets the cross products used by LinRegChol, these are zero for other families
+template<typename T>
+LinRegCross GetLinRegCross(const T* X, const arma::mat* XTX, const arma::vec* Y, 
+                           const arma::vec* Offset, GLMFamily Family){
+  LinRegCross Cross;
+  Cross.XTY.zeros(X->n_cols);
+  if(!IsLinReg(Family)){
+    Cross.XTYc = Cross.XTY;
+    return(Cross);
+  }
+  Cross.r = *Y - *Offset;
+  const arma::vec& r = Cross.r;
+  Cross.XTY = ParCrossProdCpp(X, &r);
+  Cross.yty = arma::dot(r, r);
+  Cross.X = X;
+  Cross.Residual = &ExplicitRSS<T>;
+  
+  // Finding the column of ones, a column has x'x = 1'x = n only if it is all ones
+  bool Candidate = false;
+  for(unsigned int j = 0; j < X->n_cols; j++){
+    Candidate = Candidate || XTX->at(j, j) == X->n_rows;
+  }
+  if(Candidate){
+    const arma::vec Ones(X->n_rows, arma::fill::ones);
+    const arma::vec XT1 = ParCrossProdCpp(X, &Ones);
+    for(unsigned int j = 0; j < X->n_cols && Cross.Int < 0; j++){
+      if(XTX->at(j, j) == X->n_rows && XT1.at(j) == X->n_rows){
+        Cross.Int = j;
+      }
+    }
+  }
+  
+  // Centering the response
+  if(Cross.Int >= 0){
+    Cross.shift = arma::mean(r);
+    const arma::vec rc = r - Cross.shift;
+    Cross.XTYc = ParCrossProdCpp(X, &rc);
+    Cross.ytyc = arma::dot(rc, rc);
+  }
+  else{
+    Cross.XTYc = Cross.XTY;
+    Cross.ytyc = Cross.yty;
+  }
+  return(Cross);
+}
+
+// Cholesky factor of X'X for the columns in a linear regression model
+// Adding or dropping a column updates the factor in O(k^2), so the residual sum
+// of squares of neighboring models is found without refitting them
+// z and zc are R^-T X'y for the response and the centered response, zc is used 
+// when the column of ones is in the model
+class LinRegChol{
+public:
+  const arma::mat* XTX;
+  const LinRegCross* Cross;
+  unsigned int n;
+  unsigned int k;
+  bool HasInt;
+  arma::mat R;
+  arma::vec z;
+  arma::vec zc;
+  arma::uvec Cols;
+  LinRegChol(const arma::mat* XTX, const LinRegCross* Cross, unsigned int n):
+  XTX(XTX), Cross(Cross), n(n), k(0), HasInt(false), 
+  R(XTX->n_cols, XTX->n_cols), z(XTX->n_cols), zc(XTX->n_cols), Cols(XTX->n_cols){}
+  bool Add(unsigned int col);
+  void Drop(unsigned int col);
+  bool AddVar(const arma::ivec* Indices, int var);
+  void DropVar(const arma::ivec* Indices, int var);
+  bool AddModel(const arma::ivec* Indices, const arma::ivec* CurModel);
+  bool ExtendModel(const arma::ivec* Indices, const arma::ivec* CurModel);
+  double RSS() const;
+  arma::vec GetBeta() const;
+};
+
+#endif
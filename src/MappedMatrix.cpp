@@ -0,0 +1,190 @@
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include "MappedMatrix.h"
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+using namespace Rcpp;
+
+// Design files start with this string followed by the format version, the type
+// of the elements, and the number of rows and columns
+static const char DesignMagic[8] = {'B', 'G', 'L', 'M', 'D', 'S', 'G', 'N'};
+static const uint32_t DesignVersion = 1;
+static const uint32_t DesignDouble = 0;
+static const size_t DesignHeaderSize = 32;
+
+// Reads the header of a design file and gets the number of rows and columns
+static void ReadDesignHeader(std::istream* in, uint64_t* n, uint64_t* p){
+  char magic[sizeof(DesignMagic)];
+  uint32_t version, dtype;
+  in->read(magic, sizeof(magic));
+  in->read(reinterpret_cast<char*>(&version), sizeof(version));
+  in->read(reinterpret_cast<char*>(&dtype), sizeof(dtype));
+  in->read(reinterpret_cast<char*>(n), sizeof(uint64_t));
+  in->read(reinterpret_cast<char*>(p), sizeof(uint64_t));
+  if(!(*in) || !std::equal(magic, magic + sizeof(magic), DesignMagic)){
+    stop("supplied file is not a design file");
+  }
+  if(version != DesignVersion){
+    stop("design file was written by a different version of BranchGLM");
+  }
+  if(dtype != DesignDouble){
+    stop("only design files with double precision elements are supported");
+  }
+  if(*n > std::numeric_limits<unsigned int>::max() ||
+     *p > std::numeric_limits<unsigned int>::max()){
+    stop("the design file has too many rows or columns");
+  }
+}
+
+// Checks the header and size of the file and then maps all of it
+MappedMatrix::MappedMatrix(std::string file){
+  std::ifstream in(file.c_str(), std::ios::binary | std::ios::ate);
+  if(!in){
+    stop("could not open design file");
+  }
+  uint64_t size = in.tellg();
+  in.seekg(0);
+  uint64_t n, p;
+  ReadDesignHeader(&in, &n, &p);
+  in.close();
+  Length = DesignHeaderSize + n * p * sizeof(double);
+  if(size != Length){
+    stop("the size of the design file does not match its number of rows and columns");
+  }
+  n_rows = n;
+  n_cols = p;
+
+#ifdef _WIN32
+  FileHandle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(FileHandle == INVALID_HANDLE_VALUE){
+    stop("could not open design file");
+  }
+  MapHandle = CreateFileMappingA(FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+  Map = MapHandle == NULL ? NULL : MapViewOfFile(MapHandle, FILE_MAP_READ, 0, 0, 0);
+  if(Map == NULL){
+    if(MapHandle != NULL){
+      CloseHandle(MapHandle);
+    }
+    CloseHandle(FileHandle);
+    stop("could not map design file");
+  }
+#else
+  int fd = open(file.c_str(), O_RDONLY);
+  if(fd == -1){
+    stop("could not open design file");
+  }
+  Map = mmap(NULL, Length, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping keeps the file open, so the descriptor isn't needed anymore
+  close(fd);
+  if(Map == MAP_FAILED){
+    stop("could not map design file");
+  }
+#endif
+}
+
+MappedMatrix::~MappedMatrix(){
+#ifdef _WIN32
+  UnmapViewOfFile(Map);
+  CloseHandle(MapHandle);
+  CloseHandle(FileHandle);
+#else
+  munmap(Map, Length);
+#endif
+}
+
+// The columns start right after the header, mappings start on a page boundary
+// so the elements are aligned
+const double* MappedMatrix::memptr() const{
+  return(reinterpret_cast<const double*>(static_cast<const char*>(Map) +
+                                         DesignHeaderSize));
+}
+
+// Wraps the mapping or the memory of the R matrix, the R matrix is kept so
+// that the memory stays valid if x had to be converted to doubles
+DenseDesign::DenseDesign(SEXP x){
+  if(TYPEOF(x) == EXTPTRSXP){
+    const MappedMatrix* Mapped = XPtr<MappedMatrix>(x).checked_get();
+    X.reset(new arma::mat(const_cast<double*>(Mapped->memptr()), Mapped->n_rows,
+                          Mapped->n_cols, false, true));
+  }else{
+    xdense = NumericMatrix(x);
+    X.reset(new arma::mat(xdense.begin(), xdense.rows(), xdense.cols(), false, true));
+  }
+}
+
+const arma::mat* DenseDesign::get() const{
+  return(X.get());
+}
+
+// Maps a design file, the mapping is removed when the pointer is garbage collected
+// [[Rcpp::export]]
+List MappedMatrixCpp(std::string file){
+  XPtr<MappedMatrix> ptr(new MappedMatrix(file), true);
+  return(List::create(Named("ptr") = ptr, 
+                      Named("nrow") = ptr->n_rows, 
+                      Named("ncol") = ptr->n_cols));
+}
+
+// Creates a design file with n rows and p columns of zeros, the rows are 
+// filled in with WriteDesignRowsCpp
+// [[Rcpp::export]]
+void CreateDesignFileCpp(std::string file, double n, double p){
+  std::ofstream out(file.c_str(), std::ios::binary | std::ios::trunc);
+  if(!out){
+    stop("could not create design file");
+  }
+  uint64_t n2 = n;
+  uint64_t p2 = p;
+  out.write(DesignMagic, sizeof(DesignMagic));
+  out.write(reinterpret_cast<const char*>(&DesignVersion), sizeof(DesignVersion));
+  out.write(reinterpret_cast<const char*>(&DesignDouble), sizeof(DesignDouble));
+  out.write(reinterpret_cast<const char*>(&n2), sizeof(n2));
+  out.write(reinterpret_cast<const char*>(&p2), sizeof(p2));
+  
+  // Extending the file to its full size by writing the last byte
+  if(n2 * p2 > 0){
+    out.seekp(DesignHeaderSize + n2 * p2 * sizeof(double) - 1);
+    out.put(0);
+  }
+  out.close();
+  if(!out){
+    stop("could not write design file");
+  }
+}
+
+// Writes the rows of x to a design file starting at row start, which is 0-based
+// [[Rcpp::export]]
+void WriteDesignRowsCpp(std::string file, NumericMatrix x, double start){
+  std::fstream out(file.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+  if(!out){
+    stop("could not open design file");
+  }
+  uint64_t n, p;
+  ReadDesignHeader(&out, &n, &p);
+  uint64_t start2 = start;
+  if((uint64_t)x.cols() != p || start2 + x.rows() > n){
+    stop("the rows do not fit in the design file");
+  }
+  
+  // Each column of x is written to the part of the column in the file
+  for(uint64_t j = 0; j < p; j++){
+    out.seekp(DesignHeaderSize + (j * n + start2) * sizeof(double));
+    out.write(reinterpret_cast<const char*>(x.begin() + j * x.rows()),
+              sizeof(double) * x.rows());
+  }
+  out.close();
+  if(!out){
+    stop("could not write design file");
+  }
+}
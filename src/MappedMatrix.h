@@ -0,0 +1,44 @@
+#ifndef MappedMatrix_H
+#define MappedMatrix_H
+
+#include <RcppArmadillo.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+using namespace Rcpp;
+
+// Design matrix stored in a binary file that is memory-mapped read only
+// The file has a 32 byte header followed by the columns of X as doubles, so
+// the mapping can be used directly as the memory of an arma::mat
+// Pages of the file are read by the operating system as they are used, and
+// processes that map the same file share the same pages
+class MappedMatrix{
+public:
+  unsigned int n_rows;
+  unsigned int n_cols;
+  MappedMatrix(std::string file);
+  ~MappedMatrix();
+  MappedMatrix(const MappedMatrix&) = delete;
+  MappedMatrix& operator=(const MappedMatrix&) = delete;
+  const double* memptr() const;
+private:
+  void* Map;
+  size_t Length;
+#ifdef _WIN32
+  void* FileHandle;
+  void* MapHandle;
+#endif
+};
+
+// Dense design matrix from R that is used without copying it, x is either a
+// numeric matrix or a pointer to a mapped design file
+class DenseDesign{
+public:
+  DenseDesign(SEXP x);
+  const arma::mat* get() const;
+private:
+  NumericMatrix xdense;
+  std::unique_ptr<const arma::mat> X;
+};
+
+#endif
@@ -5,27 +5,29 @@
 #include "ParBranchGLMHelpers.h"
 #include "BranchGLMHelpers.h"
 #include "VariableSelection.h"
+#include "MappedMatrix.h"
+#include "ThreadPolicy.h"
 #ifdef _OPENMP
 # include <omp.h>
 #endif
 using namespace Rcpp;
 
-arma::vec GetY(const arma::mat* y, std::string Link){
+arma::vec GetY(const arma::mat* y, GLMFamily Family){
   arma::vec NewY = *y;
-  if(Link == "log"){
+  if(Family.Link == GLMLink::log){
     NewY = log(NewY.replace(0, 1e-4));
     
-  }else if(Link == "inverse"){
+  }else if(Family.Link == GLMLink::inverse){
     NewY = 1 / (NewY.replace(0, 1e-4));
     
-  }else if(Link == "sqrt"){
+  }else if(Family.Link == GLMLink::sqrt){
     NewY = sqrt(NewY);
     
-  }else if(Link == "logit"){
+  }else if(Family.Link == GLMLink::logit){
     NewY = NewY.clamp(1e-4, 1 - 1e-4);
     NewY = log(NewY / (1 - NewY));
     
-  }else if(Link == "probit"){ 
+  }else if(Family.Link == GLMLink::probit){ 
     double val0 = boost::math::quantile(boost::math::normal(0.0, 1.0), 1e-4);
     double val1 = boost::math::quantile(boost::math::normal(0.0, 1.0), 1 - 1e-4);
     for(unsigned int i = 0; i < NewY.n_elem; i++){
@@ -36,7 +38,7 @@ arma::vec GetY(const arma::mat* y, std::string Link){
       }
     } 
     
-  }else if(Link == "cloglog"){
+  }else if(Family.Link == GLMLink::cloglog){
     NewY = NewY.clamp(1e-4, 1 - 1e-4);
     NewY = log(-log(1 - NewY));
   }
@@ -52,7 +54,7 @@ double MetricHelperWithBetas(const arma::mat* oldX, const arma::mat* XTWX,
                     const arma::vec* Y, const arma::vec* Offset,
                     const arma::ivec* Indices, const arma::ivec* CurModel,
                     std::string method, 
-                    int m, std::string Link, std::string Dist,
+                    int m, GLMFamily Family,
                     double tol, int maxit, const arma::vec* pen,
                     arma::vec* betas, arma::vec* SEs){
   
@@ -76,50 +78,54 @@ double MetricHelperWithBetas(const arma::mat* oldX, const arma::mat* XTWX,
     }
   } 
   
+  // The columns of X in NewInd are used directly instead of copying them
   arma::mat NewXTWX = XTWX->submat(NewInd, NewInd);
-  arma::mat X = oldX->cols(NewInd);
   bool UseXTWX = true;
-  arma::vec beta(X.n_cols, arma::fill::zeros);
+  arma::vec beta(count, arma::fill::zeros);
+  GLMWorkspace Workspace(oldX->n_rows);
   
   // Getting initial values
-  PargetInit(&beta, &X, &NewXTWX, Y, Offset, Dist, Link, &UseXTWX);
+  PargetInit(&beta, oldX, &NewInd, &NewXTWX, Y, Offset, Family, &UseXTWX, &Workspace);
   
   int Iter;
   
-  if(Dist == "gaussian" && Link == "identity"){
-    Iter = ParLinRegCppShort(&beta, &X, &NewXTWX, Y, Offset);
+  if(IsLinReg(Family)){
+    Iter = ParLinRegCppShort(&beta, oldX, &NewInd, &NewXTWX, Y, Offset);
   }else if(method == "BFGS"){ 
-    Iter = ParBFGSGLMCpp(&beta, &X, &NewXTWX, Y, Offset, Link, Dist, tol, maxit, UseXTWX);
+    Iter = ParBFGSGLMCpp(&beta, oldX, &NewInd, &NewXTWX, Y, Offset, Family, tol, maxit, UseXTWX, &Workspace);
   } 
   else if(method == "LBFGS"){
-    Iter = ParLBFGSGLMCpp(&beta, &X, &NewXTWX, Y, Offset, Link, Dist, tol, maxit, m, UseXTWX);
+    Iter = ParLBFGSGLMCpp(&beta, oldX, &NewInd, &NewXTWX, Y, Offset, Family, tol, maxit, m, UseXTWX, &Workspace);
   } 
   else{
-    Iter = ParFisherScoringGLMCpp(&beta, &X, &NewXTWX, Y, Offset, Link, Dist, tol, maxit, UseXTWX);
+    Iter = ParFisherScoringGLMCpp(&beta, oldX, &NewInd, &NewXTWX, Y, Offset, Family, tol, maxit, UseXTWX, &Workspace);
   } 
   
   if(Iter <= 0){
     return(arma::datum::inf);
   } 
   
-  arma::vec mu = ParLinkCpp(&X, &beta, Offset, Link, Dist);
-  double LogLik = -ParLogLikelihoodCpp(&X, Y, &mu, Dist);
-  double dispersion = GetDispersion(&X, Y, &mu, LogLik, Dist, tol);
+  // Calculating mu, weights, and log-likelihood
+  arma::vec mu(oldX->n_rows);
+  arma::vec w(oldX->n_rows);
+  arma::vec r(oldX->n_rows);
+  double LogLik = -ParIRLSCpp(oldX, &NewInd, Y, Offset, &beta, &mu, &w, &r, Family);
+  double dispersion = GetDispersion(Y, &mu, LogLik, Family, tol);
   if(dispersion < 0 || std::isnan(LogLik) || std::isinf(dispersion)){
     return(arma::datum::inf);
   } 
   
-  if(Dist == "gaussian"){
-    double temp = X.n_rows/2 * log(2*M_PI*dispersion);
+  if(Family.Dist == GLMDist::gaussian){
+    double temp = oldX->n_rows/2 * log(2*M_PI*dispersion);
     LogLik = LogLik / dispersion - temp;
   } 
-  else if(Dist == "poisson"){
+  else if(Family.Dist == GLMDist::poisson){
     LogLik -=  LogFact(Y);
   } 
-  else if(Dist == "gamma"){
+  else if(Family.Dist == GLMDist::gamma){
     double shape = 1 / dispersion;
     LogLik = shape * LogLik + 
-      X.n_rows * (shape * log(shape) - lgamma(shape)) +
+      oldX->n_rows * (shape * log(shape) - lgamma(shape)) +
       (shape - 1) * arma::accu(log(*Y));
   } 
   if(std::isnan(LogLik)){
@@ -127,12 +133,8 @@ double MetricHelperWithBetas(const arma::mat* oldX, const arma::mat* XTWX,
   } 
   
   // Calculate SEs
-  // Calculating derivatives, and variances to be used for info
-  arma::vec Deriv = ParDerivativeCpp(&X, &beta, Offset, &mu, Link, Dist);
-  arma::vec Var = ParVariance(&mu, Dist);
-  
-  // Calculating info and initalizing inverse info
-  arma::mat Info = ParFisherInfoCpp(&X, &Deriv, &Var);
+  // Calculating info with the weights and initalizing inverse info
+  arma::mat Info = ParWeightedInfoCpp(oldX, &NewInd, &w);
   arma::mat InfoInv = Info;
   
   // Calculating inverse info and returning error if not invertible
@@ -153,7 +155,7 @@ double MetricHelper2(const arma::mat* X, const arma::mat* XTWX, const arma::vec*
                              const arma::vec* Offset,
                              const arma::ivec* Indices, const arma::ivec* CurModel,
                              std::string method, 
-                             int m, std::string Link, std::string Dist,
+                             int m, GLMFamily Family,
                              double tol, int maxit, const arma::vec* pen){
   
   
@@ -161,38 +163,40 @@ double MetricHelper2(const arma::mat* X, const arma::mat* XTWX, const arma::vec*
   arma::vec beta = *XTXXT * (*NewY - *Offset);
   int Iter;
   bool UseXTWX = false;
-  if(Dist == "gaussian" && Link == "identity"){
+  GLMWorkspace Workspace(X->n_rows);
+  arma::uvec Cols = GetAllCols(X->n_cols);
+  if(IsLinReg(Family)){
     // Do nothing
     Iter = 1;
   }else if(method == "BFGS"){  
-    Iter = ParBFGSGLMCpp(&beta, X, XTWX, Y, Offset, Link, Dist, tol, maxit, UseXTWX);
+    Iter = ParBFGSGLMCpp(&beta, X, &Cols, XTWX, Y, Offset, Family, tol, maxit, UseXTWX, &Workspace);
   }  
   else if(method == "LBFGS"){
-    Iter = ParLBFGSGLMCpp(&beta, X, XTWX, Y, Offset, Link, Dist, tol, maxit, m, UseXTWX);
+    Iter = ParLBFGSGLMCpp(&beta, X, &Cols, XTWX, Y, Offset, Family, tol, maxit, m, UseXTWX, &Workspace);
   }  
   else{
-    Iter = ParFisherScoringGLMCpp(&beta, X, XTWX, Y, Offset, Link, Dist, tol, maxit, UseXTWX);
+    Iter = ParFisherScoringGLMCpp(&beta, X, &Cols, XTWX, Y, Offset, Family, tol, maxit, UseXTWX, &Workspace);
   }  
   
   if(Iter <= 0){
     return(arma::datum::inf);
   }  
   
-  arma::vec mu = ParLinkCpp(X, &beta, Offset, Link, Dist);
-  double LogLik = -ParLogLikelihoodCpp(X, Y, &mu, Dist);
-  double dispersion = GetDispersion(X, Y, &mu, LogLik, Dist, tol);
+  arma::vec mu = ParLinkCpp(X, &beta, Offset, Family);
+  double LogLik = -ParLogLikelihoodCpp(Y, &mu, Family);
+  double dispersion = GetDispersion(Y, &mu, LogLik, Family, tol);
   if(dispersion <= 0 || std::isnan(LogLik) || std::isinf(dispersion)){
     return(arma::datum::inf);
   }  
   
-  if(Dist == "gaussian"){
+  if(Family.Dist == GLMDist::gaussian){
     double temp = X->n_rows/2 * log(2*M_PI*dispersion);
     LogLik = LogLik / dispersion - temp;
   }  
-  else if(Dist == "poisson"){
+  else if(Family.Dist == GLMDist::poisson){
     LogLik -=  LogFact(Y);
   } 
-  else if(Dist == "gamma"){
+  else if(Family.Dist == GLMDist::gamma){
     double shape = 1 / dispersion;
     LogLik = shape * LogLik + 
       X->n_rows * (shape * log(shape) - lgamma(shape)) +
@@ -205,27 +209,27 @@ double MetricHelper2(const arma::mat* X, const arma::mat* XTWX, const arma::vec*
 }  
 
 double NullHelper(double beta, const arma::mat* X, const arma::vec* Y, 
-                  const arma::vec* Offset, double tol, std::string Link, std::string Dist, 
+                  const arma::vec* Offset, double tol, GLMFamily Family, 
                   const arma::vec* pen){
   // Creating beta
   arma::vec betavec(1);
   betavec.at(0) = beta;
-  arma::vec mu = ParLinkCpp(X, &betavec, Offset, Link, Dist);
-  double LogLik = -ParLogLikelihoodCpp(X, Y, &mu, Dist);
-  double dispersion = GetDispersion(X, Y, &mu, LogLik, Dist, tol);
+  arma::vec mu = ParLinkCpp(X, &betavec, Offset, Family);
+  double LogLik = -ParLogLikelihoodCpp(Y, &mu, Family);
+  double dispersion = GetDispersion(Y, &mu, LogLik, Family, tol);
   
   if(dispersion <= 0 || std::isnan(LogLik)){
     return(arma::datum::inf);
   }
   
-  if(Dist == "gaussian"){
+  if(Family.Dist == GLMDist::gaussian){
     double temp = X->n_rows/2 * log(2*M_PI*dispersion);
     LogLik = LogLik / dispersion - temp;
   }
-  else if(Dist == "poisson"){
+  else if(Family.Dist == GLMDist::poisson){
     LogLik -=  LogFact(Y);
   }
-  else if(Dist == "gamma"){
+  else if(Family.Dist == GLMDist::gamma){
     double shape = 1 / dispersion;
     LogLik = shape * LogLik + 
       X->n_rows * (shape * log(shape) - lgamma(shape)) + 
@@ -242,7 +246,7 @@ double GetBest(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y,
                const arma::mat* XTXXT, const arma::vec* NewY, const arma::vec* curCol,
                const arma::vec* Offset,
                arma::ivec* Indices,
-               std::string method, int m, std::string Link, std::string Dist, 
+               std::string method, int m, GLMFamily Family, 
                double tol, int maxit, const arma::vec* pen, const arma::ivec* CurModel, 
                unsigned int cur, 
                double beta, double goal, const double Metric){
@@ -250,12 +254,12 @@ double GetBest(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y,
   if(Metric <= goal){
     if(all(*CurModel == 0)){
       // If this is the only variable then we don't need to fit anything
-      curMetric = NullHelper(beta, curCol, Y, Offset, tol, Link, Dist, pen);
+      curMetric = NullHelper(beta, curCol, Y, Offset, tol, Family, pen);
     }else{
       // Fitting model if there are more than 1 variable
       arma::vec tempOffset = *Offset + beta * *curCol;
       curMetric = MetricHelper2(X, XTWX, Y, XTXXT, NewY, &tempOffset, Indices, CurModel, 
-                 method, m, Link, Dist, tol, maxit, pen);
+                 method, m, Family, tol, maxit, pen);
     }
   }
   return(curMetric);
@@ -265,7 +269,7 @@ double ITPMethod(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y,
                  const arma::mat* XTXXT, const arma::vec* NewY, const arma::vec* curCol,
                  const arma::vec* Offset,
                  arma::ivec* Indices,
-                 std::string method, int m, std::string Link, std::string Dist, 
+                 std::string method, int m, GLMFamily Family, 
                  double tol, int maxit, const arma::vec* pen, const arma::ivec* CurModel, 
                  unsigned int cur, 
                  double init1, double lowerval, 
@@ -332,7 +336,7 @@ double ITPMethod(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y,
      
     // Fitting new model
     MetricVal3 = GetBest(X, XTWX, Y, XTXXT, NewY, curCol, Offset, Indices, 
-                         method, m, Link, Dist, tol, maxit, pen, CurModel, cur, 
+                         method, m, Family, tol, maxit, pen, CurModel, cur, 
                          init3, goal, Metric);
  
     
@@ -363,7 +367,7 @@ double SecantMethodCpp(const arma::mat* X, const arma::mat* XTWX, const arma::ve
                        const arma::mat* XTXXT, const arma::vec* NewY, const arma::vec* curCol,
                        const arma::vec* Offset,
                        arma::ivec* Indices,
-                       std::string method, int m, std::string Link, std::string Dist, 
+                       std::string method, int m, GLMFamily Family, 
                        double tol, int maxit, const arma::vec* pen, const arma::ivec* CurModel, unsigned int cur, 
                        double bound, double val, double init, double goal, 
                        const double Metric,
@@ -384,7 +388,7 @@ double SecantMethodCpp(const arma::mat* X, const arma::mat* XTWX, const arma::ve
     //// Fitting model
     MetricVal2 = MetricVal;
     MetricVal = GetBest(X, XTWX, Y, XTXXT, NewY, curCol, Offset, Indices, 
-                        method, m, Link, Dist, tol, maxit, pen, CurModel, cur, 
+                        method, m, Family, tol, maxit, pen, CurModel, cur, 
                         init2, goal, Metric);
     
     //// Going backwards if we have gone too far and metric value is infinite
@@ -392,7 +396,7 @@ double SecantMethodCpp(const arma::mat* X, const arma::mat* XTWX, const arma::ve
     while(std::isinf(MetricVal) && newIter < 10){
       init2 = (init2 + init3) / 2;
       MetricVal = GetBest(X, XTWX, Y, XTXXT, NewY, curCol, Offset, Indices, 
-                          method, m, Link, Dist, tol, maxit, pen, CurModel, cur, 
+                          method, m, Family, tol, maxit, pen, CurModel, cur, 
                           init2, goal, Metric);
       newIter++;
     }
@@ -405,7 +409,7 @@ double SecantMethodCpp(const arma::mat* X, const arma::mat* XTWX, const arma::ve
     if((MetricVal3 - goal) * (MetricVal - goal) < 0 && rootMethod == "ITP"){
       // Switching to ITP method since we now have valid bounds
       return(ITPMethod(X, XTWX, Y, XTXXT, NewY, curCol, Offset, Indices, 
-                       method, m, Link, Dist, tol, maxit, pen, CurModel, cur, 
+                       method, m, Family, tol, maxit, pen, CurModel, cur, 
                        init3, MetricVal3, init2, MetricVal, goal, Metric));
     }
     else{
@@ -439,7 +443,7 @@ double SecantMethodCpp(const arma::mat* X, const arma::mat* XTWX, const arma::ve
 
 // Metric Interval
 // [[Rcpp::export]]
-List MetricIntervalCpp(NumericMatrix x, NumericVector y, NumericVector offset, 
+List MetricIntervalCpp(SEXP x, NumericVector y, NumericVector offset, 
                                  IntegerVector indices, IntegerVector num,
                                  IntegerVector model,
                                  std::string method, int m,
@@ -449,9 +453,13 @@ List MetricIntervalCpp(NumericMatrix x, NumericVector y, NumericVector offset,
                                  NumericVector best, double cutoff, double Metric,
                                  std::string rootMethod){
   
+  // Getting family and link used by the fitting functions
+  const GLMFamily Family = GetFamily(Dist, Link);
+  
   // Creating necessary vectors/matrices
   arma::ivec CurModel2(model.begin(), model.size(), false, true);
-  const arma::mat X(x.begin(), x.rows(), x.cols(), false, true);
+  const DenseDesign Design(x);
+  const arma::mat& X = *Design.get();
   const arma::vec Y(y.begin(), y.size(), false, true);
   const arma::vec Offset(offset.begin(), offset.size(), false, true);
   const arma::vec Pen(pen.begin(), pen.size(), false, true);
@@ -461,10 +469,10 @@ List MetricIntervalCpp(NumericMatrix x, NumericVector y, NumericVector offset,
   arma::ivec Indices(indices.begin(), indices.size(), false, true);
   arma::ivec Counts(num.begin(), num.size(), false, true);
   
-  // Setting number of threads if OpenMP is available
-#ifdef _OPENMP
-  omp_set_num_threads(nthreads);
-#endif
+  // Setting number of threads, the intervals for the variables are found at the 
+  // same time
+  ThreadScope Threads(ChooseThreads(X.n_rows, X.n_cols, CurModel2.n_elem, nthreads));
+  nthreads = Threads.Plan.nthreads;
   
   // Getting X'WX
   arma::mat XTWX = X.t() * X;
@@ -517,7 +525,7 @@ List MetricIntervalCpp(NumericMatrix x, NumericVector y, NumericVector offset,
         arma::mat NewXTWX = XTWX.submat(NewInd, NewInd);
         arma::mat NewX = X.cols(NewInd);
         arma::mat XTXXT;
-        arma::vec NewY = GetY(&Y, Link);
+        arma::vec NewY = GetY(&Y, Family);
         bool check = GetXTXXT(&NewX, &NewXTWX, &XTXXT);
         arma::vec curCol = X.col(cur);
         if(!check){
@@ -526,12 +534,12 @@ List MetricIntervalCpp(NumericMatrix x, NumericVector y, NumericVector offset,
           UpperVals.at(i) = SecantMethodCpp(&NewX, &NewXTWX, &Y, 
                        &XTXXT, &NewY, &curCol, 
                        &Offset, &Indices, 
-                     method, m, Link, Dist, tol, maxit, &Pen, &CurModel, i, 
+                     method, m, Family, tol, maxit, &Pen, &CurModel, i, 
                      curMLE, Best.at(i), curMLE + curSE, 
                      Best.at(i) + cutoff, Metric, rootMethod, "upper");
           LowerVals.at(i) = SecantMethodCpp(&NewX, &NewXTWX, &Y, 
                        &XTXXT, &NewY, &curCol, &Offset, &Indices, 
-                       method, m, Link, Dist, tol, maxit, &Pen, &CurModel, i, 
+                       method, m, Family, tol, maxit, &Pen, &CurModel, i, 
                        curMLE, Best.at(i), curMLE - curSE, 
                        Best.at(i) + cutoff, Metric, rootMethod, "lower");
           
@@ -548,11 +556,6 @@ List MetricIntervalCpp(NumericMatrix x, NumericVector y, NumericVector offset,
     checkUserInterrupt();
   }
   
-  // Setting number of threads to 1 if OpenMP is available
-#ifdef _OPENMP
-  omp_set_num_threads(1);
-#endif
-  
   List FinalList = List::create(Named("LowerBounds") = LowerVals, 
                                 Named("UpperBounds") = UpperVals);
   return(FinalList);
@@ -1,166 +1,161 @@
 #include <RcppArmadillo.h>
+#include "BranchGLMHelpers.h"
 #include "CrossProducts.h"
+#include "GLMFamily.h"
+#include "GLMWorkspace.h"
 #include <boost/math/distributions/normal.hpp>
 #include <cmath>
+#include <vector>
 using namespace Rcpp;
 
-// Checking bounds and modifying values that are out of bounds
-void ParCheckBounds(arma::vec* mu, std::string Dist){
-  if(Dist == "binomial"){
-    mu->transform([](double val){
-      if(val <= 0){val = FLT_EPSILON;}
-      else if(val >= 1) {val = 1 - FLT_EPSILON;}
-      return(val);
-    });
-  }
-  else if(Dist == "poisson" || Dist == "gamma"){
-    mu->transform([](double val){
-      if(val <= 0){val = FLT_EPSILON;}
-      return(val);
-    });
-  }
-}
-
 // Defining Link functions
 arma::vec ParLinkCpp(const arma::mat* X, arma::vec* beta, const arma::vec* Offset, 
-                     std::string Link, std::string Dist){
+                     GLMFamily Family){
   
   // Calculating linear predictors and initializing vector for mu
-  arma::vec mu = (*X * *beta) + *Offset;
-  
-  
-  // Calculating mu
-  if(Link == "log"){
-    mu = exp(mu);
-  }
-  else if(Link == "logit"){
-    mu = 1 / (1 + exp(-mu));
-  }
-  else if(Link == "probit"){
-    mu = arma::normcdf(mu);
-  }
-  else if(Link == "cloglog"){
-    mu = 1 - exp(-exp(mu));
-  }
-  else if(Link == "inverse"){
-    mu = 1 / (mu);
-  }
-  else if(Link == "sqrt"){
-    mu = pow(mu, 2);
-  }
+  arma::vec XBeta = (*X * *beta) + *Offset;
+  arma::vec mu(XBeta.n_elem);
   
-  // Checking bounds for mu and modifying values that are out of bounds
-  ParCheckBounds(&mu, Dist);
+  // Calculating mu and checking bounds for mu
+  FamilyDispatch<MuKernel>(Family, &XBeta, &mu, false);
   return(mu);
 }
 
 // Defining Derivative functions
 arma::vec ParDerivativeCpp(const arma::mat* X, arma::vec* beta, const arma::vec* Offset,
-                           arma::vec* mu, std::string Link, std::string Dist){
+                           arma::vec* mu, GLMFamily Family){
   
   // Initializing vector to store derivative
   arma::vec Deriv(mu->n_elem);
   
-  // Calculating derivative
-  if(Link == "log"){
-    Deriv = *mu; 
-  }
-  else if(Link == "logit"){
-    Deriv = *mu % (1 - *mu);
-  }
-  else if(Link == "probit"){
-    Deriv = arma::normpdf(*X * *beta + *Offset);
-  }
-  else if(Link == "cloglog"){
-    Deriv = -(1 - *mu) % log(1 - *mu);
+  // Calculating derivative, linear predictors are only needed for probit
+  if(Family.Link == GLMLink::probit){
+    arma::vec XBeta = (*X * *beta) + *Offset;
+    FamilyDispatch<DerivKernel>(Family, &XBeta, mu, &Deriv, false);
   }
-  else if(Link == "inverse"){
-    Deriv = -pow(*mu, 2);
-  }
-  else if(Link == "identity"){
-    Deriv.fill(1);
-  }
-  else if(Link == "sqrt"){
-    Deriv = 2 * sqrt(*mu);
+  else{
+    FamilyDispatch<DerivKernel>(Family, mu, mu, &Deriv, false);
   }
   
   return(Deriv);
 }
 
 // Defining Variance functions for each family
-arma::vec ParVariance(arma::vec* mu, std::string Dist){
+arma::vec ParVariance(arma::vec* mu, GLMFamily Family){
   
   // Initializing vector to store variance
   arma::vec Var(mu->n_elem);
   
-  // Calculating variance
-  if(Dist == "poisson"){
-    Var = *mu; 
-  }
-  else if(Dist == "binomial"){
-    Var = *mu % (1 - *mu);
-  }
-  else if(Dist == "gamma"){
-    Var = pow(*mu, 2);
-  }
-  else{
-    Var.fill(1);
-  }
-  
-  // Replacing zeros with FLT_epsilon
-  Var.replace(0, FLT_EPSILON);
+  // Calculating variance, zeros are replaced with FLT_EPSILON
+  FamilyDispatch<VarKernel>(Family, mu, &Var, false);
   
   return(Var);
   
 }
 
 // Defining log likelihood
-double ParLogLikelihoodCpp(const arma::mat* X, const arma::vec* Y, 
-                           arma::vec* mu, std::string Dist){
-  
-  // Initializing double to store log-likelihood
-  double LogLik = 0;
-  
+double ParLogLikelihoodCpp(const arma::vec* Y, arma::vec* mu, GLMFamily Family){
   
   // Calculating log-likelihood
-  if(Dist == "poisson"){
-    for(unsigned int i = 0; i < Y->n_elem; i++){
-      LogLik += -Y->at(i) * log(mu->at(i)) + mu->at(i);
-    }
+  return(FamilyDispatch<LogLikKernel>(Family, Y, mu, false));
+}
+
+// Gets indices for all of the columns of a matrix
+arma::uvec GetAllCols(unsigned int p){
+  arma::uvec Cols(p);
+  for(unsigned int j = 0; j < p; j++){
+    Cols.at(j) = j;
   }
-  else if(Dist == "binomial"){
-    for(unsigned int i = 0; i < Y->n_elem; i++){
-      double theta = mu->at(i) / (1 - mu->at(i));
-      LogLik += -Y->at(i) * log(theta) + log1p(theta);
+  return(Cols);
+}
+
+// Calculates linear predictors using only the columns of X in Cols
+// X can be stored in single precision, eta is always accumulated in double
+template<typename eT>
+void DenseLinPredCpp(const arma::Mat<eT>* X, const arma::uvec* Cols, 
+                     const arma::vec* beta, const arma::vec* Offset, arma::vec* eta){
+  
+  // Rows are done in blocks so each block of eta stays in cache across columns
+  unsigned int B = 4096;
+  for(unsigned int start = 0; start < X->n_rows; start += B){
+    unsigned int end = std::min(X->n_rows, start + B);
+    for(unsigned int i = start; i < end; i++){
+      eta->at(i) = Offset->at(i);
     }
-  }else if(Dist == "gamma"){
-    arma::vec theta = -1 / *mu;
-    LogLik = -arma::dot(*Y, theta) - arma::accu(log(-theta));
-  }else{
-    for(unsigned int i = 0; i < Y->n_elem; i++){
-      LogLik += pow(Y->at(i) - mu->at(i), 2) /2;
+    for(unsigned int j = 0; j < Cols->n_elem; j++){
+      const eT* xcol = X->colptr(Cols->at(j));
+      double b = beta->at(j);
+      for(unsigned int i = start; i < end; i++){
+        eta->at(i) += b * xcol[i];
+      }
     }
   }
-  return(LogLik);
+}
+
+void ParLinPredCpp(const arma::mat* X, const arma::uvec* Cols, const arma::vec* beta, 
+                   const arma::vec* Offset, arma::vec* eta){
+  DenseLinPredCpp(X, Cols, beta, Offset, eta);
+}
+
+void ParLinPredCpp(const arma::fmat* X, const arma::uvec* Cols, const arma::vec* beta, 
+                   const arma::vec* Offset, arma::vec* eta){
+  DenseLinPredCpp(X, Cols, beta, Offset, eta);
+}
+
+// Sparse version, only the nonzero elements of each column are used
+void ParLinPredCpp(const arma::sp_mat* X, const arma::uvec* Cols, const arma::vec* beta, 
+                   const arma::vec* Offset, arma::vec* eta){
+  
+  for(unsigned int i = 0; i < X->n_rows; i++){
+    eta->at(i) = Offset->at(i);
+  }
+  for(unsigned int j = 0; j < Cols->n_elem; j++){
+    arma::uword col = Cols->at(j);
+    double b = beta->at(j);
+    for(arma::uword k = X->col_ptrs[col]; k < X->col_ptrs[col + 1]; k++){
+      eta->at(X->row_indices[k]) += b * X->values[k];
+    }
+  }
+}
+
+// Calculates mu, weights, score contributions, and log-likelihood in one pass 
+// from linear predictors that have already been calculated
+double ParIRLSEtaCpp(const arma::vec* eta, const arma::vec* Y, arma::vec* mu, 
+                     arma::vec* w, arma::vec* r, GLMFamily Family){
+  return(FamilyDispatch<IRLSKernel>(Family, eta, Y, mu, w, r, false));
+}
+
+// Calculates mu, weights, score contributions, and log-likelihood in one pass
+template<typename T>
+double ParIRLSCpp(const T* X, const arma::uvec* Cols, 
+                  const arma::vec* Y, const arma::vec* Offset, 
+                  arma::vec* beta, arma::vec* mu, arma::vec* w, arma::vec* r, 
+                  GLMFamily Family){
+  
+  // Calculating linear predictors in place, these are overwritten by mu
+  ParLinPredCpp(X, Cols, beta, Offset, mu);
+  
+  // Calculating mu, weights, score contributions, and log-likelihood
+  return(ParIRLSEtaCpp(mu, Y, mu, w, r, Family));
 }
 
 // Defining log likelihood for saturated model
-double ParLogLikelihoodSat(const arma::mat* X, const arma::vec* Y, std::string Dist){
+double ParLogLikelihoodSat(const arma::mat* X, const arma::vec* Y, GLMFamily Family){
   
   // Initializing double to hold saturated log-likelihood
   double LogLik = 0;
   
   // Calculating saturated log-likelihood
-  if(Dist == "poisson"){
+  if(Family.Dist == GLMDist::poisson){
     for(unsigned int i = 0; i< Y->n_elem;i++){
       if(Y->at(i) !=0){
         LogLik += Y->at(i) * (log(Y->at(i)) - 1);
       }
     }
   }
-  else if(Dist == "binomial"){
+  else if(Family.Dist == GLMDist::binomial){
     LogLik = 0;
-  }else if(Dist == "gamma"){
+  }else if(Family.Dist == GLMDist::gamma){
     arma::vec theta = -1 / *Y;
     LogLik = arma::dot(*Y, theta) + arma::accu(log(-theta));
   }else{
@@ -170,61 +165,189 @@ double ParLogLikelihoodSat(const arma::mat* X, const arma::vec* Y, std::string D
   return(LogLik);
 }
 
-// Defining score function
-arma::vec ParScoreCpp(const arma::mat* X, const arma::vec* Y, arma::vec* Deriv,
-                      arma::vec* Var, arma::vec* mu){
+// Calculates score from score contributions
+arma::vec ParWeightedScoreCpp(const arma::mat* X, const arma::uvec* Cols, 
+                              const arma::vec* r){
   
   // Initializing vector for score
-  arma::vec FinalVec(X->n_cols);
-  
-  // Calculating w and diff for score computation
-  arma::vec w = *Deriv / *Var;
-  arma::vec diff = *Y - *mu;
-  w.replace(arma::datum::nan, 0);
+  arma::vec FinalVec(Cols->n_elem);
   
   // Calculating score
-  for(unsigned int i = 0; i < X->n_cols; i++){
+  for(unsigned int i = 0; i < Cols->n_elem; i++){
     
-    FinalVec(i) = -arma::dot(X->col(i) % w, diff);
+    FinalVec(i) = -arma::dot(X->col(Cols->at(i)), *r);
     
   }
   return FinalVec;
 }
 
+arma::vec ParWeightedScoreCpp(const arma::sp_mat* X, const arma::uvec* Cols, 
+                              const arma::vec* r){
+  
+  // Initializing vector for score
+  arma::vec FinalVec(Cols->n_elem);
+  
+  // Calculating score from the nonzero elements of each column
+  for(unsigned int j = 0; j < Cols->n_elem; j++){
+    arma::uword col = Cols->at(j);
+    double temp = 0;
+    for(arma::uword k = X->col_ptrs[col]; k < X->col_ptrs[col + 1]; k++){
+      temp += X->values[k] * r->at(X->row_indices[k]);
+    }
+    FinalVec.at(j) = -temp;
+  }
+  return(FinalVec);
+}
+
+// Single precision version, the products are accumulated in double
+arma::vec ParWeightedScoreCpp(const arma::fmat* X, const arma::uvec* Cols, 
+                              const arma::vec* r){
+  
+  // Initializing vector for score
+  arma::vec FinalVec(Cols->n_elem);
+  
+  // Calculating score
+  for(unsigned int j = 0; j < Cols->n_elem; j++){
+    const float* xcol = X->colptr(Cols->at(j));
+    double temp = 0;
+    for(unsigned int i = 0; i < X->n_rows; i++){
+      temp += xcol[i] * r->at(i);
+    }
+    FinalVec.at(j) = -temp;
+  }
+  return(FinalVec);
+}
+
+// Defining score function
+arma::vec ParScoreCpp(const arma::mat* X, const arma::vec* Y, arma::vec* Deriv,
+                      arma::vec* Var, arma::vec* mu){
+  
+  // Calculating score contributions
+  arma::vec r = *Deriv / *Var;
+  r.replace(arma::datum::nan, 0);
+  r %= *Y - *mu;
+  
+  // Calculating score
+  arma::uvec Cols = GetAllCols(X->n_cols);
+  return(ParWeightedScoreCpp(X, &Cols, &r));
+}
+
+// Calculates X'WX from the diagonal of the W matrix
+arma::mat ParWeightedInfoCpp(const arma::mat* X, const arma::uvec* Cols, 
+                             const arma::vec* w){
+  
+  // Calculating X'WX with blocked symmetric rank-k updates
+  return(ParWeightedXTX(X, Cols, w));
+}
+
+arma::mat ParWeightedInfoCpp(const arma::sp_mat* X, const arma::uvec* Cols, 
+                             const arma::vec* w){
+  
+  // Calculating X'WX from the nonzero elements of each column
+  return(ParWeightedXTX(X, Cols, w));
+}
+
+arma::mat ParWeightedInfoCpp(const arma::fmat* X, const arma::uvec* Cols, 
+                             const arma::vec* w){
+  
+  // Calculating X'WX from blocks of rows that are widened to double
+  return(ParWeightedXTX(X, Cols, w));
+}
+
+// Calculates the diagonal of X'WX for the columns in Cols, this only takes O(np) 
+// so it can be used when X'WX is too expensive to form
+template<typename eT>
+arma::vec DenseWeightedInfoDiag(const arma::Mat<eT>* X, const arma::uvec* Cols, 
+                                const arma::vec* w){
+  arma::vec d(Cols->n_elem);
+  for(unsigned int j = 0; j < Cols->n_elem; j++){
+    const eT* xcol = X->colptr(Cols->at(j));
+    double temp = 0;
+    for(unsigned int i = 0; i < X->n_rows; i++){
+      temp += w->at(i) * xcol[i] * xcol[i];
+    }
+    d.at(j) = temp;
+  }
+  return(d);
+}
+
+arma::vec ParWeightedInfoDiagCpp(const arma::mat* X, const arma::uvec* Cols, 
+                                 const arma::vec* w){
+  return(DenseWeightedInfoDiag(X, Cols, w));
+}
+
+arma::vec ParWeightedInfoDiagCpp(const arma::fmat* X, const arma::uvec* Cols, 
+                                 const arma::vec* w){
+  return(DenseWeightedInfoDiag(X, Cols, w));
+}
+
+// Sparse version, only the nonzero elements of each column are used
+arma::vec ParWeightedInfoDiagCpp(const arma::sp_mat* X, const arma::uvec* Cols, 
+                                 const arma::vec* w){
+  arma::vec d(Cols->n_elem);
+  for(unsigned int j = 0; j < Cols->n_elem; j++){
+    arma::uword col = Cols->at(j);
+    double temp = 0;
+    for(arma::uword k = X->col_ptrs[col]; k < X->col_ptrs[col + 1]; k++){
+      temp += w->at(X->row_indices[k]) * X->values[k] * X->values[k];
+    }
+    d.at(j) = temp;
+  }
+  return(d);
+}
+
+// Calculates X'X and X'v for all of the columns of X, these are used to set up 
+// the searches
+arma::mat ParGramCpp(const arma::mat* X){
+  return(X->t() * *X);
+}
+
+arma::mat ParGramCpp(const arma::sp_mat* X){
+  return(arma::mat(X->t() * *X));
+}
+
+arma::mat ParGramCpp(const arma::fmat* X){
+  arma::uvec Cols = GetAllCols(X->n_cols);
+  arma::vec w(X->n_rows, arma::fill::ones);
+  return(ParWeightedXTX(X, &Cols, &w));
+}
+
+arma::vec ParCrossProdCpp(const arma::mat* X, const arma::vec* v){
+  return(X->t() * *v);
+}
+
+arma::vec ParCrossProdCpp(const arma::sp_mat* X, const arma::vec* v){
+  return(X->t() * *v);
+}
+
+arma::vec ParCrossProdCpp(const arma::fmat* X, const arma::vec* v){
+  arma::uvec Cols = GetAllCols(X->n_cols);
+  return(-ParWeightedScoreCpp(X, &Cols, v));
+}
+
 // Defining fisher information function
 arma::mat ParFisherInfoCpp(const arma::mat* X, arma::vec* Deriv, 
                            arma::vec* Var){
   
-  // Initializing matrix to store results
-  arma::mat FinalMat(X->n_cols, X->n_cols);
-  
   // Calculating weight vector, this is the diagonal of the W matrix
   arma::vec w = pow(*Deriv, 2) / *Var;
   w.replace(arma::datum::nan, 0);
   
   // Calculating X'WX
-  for(unsigned int i = 0; i < X->n_cols; i++){
-    
-    FinalMat(i, i) = arma::dot((X->col(i) % w), X->col(i));
-    
-    for(unsigned int j = i + 1; j < X->n_cols; j++){
-      
-      FinalMat(i, j) = arma::dot((X->col(j) % w), X->col(i));
-      FinalMat(j, i) = FinalMat(i, j);
-      
-    } 
-    
-  }
-  return FinalMat;
+  arma::uvec Cols = GetAllCols(X->n_cols);
+  return(ParWeightedInfoCpp(X, &Cols, &w));
 }
 
 // Function used to get step size
-void ParGetStepSize(const arma::mat* X, const arma::vec* Y, const arma::vec* Offset,
-                    arma::vec* mu, arma::vec* Deriv, arma::vec* Var, arma::vec* g1, 
+// eta holds the linear predictors for beta and is updated along with beta and mu
+template<typename T>
+void ParGetStepSize(const T* X, const arma::uvec* Cols, 
+                    const arma::vec* Y, const arma::vec* Offset,
+                    arma::vec* mu, arma::vec* eta, arma::vec* w, arma::vec* r, arma::vec* g1, 
                     arma::vec* p, arma::vec* beta, 
-                    std::string Dist, std::string Link, 
+                    GLMFamily Family, 
                     double* f0, double* f1, double* t, double* alpha, 
-                    std::string method){
+                    std::string method, GLMWorkspace* Workspace){
   
   // Defining maximum number of iterations and counter variable
   unsigned int maxiter = 40;
@@ -242,12 +365,18 @@ void ParGetStepSize(const arma::mat* X, const arma::vec* Y, const arma::vec* Off
   double temp = *alpha;
   double tempf1 = *f1;
   arma::vec tempbeta = *beta;
-  arma::vec tempmu = *mu;
+  arma::vec tempmu(Workspace->tempmu.memptr(), mu->n_elem, false, true);
+  arma::vec tempeta(Workspace->tempeta.memptr(), mu->n_elem, false, true);
+  arma::vec Xp(Workspace->Xp.memptr(), mu->n_elem, false, true);
   
   // Checking condition for initial alpha
+  // w and r are calculated along with mu and the log-likelihood for each step size
+  // X * p is found from the linear predictors for the full step, so the linear 
+  // predictors for each step halving are eta + temp * X * p and X is only used once
   tempbeta = *beta + temp * *p;
-  tempmu = ParLinkCpp(X, &tempbeta, Offset, Link, Dist);
-  tempf1 = ParLogLikelihoodCpp(X, Y, &tempmu, Dist);
+  ParLinPredCpp(X, Cols, &tempbeta, Offset, &tempeta);
+  Xp = tempeta - *eta;
+  tempf1 = ParIRLSEtaCpp(&tempeta, Y, &tempmu, w, r, Family);
   
   // Checking for descent direction
   if(*t <= 0){
@@ -264,9 +393,7 @@ void ParGetStepSize(const arma::mat* X, const arma::vec* Y, const arma::vec* Off
       if(*f0 >= tempf1 + C1 * temp * *t){
         
         // Calculating stuff to check second strong wolfe condition
-        *Deriv = ParDerivativeCpp(X, &tempbeta, Offset, &tempmu, Link, Dist);
-        *Var = ParVariance(&tempmu, Dist);
-        *g1 = ParScoreCpp(X, Y, Deriv, Var, &tempmu);
+        *g1 = ParWeightedScoreCpp(X, Cols, r);
         
         // Checking 2nd wolfe condition
         if(std::fabs(arma::dot(*p, *g1) <= C2 * std::fabs(*t))){
@@ -278,8 +405,8 @@ void ParGetStepSize(const arma::mat* X, const arma::vec* Y, const arma::vec* Off
       if(k < maxiter - 1){
         temp /= 2;
         tempbeta = *beta + temp * *p;
-        tempmu = ParLinkCpp(X, &tempbeta, Offset, Link, Dist);
-        tempf1 = ParLogLikelihoodCpp(X, Y, &tempmu, Dist);
+        tempeta = *eta + temp * Xp;
+        tempf1 = ParIRLSEtaCpp(&tempeta, Y, &tempmu, w, r, Family);
       }
     }
     
@@ -289,6 +416,7 @@ void ParGetStepSize(const arma::mat* X, const arma::vec* Y, const arma::vec* Off
       *alpha = temp;
       *beta = tempbeta;
       *mu = tempmu;
+      *eta = tempeta;
       *f1 = tempf1;
     }else if(k == maxiter){
       *alpha = 0;
@@ -299,66 +427,67 @@ void ParGetStepSize(const arma::mat* X, const arma::vec* Y, const arma::vec* Off
   }
 }
 
-// Creating LBFGS helper function
-arma::vec ParLBFGSHelperCpp(arma::vec* g1, arma::mat* s, arma::mat* y, 
-                            int* k, unsigned int* m, 
-                            arma::vec* r, arma::vec* alpha, const arma::mat* Info){
-  if(*k > 0) {
-    unsigned int max = std::min(*k, (int)*m);
-    unsigned int index;
-    for(unsigned int i = 1; i <= max; i++){
-      index = (*k - i) % *m;
-      alpha->at(index) = arma::dot(s->col(index), *g1)/arma::dot(y->col(index), s->col(index));
-      *g1 -= alpha->at(index) * y->col(index);
-      
-    }
-    index = (*k - 1)% *m;
-    *r = *Info * *g1;
-    for(unsigned int j = max; j > 0; j--){
-      index = (*k - j) % *m;
-      *r += s->col(index) * (alpha->at(index) - arma::dot(y->col(index), *r)/arma::dot(y->col(index), s->col(index)));
+// Performs the BFGS update of the approximate inverse hessian H in place
+// Since H is symmetric, (I - rho * s * y') * H * (I - rho * y * s') + rho * s * s' 
+// is H - rho * (s * Hy' + Hy * s') + (rho^2 * y'Hy + rho) * s * s', which only 
+// takes O(p^2) operations, Hy is used to store H * y
+void ParBFGSUpdateCpp(arma::mat* H, const arma::vec* s, const arma::vec* y, arma::vec* Hy){
+  double rho = 1 / arma::dot(*s, *y);
+  *Hy = *H * *y;
+  double c = rho * rho * arma::dot(*y, *Hy) + rho;
+  
+  // Only the rank-two correction is added to H, so no p x p temporaries are made
+  unsigned int p = H->n_rows;
+  for(unsigned int j = 0; j < p; j++){
+    double* Hcol = H->colptr(j);
+    double sj = s->at(j);
+    double Hyj = Hy->at(j);
+    for(unsigned int i = 0; i < p; i++){
+      Hcol[i] += c * s->at(i) * sj - rho * (s->at(i) * Hyj + Hy->at(i) * sj);
     }
-    
-    return *r;
   }
-  
-  return *Info * *g1;
 }
 
 // Creating LBFGS for GLMs for Parallel functions
-int ParLBFGSGLMCpp(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX,
-                   const arma::vec* Y, const arma::vec* Offset,
-                   std::string Link, std::string Dist, 
-                   double tol, int maxit, unsigned int m, bool UseXTWX){
+template<typename T>
+int ParLBFGSGLMCpp(arma::vec* beta, const T* X, const arma::uvec* Cols, 
+                   const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+                   GLMFamily Family, 
+                   double tol, int maxit, unsigned int m, bool UseXTWX, 
+                   GLMWorkspace* Workspace){
   
   int k = 0;
-  arma::vec mu = ParLinkCpp(X, beta, Offset, Link, Dist);
-  arma::vec Deriv = ParDerivativeCpp(X, beta, Offset, &mu, Link, Dist);
-  arma::vec Var = ParVariance(&mu, Dist);
+  arma::vec mu(Workspace->mu.memptr(), X->n_rows, false, true);
+  arma::vec w(Workspace->w.memptr(), X->n_rows, false, true);
+  arma::vec r(Workspace->r.memptr(), X->n_rows, false, true);
+  arma::vec eta(Workspace->eta.memptr(), X->n_rows, false, true);
+  ParLinPredCpp(X, Cols, beta, Offset, &eta);
+  double f1 = ParIRLSEtaCpp(&eta, Y, &mu, &w, &r, Family);
   m = std::min(beta->n_elem, m);
   arma::vec p(beta->n_elem);
   arma::vec g0(beta->n_elem);
-  arma::vec g1 = ParScoreCpp(X, Y, &Deriv, &Var, &mu);
-  arma::vec r(beta->n_elem);
+  arma::vec g1 = ParWeightedScoreCpp(X, Cols, &r);
+  arma::vec q(beta->n_elem);
   arma::vec alphavec(m);
+  arma::vec rho(m);
   arma::mat s(beta->n_elem, m);
   arma::mat y(beta->n_elem, m);
-  arma::mat Info(beta->n_elem, beta->n_elem);
   
+  // The initial inverse hessian is scaled by the inverse of the diagonal of the 
+  // fisher info, so the full info is never formed
+  arma::vec Diag(beta->n_elem);
   if(UseXTWX){
-    if(!solve(Info, *XTWX, arma::eye(arma::size(Info)), 
-              arma::solve_opts::no_approx + arma::solve_opts::likely_sympd)){
-      return(-2);
-    }
+    Diag = XTWX->diag();
   }
   else{
-    if(!solve(Info, ParFisherInfoCpp(X, &Deriv, &Var), arma::eye(arma::size(Info)), 
-              arma::solve_opts::no_approx + arma::solve_opts::likely_sympd)){
-      return(-2);
-    }
+    Diag = ParWeightedInfoDiagCpp(X, Cols, &w);
   }
+  if(any(Diag <= 0)){
+    return(-2);
+  }
+  Diag = 1 / Diag;
+  int npairs = 0;
   double f0;
-  double f1 = ParLogLikelihoodCpp(X, Y, &mu, Dist);
   double t;
   double alpha;
   
@@ -375,12 +504,13 @@ int ParLBFGSGLMCpp(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX,
     f0 = f1;
     
     // Calculating p (search direction) based on L-BFGS approximation to inverse info
-    p = -ParLBFGSHelperCpp(&g1, &s, &y, &k, &m, &r, &alphavec, &Info);
+    LBFGSDirectionCpp(&g1, &s, &y, &rho, npairs, m, &Diag, &q, &alphavec, &p);
     t = -arma::dot(g0, p);
     
     // Finding alpha with backtracking linesearch using strong wolfe conditions
-    // This function also calculates mu, Deriv, Var, and g1 for the selected step size
-    ParGetStepSize(X, Y, Offset, &mu, &Deriv, &Var, &g1, &p, beta, Dist, Link, &f0 ,&f1, &t, &alpha, "backtrack");
+    // This function also calculates mu, w, r, and g1 for the selected step size
+    ParGetStepSize(X, Cols, Y, Offset, &mu, &eta, &w, &r, &g1, &p, beta, Family, &f0 ,&f1, &t, &alpha, "backtrack", 
+                   Workspace);
     
     if(std::fabs(f1 -  f0) < tol || all(abs(alpha * p) < tol) || alpha == 0){
       if(std::isinf(f1)|| beta->has_nan() || alpha == 0){
@@ -389,9 +519,15 @@ int ParLBFGSGLMCpp(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX,
       k++;
       break;}
     
-    // Updating s and y for L-BFGS update
-    s.col(k % m) = alpha * p;
-    y.col(k % m) = g1 - g0;
+    // Updating s and y for L-BFGS update, the pair is skipped when s'y <= 0 
+    // since the approximate inverse hessian wouldn't be positive definite
+    s.col(npairs % m) = alpha * p;
+    y.col(npairs % m) = g1 - g0;
+    double sy = arma::dot(s.col(npairs % m), y.col(npairs % m));
+    if(sy > 0){
+      rho.at(npairs % m) = 1 / sy;
+      npairs++;
+    }
     
     // Incrementing iteration number
     k++;
@@ -401,19 +537,25 @@ int ParLBFGSGLMCpp(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX,
 
 
 // Creating BFGS for GLMs for Parallel functions
-int ParBFGSGLMCpp(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX,  
-                  const arma::vec* Y, const arma::vec* Offset,
-                  std::string Link, std::string Dist,
-                  double tol, int maxit, bool UseXTWX){
+template<typename T>
+int ParBFGSGLMCpp(arma::vec* beta, const T* X, const arma::uvec* Cols, 
+                  const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+                  GLMFamily Family,
+                  double tol, int maxit, bool UseXTWX, 
+                  GLMWorkspace* Workspace){
   
   int k = 0;
-  arma::vec mu = ParLinkCpp(X, beta, Offset, Link, Dist);
-  arma::vec Deriv = ParDerivativeCpp(X, beta, Offset, &mu, Link, Dist);
-  arma::vec Var = ParVariance(&mu, Dist);
-  arma::vec g1 = ParScoreCpp(X, Y, &Deriv, &Var, &mu);
+  arma::vec mu(Workspace->mu.memptr(), X->n_rows, false, true);
+  arma::vec w(Workspace->w.memptr(), X->n_rows, false, true);
+  arma::vec r(Workspace->r.memptr(), X->n_rows, false, true);
+  arma::vec eta(Workspace->eta.memptr(), X->n_rows, false, true);
+  ParLinPredCpp(X, Cols, beta, Offset, &eta);
+  double f1 = ParIRLSEtaCpp(&eta, Y, &mu, &w, &r, Family);
+  arma::vec g1 = ParWeightedScoreCpp(X, Cols, &r);
   arma::vec p(beta->n_elem);
   arma::vec s(beta->n_elem);
   arma::vec y(beta->n_elem);
+  arma::vec Hy(beta->n_elem);
   arma::vec g0(beta->n_elem);
   arma::mat H1(beta->n_elem, beta->n_elem);
   
@@ -424,15 +566,13 @@ int ParBFGSGLMCpp(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX,
     }
   }
   else{
-    if(!solve(H1, ParFisherInfoCpp(X, &Deriv, &Var), arma::eye(arma::size(H1)), 
+    if(!solve(H1, ParWeightedInfoCpp(X, Cols, &w), arma::eye(arma::size(H1)), 
               arma::solve_opts::no_approx + arma::solve_opts::likely_sympd)){
       return(-2);
     }
   }
   
   double f0;
-  double f1 = ParLogLikelihoodCpp(X, Y, &mu, Dist);
-  double rho;
   double alpha;
   double t;
   
@@ -452,8 +592,9 @@ int ParBFGSGLMCpp(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX,
     t = -arma::dot(g0, p);
     
     // Finding alpha with backtracking linesearch using strong wolfe conditions
-    // This function also calculates mu, Deriv, Var, and g1 for the selected step size
-    ParGetStepSize(X, Y, Offset, &mu, &Deriv, &Var, &g1, &p, beta, Dist, Link, &f0 ,&f1, &t, &alpha, "backtrack");
+    // This function also calculates mu, w, r, and g1 for the selected step size
+    ParGetStepSize(X, Cols, Y, Offset, &mu, &eta, &w, &r, &g1, &p, beta, Family, &f0 ,&f1, &t, &alpha, "backtrack", 
+                   Workspace);
     
     // Checking for convergence or non-convergence
     if(std::fabs(f1 -  f0) < tol || all(abs(alpha * p) < tol) || alpha == 0){
@@ -466,10 +607,7 @@ int ParBFGSGLMCpp(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX,
     // Performing BFGS update
     s = alpha * p;
     y = g1 - g0;
-    rho = 1/arma::dot(s, y);
-    
-    H1 = (arma::diagmat(arma::ones(beta->n_elem)) - rho * s * y.t()) * H1 * 
-      (arma::diagmat(arma::ones(beta->n_elem)) - rho * y * s.t()) + rho * s * s.t();
+    ParBFGSUpdateCpp(&H1, &s, &y, &Hy);
     
     // Incrementing iteration number
     k++;
@@ -479,26 +617,30 @@ int ParBFGSGLMCpp(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX,
 
 
 // Creating Fisher Scoring for GLMs for Parallel functions
-int ParFisherScoringGLMCpp(arma::vec* beta, const arma::mat* X, 
+template<typename T>
+int ParFisherScoringGLMCpp(arma::vec* beta, const T* X, const arma::uvec* Cols, 
                            const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
-                           std::string Link, std::string Dist,
-                           double tol, int maxit, bool UseXTWX){
+                           GLMFamily Family,
+                           double tol, int maxit, bool UseXTWX, 
+                           GLMWorkspace* Workspace){
   
   int k = 0;
-  arma::vec mu = ParLinkCpp(X, beta, Offset, Link, Dist);
-  arma::vec Deriv = ParDerivativeCpp(X, beta, Offset, &mu, Link, Dist);
-  arma::vec Var = ParVariance(&mu, Dist);
-  arma::vec g1 = ParScoreCpp(X, Y, &Deriv, &Var, &mu);
+  arma::vec mu(Workspace->mu.memptr(), X->n_rows, false, true);
+  arma::vec w(Workspace->w.memptr(), X->n_rows, false, true);
+  arma::vec r(Workspace->r.memptr(), X->n_rows, false, true);
+  arma::vec eta(Workspace->eta.memptr(), X->n_rows, false, true);
+  ParLinPredCpp(X, Cols, beta, Offset, &eta);
+  double f1 = ParIRLSEtaCpp(&eta, Y, &mu, &w, &r, Family);
+  arma::vec g1 = ParWeightedScoreCpp(X, Cols, &r);
   arma::vec p(beta->n_elem);
   arma::mat H1(beta->n_elem, beta->n_elem);
   if(UseXTWX){
     H1 = *XTWX;
   }
   else{
-    H1 = ParFisherInfoCpp(X, &Deriv, &Var);
+    H1 = ParWeightedInfoCpp(X, Cols, &w);
   }
   double f0;
-  double f1 = ParLogLikelihoodCpp(X, Y, &mu, Dist);
   double alpha;
   double t;
   while(arma::norm(g1) > tol){
@@ -518,8 +660,9 @@ int ParFisherScoringGLMCpp(arma::vec* beta, const arma::mat* X,
     t = -arma::dot(g1, p);
     
     // Finding alpha with backtracking linesearch using strong wolfe conditions
-    // This function also calculates mu, Deriv, Var, and g1 for the selected step size
-    ParGetStepSize(X, Y, Offset, &mu, &Deriv, &Var, &g1, &p, beta, Dist, Link, &f0 ,&f1, &t, &alpha, "backtrack");
+    // This function also calculates mu, w, r, and g1 for the selected step size
+    ParGetStepSize(X, Cols, Y, Offset, &mu, &eta, &w, &r, &g1, &p, beta, Family, &f0 ,&f1, &t, &alpha, "backtrack", 
+                   Workspace);
     
     // Checking for convergence or non-convergence
     if(std::fabs(f1 -  f0) < tol || all(abs(alpha * p) < tol) || alpha == 0){
@@ -530,7 +673,7 @@ int ParFisherScoringGLMCpp(arma::vec* beta, const arma::mat* X,
       break;}
     
     // Calculating information
-    H1 = ParFisherInfoCpp(X, &Deriv, &Var);
+    H1 = ParWeightedInfoCpp(X, Cols, &w);
     
     // Incrementing iteration number
     k++;
@@ -538,13 +681,265 @@ int ParFisherScoringGLMCpp(arma::vec* beta, const arma::mat* X,
   return(k);
 }
 
-int ParLinRegCppShort(arma::vec* beta, const arma::mat* x, const arma::mat* XTWX, const arma::mat* y,
-                      const arma::vec* offset){
+// Gets the negative log-likelihood, score, and fisher info for a set of models 
+// in one pass over the rows of X, each block of rows is used by all of the models 
+// while it is in cache instead of reading X once for each model
+// Cols holds the columns of X for each model and only the models with Active set
+// are evaluated, the fisher info is only found when H isn't null
+template<typename eT>
+void BatchIRLSPass(const arma::Mat<eT>* X, const std::vector<arma::uvec>* Cols, 
+                   const arma::vec* Y, const arma::vec* Offset, 
+                   const std::vector<arma::vec>* betas, const std::vector<bool>* Active,
+                   GLMFamily Family, arma::vec* f, std::vector<arma::vec>* g, 
+                   std::vector<arma::mat>* H, std::vector<arma::mat>* Buffers){
+  
+  unsigned int K = Cols->size();
+  for(unsigned int k = 0; k < K; k++){
+    if(Active->at(k)){
+      f->at(k) = 0;
+      g->at(k).zeros();
+      if(H != nullptr){
+        H->at(k).zeros();
+      }
+    }
+  }
+  
+  // Initializing vectors for linear predictors, weights, and score contributions 
+  // for a block of rows
+  arma::vec eta(VecBlock);
+  arma::vec w(VecBlock);
+  arma::vec r(VecBlock);
+  
+  unsigned int n = X->n_rows;
+  for(unsigned int start = 0; start < n; start += VecBlock){
+    unsigned int len = std::min(VecBlock, n - start);
+    arma::vec eta1(eta.memptr(), len, false, true);
+    arma::vec w1(w.memptr(), len, false, true);
+    arma::vec r1(r.memptr(), len, false, true);
+    const arma::vec Y1(const_cast<double*>(Y->memptr()) + start, len, false, true);
+    const double* Offset1 = Offset->memptr() + start;
+    
+    for(unsigned int k = 0; k < K; k++){
+      if(!Active->at(k)){
+        continue;
+      }
+      const arma::uvec* Cols1 = &Cols->at(k);
+      const arma::vec* beta = &betas->at(k);
+      
+      // Calculating linear predictors for this block
+      for(unsigned int i = 0; i < len; i++){
+        eta1.at(i) = Offset1[i];
+      }
+      for(unsigned int j = 0; j < Cols1->n_elem; j++){
+        const eT* xcol = X->colptr(Cols1->at(j)) + start;
+        double b = beta->at(j);
+        for(unsigned int i = 0; i < len; i++){
+          eta1.at(i) += b * xcol[i];
+        }
+      }
+      
+      // Calculating mu, weights, score contributions, and log-likelihood
+      f->at(k) += FamilyDispatch<IRLSKernel>(Family, &eta1, &Y1, &eta1, &w1, &r1, false);
+      
+      // Updating score
+      for(unsigned int j = 0; j < Cols1->n_elem; j++){
+        const eT* xcol = X->colptr(Cols1->at(j)) + start;
+        double temp = 0;
+        for(unsigned int i = 0; i < len; i++){
+          temp += xcol[i] * r1.at(i);
+        }
+        g->at(k).at(j) -= temp;
+      }
+      
+      // Updating fisher info
+      if(H != nullptr){
+        WeightedXTXRows(X, Cols1, w1.memptr(), &Buffers->at(k), &H->at(k), start, len);
+      }
+    }
+  }
+  
+  if(H == nullptr){
+    return;
+  }
+  for(unsigned int k = 0; k < K; k++){
+    if(Active->at(k)){
+      H->at(k) = symmatu(H->at(k));
+    }
+  }
+}
+
+// Fisher scoring for a set of models that differ by a variable, these are the 
+// children of a model in the branch and bound methods or the models checked in 
+// one step of the stepwise methods
+// Each iteration makes one pass over X for all of the models, the step sizes are 
+// found with the same backtracking line search as ParGetStepSize, a model that 
+// is still searching for a step size just uses a smaller step in the next pass
+// The trial steps only get the log-likelihood and score, the fisher info is found 
+// in a separate pass for the models whose steps were accepted
+// betas holds the initial values and is overwritten with the estimates, the 
+// number of iterations is returned for each model and it is negative for models 
+// that failed, these should be refit one at a time
+template<typename eT>
+arma::ivec ParBatchFisherScoringGLMCpp(const arma::Mat<eT>* X, 
+                                       const std::vector<arma::uvec>* Cols, 
+                                       const arma::vec* Y, const arma::vec* Offset,
+                                       std::vector<arma::vec>* betas, 
+                                       GLMFamily Family, double tol, int maxit){
+  
+  // Defining maximum number of step halvings and C1 and C2 for backtracking
+  unsigned int maxiter = 40;
+  double C1 = pow(10, -4);
+  double C2 = 0.9;
+  
+  // Initializing the state for each model
+  unsigned int K = Cols->size();
+  arma::ivec Iters(K);
+  arma::ivec k(K, arma::fill::zeros);
+  arma::uvec halvings(K, arma::fill::zeros);
+  arma::vec f(K);
+  arma::vec f0(K);
+  arma::vec f1(K);
+  arma::vec t(K);
+  arma::vec alpha(K);
+  std::vector<arma::vec> g(K);
+  std::vector<arma::vec> g1(K);
+  std::vector<arma::vec> p(K);
+  std::vector<arma::vec> trial(K);
+  std::vector<arma::mat> H(K);
+  std::vector<arma::mat> Buffers(K);
+  std::vector<bool> Active(K, true);
+  std::vector<bool> Searching(K, false);
+  std::vector<bool> Accepted(K);
+  unsigned int nactive = K;
+  for(unsigned int j = 0; j < K; j++){
+    unsigned int p1 = Cols->at(j).n_elem;
+    g.at(j).set_size(p1);
+    g1.at(j).set_size(p1);
+    H.at(j).set_size(p1, p1);
+    Buffers.at(j).set_size(std::min(VecBlock, (unsigned int)X->n_rows), p1 + 1);
+  }
+  
+  // Getting log-likelihood, score, and info for the initial values
+  BatchIRLSPass(X, Cols, Y, Offset, betas, &Active, Family, &f, &g, &H, &Buffers);
+  
+  while(nactive > 0){
+    
+    // Getting search directions for the models that aren't searching for a step size
+    for(unsigned int j = 0; j < K; j++){
+      if(!Active.at(j) || Searching.at(j)){
+        continue;
+      }
+      if(arma::norm(g.at(j)) <= tol){
+        Iters.at(j) = k.at(j);
+      }
+      else if(k.at(j) >= maxit){
+        Iters.at(j) = -1;
+      }
+      else if(!arma::solve(p.at(j), -H.at(j), g.at(j), 
+                           arma::solve_opts::no_approx + arma::solve_opts::likely_sympd)){
+        Iters.at(j) = -2;
+      }
+      else{
+        // Starting the line search, this fails if p isn't a descent direction
+        t.at(j) = -arma::dot(g.at(j), p.at(j));
+        if(t.at(j) > 0){
+          f0.at(j) = f.at(j);
+          alpha.at(j) = 1;
+          halvings.at(j) = 0;
+          Searching.at(j) = true;
+          continue;
+        }
+        Iters.at(j) = -2;
+      }
+      Active.at(j) = false;
+      nactive--;
+    }
+    if(nactive == 0){
+      break;
+    }
+    
+    // Evaluating the current step size for each model
+    for(unsigned int j = 0; j < K; j++){
+      if(Active.at(j)){
+        trial.at(j) = betas->at(j) + alpha.at(j) * p.at(j);
+      }
+    }
+    BatchIRLSPass(X, Cols, Y, Offset, &trial, &Active, Family, &f1, &g1, nullptr, 
+                  &Buffers);
+    
+    // Checking the strong wolfe conditions for each model
+    bool accepted = false;
+    for(unsigned int j = 0; j < K; j++){
+      Accepted.at(j) = false;
+      if(!Active.at(j)){
+        continue;
+      }
+      if(!(f0.at(j) >= f1.at(j) + C1 * alpha.at(j) * t.at(j) && 
+         arma::dot(p.at(j), g1.at(j)) <= C2 * t.at(j))){
+        
+        // Performing step halving, the model fails if no step size is found
+        halvings.at(j)++;
+        if(halvings.at(j) < maxiter){
+          alpha.at(j) /= 2;
+          continue;
+        }
+        Iters.at(j) = -2;
+        Active.at(j) = false;
+        nactive--;
+        continue;
+      }
+      
+      // Taking the step
+      Searching.at(j) = false;
+      betas->at(j) = trial.at(j);
+      k.at(j)++;
+      
+      // Checking for convergence
+      if(std::fabs(f1.at(j) - f0.at(j)) < tol || all(abs(alpha.at(j) * p.at(j)) < tol)){
+        Iters.at(j) = k.at(j);
+        if(std::isinf(f1.at(j)) || betas->at(j).has_nan()){
+          Iters.at(j) = -2;
+        }
+        Active.at(j) = false;
+        nactive--;
+        continue;
+      }
+      f.at(j) = f1.at(j);
+      std::swap(g.at(j), g1.at(j));
+      Accepted.at(j) = true;
+      accepted = true;
+    }
+    
+    // Getting the fisher info for the models that took a step
+    if(accepted){
+      BatchIRLSPass(X, Cols, Y, Offset, betas, &Accepted, Family, &f1, &g1, &H, 
+                    &Buffers);
+    }
+  }
   
+  return(Iters);
+}
+
+// Sparse design matrices don't have contiguous blocks of rows, so the models are 
+// left to be fit one at a time
+arma::ivec ParBatchFisherScoringGLMCpp(const arma::sp_mat* X, 
+                                       const std::vector<arma::uvec>* Cols, 
+                                       const arma::vec* Y, const arma::vec* Offset,
+                                       std::vector<arma::vec>* betas, 
+                                       GLMFamily Family, double tol, int maxit){
+  arma::ivec Iters(Cols->size());
+  Iters.fill(-1);
+  return(Iters);
+}
+
+template<typename T>
+int ParLinRegCppShort(arma::vec* beta, const T* x, const arma::uvec* Cols, 
+                      const arma::mat* XTWX, const arma::vec* y,
+                      const arma::vec* offset){
   
-  // Calculating inverse of X'X
-  arma::mat InvXX(x->n_cols, x->n_cols, arma::fill::zeros); 
-  arma::vec XY = x->t() * (*y - *offset);  
+  // Calculating X'(y - offset) for the columns in Cols
+  arma::vec r = *y - *offset;
+  arma::vec XY = -ParWeightedScoreCpp(x, Cols, &r);
   arma::vec tempbeta = *beta;
   if(!arma::solve(*beta, *XTWX, XY, arma::solve_opts::no_approx + arma::solve_opts::likely_sympd)){
     *beta = tempbeta;
@@ -556,18 +951,23 @@ int ParLinRegCppShort(arma::vec* beta, const arma::mat* x, const arma::mat* XTWX
 
 // Gets initial values for gamma and gaussian regression with log/inverse/sqrt link with 
 // transformed y linear regression
-void PargetInit(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, 
-                const arma::vec* Offset, std::string Dist, std::string Link, 
-                bool* UseXTWX){
+template<typename T>
+void PargetInit(arma::vec* beta, const T* X, const arma::uvec* Cols, 
+                const arma::mat* XTWX, const arma::vec* Y, 
+                const arma::vec* Offset, GLMFamily Family, 
+                bool* UseXTWX, GLMWorkspace* Workspace){
   
-  if(Link == "log"){
-    arma::vec NewY = *Y;
+  // The transformed response is stored in the workspace since r is not used yet
+  if(Family.Link == GLMLink::log){
+    arma::vec NewY(Workspace->r.memptr(), Y->n_elem, false, true);
+    NewY = *Y;
     NewY = log(NewY.clamp(1e-4, arma::datum::inf));
-    ParLinRegCppShort(beta, X, XTWX, &NewY, Offset);
+    ParLinRegCppShort(beta, X, Cols, XTWX, &NewY, Offset);
     *UseXTWX = false;
     
-  }else if(Link == "inverse"){
-    arma::vec NewY = *Y;
+  }else if(Family.Link == GLMLink::inverse){
+    arma::vec NewY(Workspace->r.memptr(), Y->n_elem, false, true);
+    NewY = *Y;
     NewY.transform( [](double val) {
       if(std::fabs(val) <= 1e-2){
         val = (val / std::fabs(val)) * 1e-2;
@@ -575,27 +975,30 @@ void PargetInit(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX, cons
       return(val);
     } );
     NewY = 1 / NewY;
-    ParLinRegCppShort(beta, X, XTWX, &NewY, Offset);
+    ParLinRegCppShort(beta, X, Cols, XTWX, &NewY, Offset);
     *UseXTWX = false;
     
-  }else if(Link == "sqrt"){
-    const arma::vec NewY = sqrt(*Y);
-    ParLinRegCppShort(beta, X, XTWX, &NewY, Offset);
+  }else if(Family.Link == GLMLink::sqrt){
+    arma::vec NewY(Workspace->r.memptr(), Y->n_elem, false, true);
+    NewY = sqrt(*Y);
+    ParLinRegCppShort(beta, X, Cols, XTWX, &NewY, Offset);
     *UseXTWX = false;
     
-  }else if(Link == "identity" && Dist != "gaussian"){
-    ParLinRegCppShort(beta, X, XTWX, Y, Offset);
+  }else if(Family.Link == GLMLink::identity && Family.Dist != GLMDist::gaussian){
+    ParLinRegCppShort(beta, X, Cols, XTWX, Y, Offset);
     *UseXTWX = false;
     
-  }else if(Link == "logit"){
-    arma::vec NewY = *Y;
+  }else if(Family.Link == GLMLink::logit){
+    arma::vec NewY(Workspace->r.memptr(), Y->n_elem, false, true);
+    NewY = *Y;
     NewY = NewY.clamp(1e-4, 1 - 1e-4);
     NewY = log(NewY / (1 - NewY));
-    ParLinRegCppShort(beta, X, XTWX, &NewY, Offset);
+    ParLinRegCppShort(beta, X, Cols, XTWX, &NewY, Offset);
     *UseXTWX = false;
     
-  }else if(Link == "probit"){
-    arma::vec NewY = *Y;
+  }else if(Family.Link == GLMLink::probit){
+    arma::vec NewY(Workspace->r.memptr(), Y->n_elem, false, true);
+    NewY = *Y;
     double val0 = boost::math::quantile(boost::math::normal(0.0, 1.0), 1e-4);
     double val1 = boost::math::quantile(boost::math::normal(0.0, 1.0), 1 - 1e-4);
     for(unsigned int i = 0; i < NewY.n_elem; i++){
@@ -605,16 +1008,111 @@ void PargetInit(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX, cons
         NewY.at(i) = val1;
       }
     }
-    ParLinRegCppShort(beta, X, XTWX, &NewY, Offset);
+    ParLinRegCppShort(beta, X, Cols, XTWX, &NewY, Offset);
     *UseXTWX = false;
     
-  }else if(Link == "cloglog"){
-    arma::vec NewY = *Y;
+  }else if(Family.Link == GLMLink::cloglog){
+    arma::vec NewY(Workspace->r.memptr(), Y->n_elem, false, true);
+    NewY = *Y;
     NewY = NewY.clamp(1e-4, 1 - 1e-4);
     NewY = log(-log(1 - NewY));
-    ParLinRegCppShort(beta, X, XTWX, &NewY, Offset);
+    ParLinRegCppShort(beta, X, Cols, XTWX, &NewY, Offset);
     *UseXTWX = false;
     
   }
   
 }
+
+// Instantiating the fitting functions for dense, sparse, and single precision
+// design matrices
+template double ParIRLSCpp<arma::mat>(const arma::mat* X, const arma::uvec* Cols, 
+                                   const arma::vec* Y, const arma::vec* Offset, 
+                                   arma::vec* beta, arma::vec* mu, arma::vec* w, 
+                                   arma::vec* r, GLMFamily Family);
+template int ParLBFGSGLMCpp<arma::mat>(arma::vec* beta, const arma::mat* X, const arma::uvec* Cols, 
+                                   const arma::mat* XTWX, const arma::vec* Y, 
+                                   const arma::vec* Offset, GLMFamily Family, 
+                                   double tol, int maxit, unsigned int m, bool UseXTWX, 
+                                   GLMWorkspace* Workspace);
+template int ParBFGSGLMCpp<arma::mat>(arma::vec* beta, const arma::mat* X, const arma::uvec* Cols, 
+                                  const arma::mat* XTWX, const arma::vec* Y, 
+                                  const arma::vec* Offset, GLMFamily Family, 
+                                  double tol, int maxit, bool UseXTWX, 
+                                  GLMWorkspace* Workspace);
+template int ParFisherScoringGLMCpp<arma::mat>(arma::vec* beta, const arma::mat* X, 
+                                           const arma::uvec* Cols, const arma::mat* XTWX, 
+                                           const arma::vec* Y, const arma::vec* Offset, 
+                                           GLMFamily Family, double tol, int maxit, 
+                                           bool UseXTWX, GLMWorkspace* Workspace);
+template int ParLinRegCppShort<arma::mat>(arma::vec* beta, const arma::mat* x, const arma::uvec* Cols, 
+                                      const arma::mat* XTWX, const arma::vec* y, 
+                                      const arma::vec* offset);
+template void PargetInit<arma::mat>(arma::vec* beta, const arma::mat* X, const arma::uvec* Cols, 
+                               const arma::mat* XTWX, const arma::vec* Y, 
+                               const arma::vec* Offset, GLMFamily Family, 
+                               bool* UseXTWX, GLMWorkspace* Workspace);
+
+template double ParIRLSCpp<arma::sp_mat>(const arma::sp_mat* X, const arma::uvec* Cols, 
+                                   const arma::vec* Y, const arma::vec* Offset, 
+                                   arma::vec* beta, arma::vec* mu, arma::vec* w, 
+                                   arma::vec* r, GLMFamily Family);
+template int ParLBFGSGLMCpp<arma::sp_mat>(arma::vec* beta, const arma::sp_mat* X, const arma::uvec* Cols, 
+                                   const arma::mat* XTWX, const arma::vec* Y, 
+                                   const arma::vec* Offset, GLMFamily Family, 
+                                   double tol, int maxit, unsigned int m, bool UseXTWX, 
+                                   GLMWorkspace* Workspace);
+template int ParBFGSGLMCpp<arma::sp_mat>(arma::vec* beta, const arma::sp_mat* X, const arma::uvec* Cols, 
+                                  const arma::mat* XTWX, const arma::vec* Y, 
+                                  const arma::vec* Offset, GLMFamily Family, 
+                                  double tol, int maxit, bool UseXTWX, 
+                                  GLMWorkspace* Workspace);
+template int ParFisherScoringGLMCpp<arma::sp_mat>(arma::vec* beta, const arma::sp_mat* X, 
+                                           const arma::uvec* Cols, const arma::mat* XTWX, 
+                                           const arma::vec* Y, const arma::vec* Offset, 
+                                           GLMFamily Family, double tol, int maxit, 
+                                           bool UseXTWX, GLMWorkspace* Workspace);
+template int ParLinRegCppShort<arma::sp_mat>(arma::vec* beta, const arma::sp_mat* x, const arma::uvec* Cols, 
+                                      const arma::mat* XTWX, const arma::vec* y, 
+                                      const arma::vec* offset);
+template void PargetInit<arma::sp_mat>(arma::vec* beta, const arma::sp_mat* X, const arma::uvec* Cols, 
+                               const arma::mat* XTWX, const arma::vec* Y, 
+                               const arma::vec* Offset, GLMFamily Family, 
+                               bool* UseXTWX, GLMWorkspace* Workspace);
+
+template double ParIRLSCpp<arma::fmat>(const arma::fmat* X, const arma::uvec* Cols, 
+                                   const arma::vec* Y, const arma::vec* Offset, 
+                                   arma::vec* beta, arma::vec* mu, arma::vec* w, 
+                                   arma::vec* r, GLMFamily Family);
+template int ParLBFGSGLMCpp<arma::fmat>(arma::vec* beta, const arma::fmat* X, const arma::uvec* Cols, 
+                                   const arma::mat* XTWX, const arma::vec* Y, 
+                                   const arma::vec* Offset, GLMFamily Family, 
+                                   double tol, int maxit, unsigned int m, bool UseXTWX, 
+                                   GLMWorkspace* Workspace);
+template int ParBFGSGLMCpp<arma::fmat>(arma::vec* beta, const arma::fmat* X, const arma::uvec* Cols, 
+                                  const arma::mat* XTWX, const arma::vec* Y, 
+                                  const arma::vec* Offset, GLMFamily Family, 
+                                  double tol, int maxit, bool UseXTWX, 
+                                  GLMWorkspace* Workspace);
+template int ParFisherScoringGLMCpp<arma::fmat>(arma::vec* beta, const arma::fmat* X, 
+                                           const arma::uvec* Cols, const arma::mat* XTWX, 
+                                           const arma::vec* Y, const arma::vec* Offset, 
+                                           GLMFamily Family, double tol, int maxit, 
+                                           bool UseXTWX, GLMWorkspace* Workspace);
+template int ParLinRegCppShort<arma::fmat>(arma::vec* beta, const arma::fmat* x, const arma::uvec* Cols, 
+                                      const arma::mat* XTWX, const arma::vec* y, 
+                                      const arma::vec* offset);
+template void PargetInit<arma::fmat>(arma::vec* beta, const arma::fmat* X, const arma::uvec* Cols, 
+                               const arma::mat* XTWX, const arma::vec* Y, 
+                               const arma::vec* Offset, GLMFamily Family, 
+                               bool* UseXTWX, GLMWorkspace* Workspace);
+
+template arma::ivec ParBatchFisherScoringGLMCpp<double>(const arma::mat* X, 
+                                                        const std::vector<arma::uvec>* Cols, 
+                                                        const arma::vec* Y, const arma::vec* Offset,
+                                                        std::vector<arma::vec>* betas, 
+                                                        GLMFamily Family, double tol, int maxit);
+template arma::ivec ParBatchFisherScoringGLMCpp<float>(const arma::fmat* X, 
+                                                       const std::vector<arma::uvec>* Cols, 
+                                                       const arma::vec* Y, const arma::vec* Offset,
+                                                       std::vector<arma::vec>* betas, 
+                                                       GLMFamily Family, double tol, int maxit);
@@ -2,53 +2,127 @@
 #define ParBranchGLMHelpers_H
 
 #include <RcppArmadillo.h>
+#include "GLMFamily.h"
+#include "GLMWorkspace.h"
+#include <vector>
 using namespace Rcpp;
 
-arma::vec ParVariance(arma::vec* mu, std::string Dist);
+arma::vec ParVariance(arma::vec* mu, GLMFamily Family);
 
 arma::vec ParDerivativeCpp(const arma::mat* X, arma::vec* beta, const arma::vec* Offset,
-                           arma::vec* mu, std::string Link, std::string Dist);
+                           arma::vec* mu, GLMFamily Family);
 
-arma::vec ParScoreCpp(const arma::mat* X, const arma::vec* Y, arma::vec* Deriv,
-                   arma::vec* Var, arma::vec* mu);
+arma::uvec GetAllCols(unsigned int p);
 
-arma::mat ParFisherInfoCpp(const arma::mat* X, arma::vec* Deriv, 
-                        arma::vec* Var);
+void ParLinPredCpp(const arma::mat* X, const arma::uvec* Cols, const arma::vec* beta, 
+                   const arma::vec* Offset, arma::vec* eta);
+
+void ParLinPredCpp(const arma::sp_mat* X, const arma::uvec* Cols, const arma::vec* beta, 
+                   const arma::vec* Offset, arma::vec* eta);
+
+void ParLinPredCpp(const arma::fmat* X, const arma::uvec* Cols, const arma::vec* beta, 
+                   const arma::vec* Offset, arma::vec* eta);
+
+template<typename T>
+double ParIRLSCpp(const T* X, const arma::uvec* Cols, 
+                  const arma::vec* Y, const arma::vec* Offset, 
+                  arma::vec* beta, arma::vec* mu, arma::vec* w, arma::vec* r, 
+                  GLMFamily Family);
+
+arma::vec ParWeightedScoreCpp(const arma::mat* X, const arma::uvec* Cols, 
+                              const arma::vec* r);
+
+arma::vec ParWeightedScoreCpp(const arma::sp_mat* X, const arma::uvec* Cols, 
+                              const arma::vec* r);
+
+arma::vec ParWeightedScoreCpp(const arma::fmat* X, const arma::uvec* Cols, 
+                              const arma::vec* r);
+
+arma::mat ParWeightedInfoCpp(const arma::mat* X, const arma::uvec* Cols, 
+                             const arma::vec* w);
 
-arma::vec ParLBFGSHelperCpp(arma::vec* g1, arma::mat* s, arma::mat* y, 
-                         unsigned int* k, unsigned int* m, 
-                         arma::vec* r, arma::vec* alpha, const arma::mat* Info);
+arma::mat ParWeightedInfoCpp(const arma::sp_mat* X, const arma::uvec* Cols, 
+                             const arma::vec* w);
 
+arma::mat ParWeightedInfoCpp(const arma::fmat* X, const arma::uvec* Cols, 
+                             const arma::vec* w);
 
+arma::vec ParWeightedInfoDiagCpp(const arma::mat* X, const arma::uvec* Cols, 
+                                 const arma::vec* w);
 
-int ParLBFGSGLMCpp(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX, 
-                   const arma::vec* Y, const arma::vec* Offset,
-                   std::string Link, std::string Dist, 
-                   double tol, int maxit, unsigned int m, bool UseXTWX);
+arma::vec ParWeightedInfoDiagCpp(const arma::sp_mat* X, const arma::uvec* Cols, 
+                                 const arma::vec* w);
 
-int ParBFGSGLMCpp(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX,
-                  const arma::vec* Y, const arma::vec* Offset,
-                  std::string Link, std::string Dist,
-			double tol, int maxit, bool UseXTWX);
+arma::vec ParWeightedInfoDiagCpp(const arma::fmat* X, const arma::uvec* Cols, 
+                                 const arma::vec* w);
 
-int ParFisherScoringGLMCpp(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX,
-                               const arma::vec* Y, const arma::vec* Offset,
-                               std::string Link, std::string Dist,
-                               double tol, int maxit, bool UseXTWX);
+arma::mat ParGramCpp(const arma::mat* X);
+
+arma::mat ParGramCpp(const arma::sp_mat* X);
+
+arma::mat ParGramCpp(const arma::fmat* X);
+
+arma::vec ParCrossProdCpp(const arma::mat* X, const arma::vec* v);
+
+arma::vec ParCrossProdCpp(const arma::sp_mat* X, const arma::vec* v);
+
+arma::vec ParCrossProdCpp(const arma::fmat* X, const arma::vec* v);
+
+arma::vec ParScoreCpp(const arma::mat* X, const arma::vec* Y, arma::vec* Deriv,
+                   arma::vec* Var, arma::vec* mu);
+
+arma::mat ParFisherInfoCpp(const arma::mat* X, arma::vec* Deriv, 
+                        arma::vec* Var);
 
-int ParLinRegCppShort(arma::vec* beta, const arma::mat* x, const arma::mat* XTWX,
-const arma::mat* y,
+template<typename T>
+int ParLBFGSGLMCpp(arma::vec* beta, const T* X, const arma::uvec* Cols, 
+                   const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+                   GLMFamily Family, 
+                   double tol, int maxit, unsigned int m, bool UseXTWX, 
+                   GLMWorkspace* Workspace);
+
+template<typename T>
+int ParBFGSGLMCpp(arma::vec* beta, const T* X, const arma::uvec* Cols, 
+                  const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+                  GLMFamily Family,
+			double tol, int maxit, bool UseXTWX, GLMWorkspace* Workspace);
+
+template<typename T>
+int ParFisherScoringGLMCpp(arma::vec* beta, const T* X, const arma::uvec* Cols, 
+                               const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+                               GLMFamily Family,
+                               double tol, int maxit, bool UseXTWX, 
+                               GLMWorkspace* Workspace);
+
+template<typename eT>
+arma::ivec ParBatchFisherScoringGLMCpp(const arma::Mat<eT>* X, 
+                                       const std::vector<arma::uvec>* Cols, 
+                                       const arma::vec* Y, const arma::vec* Offset,
+                                       std::vector<arma::vec>* betas, 
+                                       GLMFamily Family, double tol, int maxit);
+
+arma::ivec ParBatchFisherScoringGLMCpp(const arma::sp_mat* X, 
+                                       const std::vector<arma::uvec>* Cols, 
+                                       const arma::vec* Y, const arma::vec* Offset,
+                                       std::vector<arma::vec>* betas, 
+                                       GLMFamily Family, double tol, int maxit);
+
+template<typename T>
+int ParLinRegCppShort(arma::vec* beta, const T* x, const arma::uvec* Cols, 
+                      const arma::mat* XTWX,
+const arma::vec* y,
               const arma::vec* offset);
 
-void PargetInit(arma::vec* beta, const arma::mat* X, const arma::mat* XTWX,
+template<typename T>
+void PargetInit(arma::vec* beta, const T* X, const arma::uvec* Cols, 
+                const arma::mat* XTWX,
 		    const arma::vec* Y, 
-                const arma::vec* Offset, std::string Dist, std::string Link, 
-		    bool* UseXTWX);
+                const arma::vec* Offset, GLMFamily Family, 
+		    bool* UseXTWX, GLMWorkspace* Workspace);
 
 arma::vec ParLinkCpp(const arma::mat* X, arma::vec* beta, const arma::vec* Offset, 
-                     std::string Link, std::string Dist);
+                     GLMFamily Family);
 
-double ParLogLikelihoodCpp(const arma::mat* X, const arma::vec* Y, 
-                           arma::vec* mu, std::string Dist);
+double ParLogLikelihoodCpp(const arma::vec* Y, arma::vec* mu, GLMFamily Family);
 
 #endif
@@ -12,12 +12,12 @@ Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
 // BranchAndBoundCpp
-List BranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector offset, IntegerVector indices, IntegerVector num, IntegerMatrix interactions, std::string method, int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, IntegerVector keep, int maxsize, NumericVector pen, bool display_progress, unsigned int NumBest, double cutoff);
-RcppExport SEXP _BranchGLM_BranchAndBoundCpp(SEXP xSEXP, SEXP ySEXP, SEXP offsetSEXP, SEXP indicesSEXP, SEXP numSEXP, SEXP interactionsSEXP, SEXP methodSEXP, SEXP mSEXP, SEXP LinkSEXP, SEXP DistSEXP, SEXP nthreadsSEXP, SEXP tolSEXP, SEXP maxitSEXP, SEXP keepSEXP, SEXP maxsizeSEXP, SEXP penSEXP, SEXP display_progressSEXP, SEXP NumBestSEXP, SEXP cutoffSEXP) {
+List BranchAndBoundCpp(SEXP x, NumericVector y, NumericVector offset, IntegerVector indices, IntegerVector num, IntegerMatrix interactions, std::string method, int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, IntegerVector keep, int maxsize, NumericVector pen, bool display_progress, unsigned int NumBest, double cutoff, bool bestfirst, std::string checkpoint, double interval, bool resume, unsigned int nsplit, std::string shared, bool float32);
+RcppExport SEXP _BranchGLM_BranchAndBoundCpp(SEXP xSEXP, SEXP ySEXP, SEXP offsetSEXP, SEXP indicesSEXP, SEXP numSEXP, SEXP interactionsSEXP, SEXP methodSEXP, SEXP mSEXP, SEXP LinkSEXP, SEXP DistSEXP, SEXP nthreadsSEXP, SEXP tolSEXP, SEXP maxitSEXP, SEXP keepSEXP, SEXP maxsizeSEXP, SEXP penSEXP, SEXP display_progressSEXP, SEXP NumBestSEXP, SEXP cutoffSEXP, SEXP bestfirstSEXP, SEXP checkpointSEXP, SEXP intervalSEXP, SEXP resumeSEXP, SEXP nsplitSEXP, SEXP sharedSEXP, SEXP float32SEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericMatrix >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
     Rcpp::traits::input_parameter< NumericVector >::type offset(offsetSEXP);
     Rcpp::traits::input_parameter< IntegerVector >::type indices(indicesSEXP);
@@ -36,17 +36,24 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
     Rcpp::traits::input_parameter< unsigned int >::type NumBest(NumBestSEXP);
     Rcpp::traits::input_parameter< double >::type cutoff(cutoffSEXP);
-    rcpp_result_gen = Rcpp::wrap(BranchAndBoundCpp(x, y, offset, indices, num, interactions, method, m, Link, Dist, nthreads, tol, maxit, keep, maxsize, pen, display_progress, NumBest, cutoff));
+    Rcpp::traits::input_parameter< bool >::type bestfirst(bestfirstSEXP);
+    Rcpp::traits::input_parameter< std::string >::type checkpoint(checkpointSEXP);
+    Rcpp::traits::input_parameter< double >::type interval(intervalSEXP);
+    Rcpp::traits::input_parameter< bool >::type resume(resumeSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type nsplit(nsplitSEXP);
+    Rcpp::traits::input_parameter< std::string >::type shared(sharedSEXP);
+    Rcpp::traits::input_parameter< bool >::type float32(float32SEXP);
+    rcpp_result_gen = Rcpp::wrap(BranchAndBoundCpp(x, y, offset, indices, num, interactions, method, m, Link, Dist, nthreads, tol, maxit, keep, maxsize, pen, display_progress, NumBest, cutoff, bestfirst, checkpoint, interval, resume, nsplit, shared, float32));
     return rcpp_result_gen;
 END_RCPP
 }
 // BackwardBranchAndBoundCpp
-List BackwardBranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector offset, IntegerVector indices, IntegerVector num, IntegerMatrix interactions, std::string method, int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, IntegerVector keep, NumericVector pen, bool display_progress, unsigned int NumBest, double cutoff);
-RcppExport SEXP _BranchGLM_BackwardBranchAndBoundCpp(SEXP xSEXP, SEXP ySEXP, SEXP offsetSEXP, SEXP indicesSEXP, SEXP numSEXP, SEXP interactionsSEXP, SEXP methodSEXP, SEXP mSEXP, SEXP LinkSEXP, SEXP DistSEXP, SEXP nthreadsSEXP, SEXP tolSEXP, SEXP maxitSEXP, SEXP keepSEXP, SEXP penSEXP, SEXP display_progressSEXP, SEXP NumBestSEXP, SEXP cutoffSEXP) {
+List BackwardBranchAndBoundCpp(SEXP x, NumericVector y, NumericVector offset, IntegerVector indices, IntegerVector num, IntegerMatrix interactions, std::string method, int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, IntegerVector keep, NumericVector pen, bool display_progress, unsigned int NumBest, double cutoff, std::string checkpoint, double interval, bool resume, bool float32);
+RcppExport SEXP _BranchGLM_BackwardBranchAndBoundCpp(SEXP xSEXP, SEXP ySEXP, SEXP offsetSEXP, SEXP indicesSEXP, SEXP numSEXP, SEXP interactionsSEXP, SEXP methodSEXP, SEXP mSEXP, SEXP LinkSEXP, SEXP DistSEXP, SEXP nthreadsSEXP, SEXP tolSEXP, SEXP maxitSEXP, SEXP keepSEXP, SEXP penSEXP, SEXP display_progressSEXP, SEXP NumBestSEXP, SEXP cutoffSEXP, SEXP checkpointSEXP, SEXP intervalSEXP, SEXP resumeSEXP, SEXP float32SEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericMatrix >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
     Rcpp::traits::input_parameter< NumericVector >::type offset(offsetSEXP);
     Rcpp::traits::input_parameter< IntegerVector >::type indices(indicesSEXP);
@@ -64,17 +71,21 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
     Rcpp::traits::input_parameter< unsigned int >::type NumBest(NumBestSEXP);
     Rcpp::traits::input_parameter< double >::type cutoff(cutoffSEXP);
-    rcpp_result_gen = Rcpp::wrap(BackwardBranchAndBoundCpp(x, y, offset, indices, num, interactions, method, m, Link, Dist, nthreads, tol, maxit, keep, pen, display_progress, NumBest, cutoff));
+    Rcpp::traits::input_parameter< std::string >::type checkpoint(checkpointSEXP);
+    Rcpp::traits::input_parameter< double >::type interval(intervalSEXP);
+    Rcpp::traits::input_parameter< bool >::type resume(resumeSEXP);
+    Rcpp::traits::input_parameter< bool >::type float32(float32SEXP);
+    rcpp_result_gen = Rcpp::wrap(BackwardBranchAndBoundCpp(x, y, offset, indices, num, interactions, method, m, Link, Dist, nthreads, tol, maxit, keep, pen, display_progress, NumBest, cutoff, checkpoint, interval, resume, float32));
     return rcpp_result_gen;
 END_RCPP
 }
 // SwitchBranchAndBoundCpp
-List SwitchBranchAndBoundCpp(NumericMatrix x, NumericVector y, NumericVector offset, IntegerVector indices, IntegerVector num, IntegerMatrix interactions, std::string method, int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, IntegerVector keep, NumericVector pen, bool display_progress, unsigned int NumBest, double cutoff);
-RcppExport SEXP _BranchGLM_SwitchBranchAndBoundCpp(SEXP xSEXP, SEXP ySEXP, SEXP offsetSEXP, SEXP indicesSEXP, SEXP numSEXP, SEXP interactionsSEXP, SEXP methodSEXP, SEXP mSEXP, SEXP LinkSEXP, SEXP DistSEXP, SEXP nthreadsSEXP, SEXP tolSEXP, SEXP maxitSEXP, SEXP keepSEXP, SEXP penSEXP, SEXP display_progressSEXP, SEXP NumBestSEXP, SEXP cutoffSEXP) {
+List SwitchBranchAndBoundCpp(SEXP x, NumericVector y, NumericVector offset, IntegerVector indices, IntegerVector num, IntegerMatrix interactions, std::string method, int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, IntegerVector keep, NumericVector pen, bool display_progress, unsigned int NumBest, double cutoff, std::string checkpoint, double interval, bool resume, bool float32);
+RcppExport SEXP _BranchGLM_SwitchBranchAndBoundCpp(SEXP xSEXP, SEXP ySEXP, SEXP offsetSEXP, SEXP indicesSEXP, SEXP numSEXP, SEXP interactionsSEXP, SEXP methodSEXP, SEXP mSEXP, SEXP LinkSEXP, SEXP DistSEXP, SEXP nthreadsSEXP, SEXP tolSEXP, SEXP maxitSEXP, SEXP keepSEXP, SEXP penSEXP, SEXP display_progressSEXP, SEXP NumBestSEXP, SEXP cutoffSEXP, SEXP checkpointSEXP, SEXP intervalSEXP, SEXP resumeSEXP, SEXP float32SEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericMatrix >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
     Rcpp::traits::input_parameter< NumericVector >::type offset(offsetSEXP);
     Rcpp::traits::input_parameter< IntegerVector >::type indices(indicesSEXP);
@@ -92,17 +103,21 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
     Rcpp::traits::input_parameter< unsigned int >::type NumBest(NumBestSEXP);
     Rcpp::traits::input_parameter< double >::type cutoff(cutoffSEXP);
-    rcpp_result_gen = Rcpp::wrap(SwitchBranchAndBoundCpp(x, y, offset, indices, num, interactions, method, m, Link, Dist, nthreads, tol, maxit, keep, pen, display_progress, NumBest, cutoff));
+    Rcpp::traits::input_parameter< std::string >::type checkpoint(checkpointSEXP);
+    Rcpp::traits::input_parameter< double >::type interval(intervalSEXP);
+    Rcpp::traits::input_parameter< bool >::type resume(resumeSEXP);
+    Rcpp::traits::input_parameter< bool >::type float32(float32SEXP);
+    rcpp_result_gen = Rcpp::wrap(SwitchBranchAndBoundCpp(x, y, offset, indices, num, interactions, method, m, Link, Dist, nthreads, tol, maxit, keep, pen, display_progress, NumBest, cutoff, checkpoint, interval, resume, float32));
     return rcpp_result_gen;
 END_RCPP
 }
 // BranchGLMfit
-List BranchGLMfit(NumericMatrix x, NumericVector y, NumericVector offset, NumericVector init, std::string method, unsigned int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, bool GetInit);
+List BranchGLMfit(SEXP x, NumericVector y, NumericVector offset, NumericVector init, std::string method, unsigned int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, bool GetInit);
 RcppExport SEXP _BranchGLM_BranchGLMfit(SEXP xSEXP, SEXP ySEXP, SEXP offsetSEXP, SEXP initSEXP, SEXP methodSEXP, SEXP mSEXP, SEXP LinkSEXP, SEXP DistSEXP, SEXP nthreadsSEXP, SEXP tolSEXP, SEXP maxitSEXP, SEXP GetInitSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericMatrix >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
     Rcpp::traits::input_parameter< NumericVector >::type offset(offsetSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type init(initSEXP);
@@ -118,13 +133,95 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// BranchGLMfitChunked
+List BranchGLMfitChunked(SEXP x, NumericVector y, NumericVector offset, NumericVector init, std::string method, unsigned int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, bool GetInit);
+RcppExport SEXP _BranchGLM_BranchGLMfitChunked(SEXP xSEXP, SEXP ySEXP, SEXP offsetSEXP, SEXP initSEXP, SEXP methodSEXP, SEXP mSEXP, SEXP LinkSEXP, SEXP DistSEXP, SEXP nthreadsSEXP, SEXP tolSEXP, SEXP maxitSEXP, SEXP GetInitSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type offset(offsetSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type init(initSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type m(mSEXP);
+    Rcpp::traits::input_parameter< std::string >::type Link(LinkSEXP);
+    Rcpp::traits::input_parameter< std::string >::type Dist(DistSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< int >::type maxit(maxitSEXP);
+    Rcpp::traits::input_parameter< bool >::type GetInit(GetInitSEXP);
+    rcpp_result_gen = Rcpp::wrap(BranchGLMfitChunked(x, y, offset, init, method, m, Link, Dist, nthreads, tol, maxit, GetInit));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ChunkedMatrixCpp
+SEXP ChunkedMatrixCpp(unsigned int ncols, unsigned int chunksize, bool usefloat);
+RcppExport SEXP _BranchGLM_ChunkedMatrixCpp(SEXP ncolsSEXP, SEXP chunksizeSEXP, SEXP usefloatSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< unsigned int >::type ncols(ncolsSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type chunksize(chunksizeSEXP);
+    Rcpp::traits::input_parameter< bool >::type usefloat(usefloatSEXP);
+    rcpp_result_gen = Rcpp::wrap(ChunkedMatrixCpp(ncols, chunksize, usefloat));
+    return rcpp_result_gen;
+END_RCPP
+}
+// AppendChunkCpp
+double AppendChunkCpp(SEXP ptr, NumericMatrix x);
+RcppExport SEXP _BranchGLM_AppendChunkCpp(SEXP ptrSEXP, SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type ptr(ptrSEXP);
+    Rcpp::traits::input_parameter< NumericMatrix >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(AppendChunkCpp(ptr, x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// MappedMatrixCpp
+List MappedMatrixCpp(std::string file);
+RcppExport SEXP _BranchGLM_MappedMatrixCpp(SEXP fileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
+    rcpp_result_gen = Rcpp::wrap(MappedMatrixCpp(file));
+    return rcpp_result_gen;
+END_RCPP
+}
+// CreateDesignFileCpp
+void CreateDesignFileCpp(std::string file, double n, double p);
+RcppExport SEXP _BranchGLM_CreateDesignFileCpp(SEXP fileSEXP, SEXP nSEXP, SEXP pSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
+    Rcpp::traits::input_parameter< double >::type n(nSEXP);
+    Rcpp::traits::input_parameter< double >::type p(pSEXP);
+    CreateDesignFileCpp(file, n, p);
+    return R_NilValue;
+END_RCPP
+}
+// WriteDesignRowsCpp
+void WriteDesignRowsCpp(std::string file, NumericMatrix x, double start);
+RcppExport SEXP _BranchGLM_WriteDesignRowsCpp(SEXP fileSEXP, SEXP xSEXP, SEXP startSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
+    Rcpp::traits::input_parameter< NumericMatrix >::type x(xSEXP);
+    Rcpp::traits::input_parameter< double >::type start(startSEXP);
+    WriteDesignRowsCpp(file, x, start);
+    return R_NilValue;
+END_RCPP
+}
 // MetricIntervalCpp
-List MetricIntervalCpp(NumericMatrix x, NumericVector y, NumericVector offset, IntegerVector indices, IntegerVector num, IntegerVector model, std::string method, int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, NumericVector pen, NumericVector mle, NumericVector se, NumericVector best, double cutoff, double Metric, std::string rootMethod);
+List MetricIntervalCpp(SEXP x, NumericVector y, NumericVector offset, IntegerVector indices, IntegerVector num, IntegerVector model, std::string method, int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, NumericVector pen, NumericVector mle, NumericVector se, NumericVector best, double cutoff, double Metric, std::string rootMethod);
 RcppExport SEXP _BranchGLM_MetricIntervalCpp(SEXP xSEXP, SEXP ySEXP, SEXP offsetSEXP, SEXP indicesSEXP, SEXP numSEXP, SEXP modelSEXP, SEXP methodSEXP, SEXP mSEXP, SEXP LinkSEXP, SEXP DistSEXP, SEXP nthreadsSEXP, SEXP tolSEXP, SEXP maxitSEXP, SEXP penSEXP, SEXP mleSEXP, SEXP seSEXP, SEXP bestSEXP, SEXP cutoffSEXP, SEXP MetricSEXP, SEXP rootMethodSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericMatrix >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
     Rcpp::traits::input_parameter< NumericVector >::type offset(offsetSEXP);
     Rcpp::traits::input_parameter< IntegerVector >::type indices(indicesSEXP);
@@ -149,12 +246,12 @@ BEGIN_RCPP
 END_RCPP
 }
 // ForwardCpp
-List ForwardCpp(NumericMatrix x, NumericVector y, NumericVector offset, IntegerVector indices, IntegerVector num, IntegerMatrix interactions, std::string method, int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, IntegerVector keep, unsigned int steps, NumericVector pen);
+List ForwardCpp(SEXP x, NumericVector y, NumericVector offset, IntegerVector indices, IntegerVector num, IntegerMatrix interactions, std::string method, int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, IntegerVector keep, unsigned int steps, NumericVector pen);
 RcppExport SEXP _BranchGLM_ForwardCpp(SEXP xSEXP, SEXP ySEXP, SEXP offsetSEXP, SEXP indicesSEXP, SEXP numSEXP, SEXP interactionsSEXP, SEXP methodSEXP, SEXP mSEXP, SEXP LinkSEXP, SEXP DistSEXP, SEXP nthreadsSEXP, SEXP tolSEXP, SEXP maxitSEXP, SEXP keepSEXP, SEXP stepsSEXP, SEXP penSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericMatrix >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
     Rcpp::traits::input_parameter< NumericVector >::type offset(offsetSEXP);
     Rcpp::traits::input_parameter< IntegerVector >::type indices(indicesSEXP);
@@ -175,12 +272,12 @@ BEGIN_RCPP
 END_RCPP
 }
 // BackwardCpp
-List BackwardCpp(NumericMatrix x, NumericVector y, NumericVector offset, IntegerVector indices, IntegerVector num, IntegerMatrix interactions, std::string method, int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, IntegerVector keep, unsigned int steps, NumericVector pen);
+List BackwardCpp(SEXP x, NumericVector y, NumericVector offset, IntegerVector indices, IntegerVector num, IntegerMatrix interactions, std::string method, int m, std::string Link, std::string Dist, unsigned int nthreads, double tol, int maxit, IntegerVector keep, unsigned int steps, NumericVector pen);
 RcppExport SEXP _BranchGLM_BackwardCpp(SEXP xSEXP, SEXP ySEXP, SEXP offsetSEXP, SEXP indicesSEXP, SEXP numSEXP, SEXP interactionsSEXP, SEXP methodSEXP, SEXP mSEXP, SEXP LinkSEXP, SEXP DistSEXP, SEXP nthreadsSEXP, SEXP tolSEXP, SEXP maxitSEXP, SEXP keepSEXP, SEXP stepsSEXP, SEXP penSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericMatrix >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
     Rcpp::traits::input_parameter< NumericVector >::type offset(offsetSEXP);
     Rcpp::traits::input_parameter< IntegerVector >::type indices(indicesSEXP);
@@ -266,10 +363,16 @@ END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_BranchGLM_BranchAndBoundCpp", (DL_FUNC) &_BranchGLM_BranchAndBoundCpp, 19},
-    {"_BranchGLM_BackwardBranchAndBoundCpp", (DL_FUNC) &_BranchGLM_BackwardBranchAndBoundCpp, 18},
-    {"_BranchGLM_SwitchBranchAndBoundCpp", (DL_FUNC) &_BranchGLM_SwitchBranchAndBoundCpp, 18},
+    {"_BranchGLM_BranchAndBoundCpp", (DL_FUNC) &_BranchGLM_BranchAndBoundCpp, 26},
+    {"_BranchGLM_BackwardBranchAndBoundCpp", (DL_FUNC) &_BranchGLM_BackwardBranchAndBoundCpp, 22},
+    {"_BranchGLM_SwitchBranchAndBoundCpp", (DL_FUNC) &_BranchGLM_SwitchBranchAndBoundCpp, 22},
     {"_BranchGLM_BranchGLMfit", (DL_FUNC) &_BranchGLM_BranchGLMfit, 12},
+    {"_BranchGLM_BranchGLMfitChunked", (DL_FUNC) &_BranchGLM_BranchGLMfitChunked, 12},
+    {"_BranchGLM_ChunkedMatrixCpp", (DL_FUNC) &_BranchGLM_ChunkedMatrixCpp, 3},
+    {"_BranchGLM_AppendChunkCpp", (DL_FUNC) &_BranchGLM_AppendChunkCpp, 2},
+    {"_BranchGLM_MappedMatrixCpp", (DL_FUNC) &_BranchGLM_MappedMatrixCpp, 1},
+    {"_BranchGLM_CreateDesignFileCpp", (DL_FUNC) &_BranchGLM_CreateDesignFileCpp, 3},
+    {"_BranchGLM_WriteDesignRowsCpp", (DL_FUNC) &_BranchGLM_WriteDesignRowsCpp, 3},
     {"_BranchGLM_MetricIntervalCpp", (DL_FUNC) &_BranchGLM_MetricIntervalCpp, 20},
     {"_BranchGLM_ForwardCpp", (DL_FUNC) &_BranchGLM_ForwardCpp, 16},
     {"_BranchGLM_BackwardCpp", (DL_FUNC) &_BranchGLM_BackwardCpp, 16},
@@ -0,0 +1,76 @@
+#include <RcppArmadillo.h>
+#include <cstdio>
+#include <fstream>
+#include "SharedBound.h"
+using namespace Rcpp;
+
+// Reads the cutoff from the file, infinity is used if the file doesn't exist
+double SharedBound::read() const{
+  double val = arma::datum::inf;
+  std::ifstream in(file.c_str(), std::ios::binary);
+  if(in){
+    double temp;
+    in.read(reinterpret_cast<char*>(&temp), sizeof(double));
+    if(in){
+      val = temp;
+    }
+  }
+  return(val);
+}
+
+// Writes the cutoff to a temporary file which then replaces the shared file, 
+// so other processes never read a partially written file
+void SharedBound::write(double val) const{
+  std::ofstream out(tempfile.c_str(), std::ios::binary | std::ios::trunc);
+  if(!out){
+    return;
+  }
+  out.write(reinterpret_cast<const char*>(&val), sizeof(double));
+  out.close();
+  if(!out){
+    // The shared file is kept when the temporary file couldn't be written
+    std::remove(tempfile.c_str());
+    return;
+  }
+  if(std::rename(tempfile.c_str(), file.c_str()) != 0){
+    // Rename doesn't replace existing files on windows
+    std::remove(file.c_str());
+    std::rename(tempfile.c_str(), file.c_str());
+  }
+}
+
+// Gets the smallest cutoff found by any of the processes
+// If two processes write at the same time the larger cutoff may be kept, so the 
+// cutoff is written again when the file has a larger one than this process
+double SharedBound::get(){
+  double temp;
+#pragma omp critical(SharedBound)
+  {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(std::chrono::duration<double>(now - last).count() >= interval){
+      double shared = read();
+      if(value < shared){
+        write(value);
+      }
+      value = std::min(value, shared);
+      last = now;
+    }
+    temp = value;
+  }
+  return(temp);
+}
+
+// Updates the shared cutoff if val is smaller than it
+// The file is read again before writing, so a smaller cutoff written by another 
+// process is not replaced
+void SharedBound::put(double val){
+#pragma omp critical(SharedBound)
+  {
+    if(val < value){
+      value = std::min(val, read());
+      if(val <= value){
+        write(val);
+      }
+    }
+  }
+}
@@ -0,0 +1,30 @@
+#ifndef SharedBound_H
+#define SharedBound_H
+
+#include <RcppArmadillo.h>
+#include <chrono>
+using namespace Rcpp;
+
+// Metric cutoff shared by processes that search different parts of the same 
+// branch and bound tree
+// The cutoff is kept in a small file, each process reads it every interval 
+// seconds and writes to it when it finds a smaller cutoff, so every process 
+// can cut off branches with the best models found by the others
+class SharedBound{
+private:
+  std::string file;
+  std::string tempfile;
+  double value = arma::datum::inf;
+  double interval;
+  std::chrono::steady_clock::time_point last;
+  double read() const;
+  void write(double val) const;
+public:
+  SharedBound(std::string file, std::string tempfile, double interval = 1):
+  file(file), tempfile(tempfile), interval(interval), 
+  last(std::chrono::steady_clock::now() - std::chrono::hours(1)){}
+  double get();
+  void put(double val);
+};
+
+#endif
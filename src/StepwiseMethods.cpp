@@ -3,17 +3,21 @@
 #include "BranchGLMHelpers.h"
 #include "ParBranchGLMHelpers.h"
 #include "VariableSelection.h"
+#include "MappedMatrix.h"
+#include "ThreadPolicy.h"
 #ifdef _OPENMP
 # include <omp.h>
 #endif
 using namespace Rcpp;
 
 // Given a current model, this finds the best variable to add to the model
-void add1(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
-          const arma::imat* Interactions, std::string method, int m, std::string Link, std::string Dist,
+template<typename T>
+void add1(const T* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+          const arma::imat* Interactions, std::string method, int m, GLMFamily Family,
           arma::ivec* CurModel, arma::vec* BestModel, double* BestMetric, 
-          unsigned int* numchecked, bool* flag, arma::ivec* order, unsigned int i,
-          arma::ivec* indices, double tol, int maxit, const arma::vec* pen){
+          unsigned long long* numchecked, bool* flag, arma::ivec* order, unsigned int i,
+          arma::ivec* indices, double tol, int maxit, const arma::vec* pen, 
+          LinRegChol* Chol, std::vector<GLMWorkspace>* Workspaces){
   
   arma::vec Metrics(CurModel->n_elem, arma::fill::zeros);
   Metrics.fill(arma::datum::inf);
@@ -21,20 +25,50 @@ void add1(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const a
   checkUserInterrupt();
   arma::mat NewModels(X->n_cols, CurModel->n_elem, arma::fill::zeros);
   
+  // Coefficients of the current model are used as initial values
+  const arma::vec* Init = std::isinf(*BestMetric) ? nullptr : BestModel;
+  
   // Adding each variable one at a time and calculating metric for each model
+  if(Chol != nullptr){
 #pragma omp parallel for schedule(dynamic, 1)
-  for(unsigned int j = 0; j < CurModel->n_elem; j++){
-    if(CurModel->at(j) == 0){
-      arma::ivec CurModel2 = *CurModel;
-      CurModel2.at(j) = 1;
-      if(CheckModel(&CurModel2, Interactions)){
-        // This model is valid, so we fit it
-        Counts.at(j) = 1;
-        Metrics.at(j) = MetricHelper(X, XTWX, Y, Offset, indices, &CurModel2, method, m, Link, Dist, 
-                   tol, maxit, pen, j, &NewModels);
+    for(unsigned int j = 0; j < CurModel->n_elem; j++){
+      if(CurModel->at(j) == 0){
+        arma::ivec CurModel2 = *CurModel;
+        CurModel2.at(j) = 1;
+        if(CheckModel(&CurModel2, Interactions)){
+          // Adding the variable to the cholesky factor for linear regression
+          Counts.at(j) = 1;
+          LinRegChol Chol2 = *Chol;
+          if(Chol2.AddVar(indices, j)){
+            Metrics.at(j) = LinRegMetricHelper(&Chol2, &CurModel2, pen, j, &NewModels);
+          }
+        }
       }
     }
   }
+  else{
+    // Only fitting valid models, these are fit in batches that share passes over X
+    std::vector<arma::ivec> Models;
+    arma::uvec Cur(CurModel->n_elem);
+    for(unsigned int j = 0; j < CurModel->n_elem; j++){
+      if(CurModel->at(j) == 0){
+        arma::ivec CurModel2 = *CurModel;
+        CurModel2.at(j) = 1;
+        if(CheckModel(&CurModel2, Interactions)){
+          Counts.at(j) = 1;
+          Cur.at(Models.size()) = j;
+          Models.push_back(CurModel2);
+        }
+      }
+    }
+    unsigned int nbatches = NumBatches(Models.size());
+#pragma omp parallel for schedule(dynamic, 1)
+    for(unsigned int b = 0; b < nbatches; b++){
+      BatchMetricHelper(X, XTWX, Y, Offset, indices, &Models, &Cur, b, nbatches, 
+                        method, m, Family, tol, maxit, pen, &NewModels, &Metrics, 
+                        Init, GetWorkspace(Workspaces));
+    }
+  }
   
   // Updating numchecked
   (*numchecked) += arma::accu(Counts);
@@ -45,6 +79,9 @@ void add1(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const a
   checkUserInterrupt();
   if(NewMetric < *BestMetric){
     CurModel->at(BestVar) = 1;
+    if(Chol != nullptr){
+      Chol->AddVar(indices, BestVar);
+    }
     *BestModel = NewModels.col(BestVar);
     *BestMetric = NewMetric;
     *flag = false;
@@ -53,22 +90,23 @@ void add1(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const a
 }
 
 // Performs forward selection
-// [[Rcpp::export]]
-List ForwardCpp(NumericMatrix x, NumericVector y, NumericVector offset, 
-                IntegerVector indices, IntegerVector num, 
-                IntegerMatrix interactions,
-                std::string method, int m,
-                std::string Link, std::string Dist,
-                unsigned int nthreads, double tol, int maxit,
-                IntegerVector keep, 
-                unsigned int steps, NumericVector pen){
+template<typename T>
+List ForwardHelper(const T* X, NumericVector y, NumericVector offset, 
+                   IntegerVector indices, IntegerVector num, 
+                   IntegerMatrix interactions,
+                   std::string method, int m,
+                   std::string Link, std::string Dist,
+                   unsigned int nthreads, double tol, int maxit,
+                   IntegerVector keep, 
+                   unsigned int steps, NumericVector pen){
   
-#ifdef _OPENMP
-  omp_set_num_threads(nthreads);
-#endif
+  // Getting family and link used by the fitting functions
+  const GLMFamily Family = GetFamily(Dist, Link);
+  
+  // Setting number of threads used to fit the candidate models for each step
+  ThreadScope Threads(ChooseThreads(X->n_rows, X->n_cols, num.size(), nthreads));
   
   // Creating necessary vectors/matrices
-  const arma::mat X(x.begin(), x.rows(), x.cols(), false, true);
   const arma::vec Y(y.begin(), y.size(), false, true);
   const arma::vec Offset(offset.begin(), offset.size(), false, true);
   const arma::vec Pen(pen.begin(), pen.size(), false, true);
@@ -79,33 +117,47 @@ List ForwardCpp(NumericMatrix x, NumericVector y, NumericVector offset,
   arma::imat BestModels(CurModel.n_elem, CurModel.n_elem + 1, arma::fill::zeros);
   arma::vec BestMetrics(CurModel.n_elem + 1, 1);
   BestMetrics.fill(arma::datum::inf);
-  arma::vec BestModel(X.n_cols, 1, arma::fill::zeros);
-  arma::mat BestBetas(X.n_cols, CurModel.n_elem + 1, arma::fill::zeros);
+  arma::vec BestModel(X->n_cols, 1, arma::fill::zeros);
+  arma::mat BestBetas(X->n_cols, CurModel.n_elem + 1, arma::fill::zeros);
   CurModel.replace(1, 0);
   IntegerVector order(CurModel.n_elem, - 1);
   arma::ivec Order(order.begin(), order.size(), false, true);
   
   
   // Getting X'WX
-  arma::mat XTWX = X.t() * X;
+  arma::mat XTWX(X->t() * *X);
+  
+  // Getting X'y, y'y, and the cholesky factor of X'X for the initial model, 
+  // these are used to get linear regression models without refitting them
+  const LinRegCross Cross = GetLinRegCross(X, &XTWX, &Y, &Offset, Family);
+  LinRegChol Chol(&XTWX, &Cross, X->n_rows);
+  bool UseChol = IsLinReg(Family) && Chol.AddModel(&Indices, &CurModel);
+  
+  // Creating workspaces used to fit models for each thread
+  std::vector<GLMWorkspace> Workspaces = MakeWorkspaces(X->n_rows, X->n_cols);
   
   // Creating necessary scalars
   double BestMetric = arma::datum::inf;
-  arma::mat betaMat(X.n_cols, 1, arma::fill::zeros);
-  BestMetric = MetricHelper(&X, &XTWX, &Y, &Offset, &Indices, &CurModel, method, m, Link, Dist, 
-                               tol, maxit, &Pen, 0, &betaMat);
+  arma::mat betaMat(X->n_cols, 1, arma::fill::zeros);
+  if(UseChol){
+    BestMetric = LinRegMetricHelper(&Chol, &CurModel, &Pen, 0, &betaMat);
+  }else{
+    BestMetric = MetricHelper(X, &XTWX, &Y, &Offset, &Indices, &CurModel, method, m, Family, 
+                              tol, maxit, &Pen, 0, &betaMat, nullptr, GetWorkspace(&Workspaces));
+  }
   BestModel = betaMat.col(0);
   BestMetrics.at(0) = BestMetric;
   BestModels.col(0) = CurModel;
   BestBetas.col(0) = BestModel;
-  unsigned int numchecked = 1;
+  unsigned long long numchecked = 1;
   
   // Performing forward selection
   for(unsigned int i = 0; i < steps; i++){
     checkUserInterrupt();
     bool flag = true;
-    add1(&X, &XTWX, &Y, &Offset, &Interactions, method, m, Link, Dist, &CurModel, &BestModel, 
-         &BestMetric, &numchecked, &flag, &Order, i, &Indices, tol, maxit, &Pen);
+    add1(X, &XTWX, &Y, &Offset, &Interactions, method, m, Family, &CurModel, &BestModel, 
+         &BestMetric, &numchecked, &flag, &Order, i, &Indices, tol, maxit, &Pen, 
+         UseChol ? &Chol : nullptr, &Workspaces);
     
     // Stopping process if no better model is found
     if(flag){
@@ -118,43 +170,94 @@ List ForwardCpp(NumericMatrix x, NumericVector y, NumericVector offset,
   }
   
   List FinalList = List::create(Named("order") = order,
-                                Named("numchecked") = numchecked,
+                                Named("numchecked") = (double)numchecked,
                                 Named("bestmetrics") = BestMetrics, 
                                 Named("bestmodels") = BestModels, 
                                 Named("betas") = BestBetas);
   
-#ifdef _OPENMP
-  omp_set_num_threads(1);
-#endif
-  
   return(FinalList);
 }
 
+// Performs forward selection, x is either a numeric matrix or a dgCMatrix
+// [[Rcpp::export]]
+List ForwardCpp(SEXP x, NumericVector y, NumericVector offset, 
+                IntegerVector indices, IntegerVector num, 
+                IntegerMatrix interactions,
+                std::string method, int m,
+                std::string Link, std::string Dist,
+                unsigned int nthreads, double tol, int maxit,
+                IntegerVector keep, 
+                unsigned int steps, NumericVector pen){
+  
+  // Sparse design matrices are dgCMatrix objects, these are kept in CSC form
+  if(Rf_isS4(x)){
+    const arma::sp_mat X = as<arma::sp_mat>(x);
+    return(ForwardHelper(&X, y, offset, indices, num, interactions, method, m, Link,
+                         Dist, nthreads, tol, maxit, keep, steps, pen));
+  }
+  // Dense design matrices are either numeric matrices or mapped design files
+  const DenseDesign X(x);
+  return(ForwardHelper(X.get(), y, offset, indices, num, interactions, method, m, Link, Dist,
+                       nthreads, tol, maxit, keep, steps, pen));
+}
+
 // Given a current model, this finds the best variable to remove
-void drop1(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
-           const arma::imat* Interactions, std::string method, int m, std::string Link, std::string Dist,
+template<typename T>
+void drop1(const T* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+           const arma::imat* Interactions, std::string method, int m, GLMFamily Family,
            arma::ivec* CurModel, arma::vec* BestModel, double* BestMetric, 
-           unsigned int* numchecked, bool* flag, arma::ivec* order, unsigned int i,
-           arma::ivec* indices, double tol, int maxit, const arma::vec* pen){
+           unsigned long long* numchecked, bool* flag, arma::ivec* order, unsigned int i,
+           arma::ivec* indices, double tol, int maxit, const arma::vec* pen, 
+           LinRegChol* Chol, std::vector<GLMWorkspace>* Workspaces){
   
   arma::vec Metrics(CurModel->n_elem);
   arma::ivec Counts(CurModel->n_elem, arma::fill::zeros);
   Metrics.fill(arma::datum::inf);
   arma::mat NewModels(X->n_cols, CurModel->n_elem, arma::fill::zeros);
   
+  // Coefficients of the current model are used as initial values
+  const arma::vec* Init = std::isinf(*BestMetric) ? nullptr : BestModel;
+  
   // Removing each variable one at a time and calculating metric for each model
+  if(Chol != nullptr){
 #pragma omp parallel for schedule(dynamic, 1)
-  for(unsigned int j = 0; j < CurModel->n_elem; j++){
-    if(CurModel->at(j) == 1){
-      arma::ivec CurModel2 = *CurModel;
-      CurModel2.at(j) = 0;
-      if(CheckModel(&CurModel2, Interactions)){
-        Counts.at(j) = 1;
-        Metrics.at(j) = MetricHelper(X, XTWX, Y, Offset, indices, &CurModel2, method, m, Link, Dist, 
-                   tol, maxit, pen, j, &NewModels);
+    for(unsigned int j = 0; j < CurModel->n_elem; j++){
+      if(CurModel->at(j) == 1){
+        arma::ivec CurModel2 = *CurModel;
+        CurModel2.at(j) = 0;
+        if(CheckModel(&CurModel2, Interactions)){
+          // Dropping the variable from the cholesky factor for linear regression
+          Counts.at(j) = 1;
+          LinRegChol Chol2 = *Chol;
+          Chol2.DropVar(indices, j);
+          Metrics.at(j) = LinRegMetricHelper(&Chol2, &CurModel2, pen, j, &NewModels);
+        }
       }
     }
   }
+  else{
+    // Only fitting valid models, these are fit in batches that share passes over X
+    std::vector<arma::ivec> Models;
+    arma::uvec Cur(CurModel->n_elem);
+    for(unsigned int j = 0; j < CurModel->n_elem; j++){
+      if(CurModel->at(j) == 1){
+        arma::ivec CurModel2 = *CurModel;
+        CurModel2.at(j) = 0;
+        if(CheckModel(&CurModel2, Interactions)){
+          Counts.at(j) = 1;
+          Cur.at(Models.size()) = j;
+          Models.push_back(CurModel2);
+        }
+      }
+    }
+    unsigned int nbatches = NumBatches(Models.size());
+#pragma omp parallel for schedule(dynamic, 1)
+    for(unsigned int b = 0; b < nbatches; b++){
+      BatchMetricHelper(X, XTWX, Y, Offset, indices, &Models, &Cur, b, nbatches, 
+                        method, m, Family, tol, maxit, pen, &NewModels, &Metrics, 
+                        Init, GetWorkspace(Workspaces));
+    }
+  }
   
   // Updating numchecked
   (*numchecked) += arma::accu(Counts);
@@ -164,6 +267,9 @@ void drop1(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const
   double NewMetric = Metrics.at(BestVar);
   if(NewMetric < *BestMetric){
     CurModel->at(BestVar) = 0;
+    if(Chol != nullptr){
+      Chol->DropVar(indices, BestVar);
+    }
     *BestModel = NewModels.col(BestVar);
     *BestMetric = NewMetric;
     *flag = false;
@@ -172,21 +278,22 @@ void drop1(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const
 }
 
 // Performs backward elimination
-// [[Rcpp::export]]
-List BackwardCpp(NumericMatrix x, NumericVector y, NumericVector offset, 
-                 IntegerVector indices, IntegerVector num,
-                 IntegerMatrix interactions, 
-                 std::string method, int m,
-                 std::string Link, std::string Dist,
-                 unsigned int nthreads, double tol, int maxit,
-                 IntegerVector keep, unsigned int steps, NumericVector pen){
+template<typename T>
+List BackwardHelper(const T* X, NumericVector y, NumericVector offset, 
+                    IntegerVector indices, IntegerVector num,
+                    IntegerMatrix interactions, 
+                    std::string method, int m,
+                    std::string Link, std::string Dist,
+                    unsigned int nthreads, double tol, int maxit,
+                    IntegerVector keep, unsigned int steps, NumericVector pen){
   
-#ifdef _OPENMP
-  omp_set_num_threads(nthreads);
-#endif
+  // Getting family and link used by the fitting functions
+  const GLMFamily Family = GetFamily(Dist, Link);
+  
+  // Setting number of threads used to fit the candidate models for each step
+  ThreadScope Threads(ChooseThreads(X->n_rows, X->n_cols, num.size(), nthreads));
   
   // Creating neccessary vectors/matrices
-  const arma::mat X(x.begin(), x.rows(), x.cols(), false, true);
   const arma::vec Y(y.begin(), y.size(), false, true);
   const arma::vec Offset(offset.begin(), offset.size(), false, true);
   const arma::vec Pen(pen.begin(), pen.size(), false, true);
@@ -197,33 +304,47 @@ List BackwardCpp(NumericMatrix x, NumericVector y, NumericVector offset,
   arma::imat BestModels(CurModel.n_elem, CurModel.n_elem + 1, arma::fill::zeros);
   arma::vec BestMetrics(CurModel.n_elem + 1, 1);
   BestMetrics.fill(arma::datum::inf);
-  arma::vec BestModel(X.n_cols, 1, arma::fill::zeros);
-  arma::mat BestBetas(X.n_cols, CurModel.n_elem + 1, arma::fill::zeros);
+  arma::vec BestModel(X->n_cols, 1, arma::fill::zeros);
+  arma::mat BestBetas(X->n_cols, CurModel.n_elem + 1, arma::fill::zeros);
   CurModel.replace(0, 1);
   IntegerVector order(CurModel.n_elem, - 1);
   arma::ivec Order(order.begin(), order.size(), false, true);
   
   // Getting X'WX
-  arma::mat XTWX = X.t() * X;
+  arma::mat XTWX(X->t() * *X);
+  
+  // Getting X'y, y'y, and the cholesky factor of X'X for the initial model, 
+  // these are used to get linear regression models without refitting them
+  const LinRegCross Cross = GetLinRegCross(X, &XTWX, &Y, &Offset, Family);
+  LinRegChol Chol(&XTWX, &Cross, X->n_rows);
+  bool UseChol = IsLinReg(Family) && Chol.AddModel(&Indices, &CurModel);
+  
+  // Creating workspaces used to fit models for each thread
+  std::vector<GLMWorkspace> Workspaces = MakeWorkspaces(X->n_rows, X->n_cols);
   
   // Creating necessary scalars
   double BestMetric = arma::datum::inf;
-  arma::mat betaMat(X.n_cols, 1, arma::fill::zeros);
-  BestMetric = MetricHelper(&X, &XTWX, &Y, &Offset, &Indices, &CurModel, method, m, Link, Dist, tol, maxit,
-                            &Pen, 0, &betaMat);
+  arma::mat betaMat(X->n_cols, 1, arma::fill::zeros);
+  if(UseChol){
+    BestMetric = LinRegMetricHelper(&Chol, &CurModel, &Pen, 0, &betaMat);
+  }else{
+    BestMetric = MetricHelper(X, &XTWX, &Y, &Offset, &Indices, &CurModel, method, m, Family, tol, maxit,
+                              &Pen, 0, &betaMat, nullptr, GetWorkspace(&Workspaces));
+  }
   BestModel = betaMat.col(0);
   BestMetrics.at(0) = BestMetric;
   BestModels.col(0) = CurModel;
   BestBetas.col(0) = BestModel;
   
-  unsigned int numchecked = 1;
+  unsigned long long numchecked = 1;
   
   // Performing Backward elimination
   for(unsigned int i = 0; i < steps; i++){
     checkUserInterrupt();
     bool flag = true;
-    drop1(&X, &XTWX, &Y, &Offset, &Interactions, method, m, Link, Dist, &CurModel, &BestModel, 
-          &BestMetric, &numchecked, &flag, &Order, i, &Indices, tol, maxit, &Pen);
+    drop1(X, &XTWX, &Y, &Offset, &Interactions, method, m, Family, &CurModel, &BestModel, 
+          &BestMetric, &numchecked, &flag, &Order, i, &Indices, tol, maxit, &Pen, 
+          UseChol ? &Chol : nullptr, &Workspaces);
     
     // Stopping the process if no better model is found
     if(flag){
@@ -236,14 +357,32 @@ List BackwardCpp(NumericMatrix x, NumericVector y, NumericVector offset,
   }
   
   List FinalList = List::create(Named("order") = order,
-                                Named("numchecked") = numchecked,
+                                Named("numchecked") = (double)numchecked,
                                 Named("bestmetrics") = BestMetrics,
                                 Named("bestmodels") = BestModels,
                                 Named("betas") = BestBetas);
   
-#ifdef _OPENMP
-  omp_set_num_threads(1);
-#endif
-  
   return(FinalList);
 }
+
+// Performs backward elimination, x is either a numeric matrix or a dgCMatrix
+// [[Rcpp::export]]
+List BackwardCpp(SEXP x, NumericVector y, NumericVector offset, 
+                 IntegerVector indices, IntegerVector num,
+                 IntegerMatrix interactions, 
+                 std::string method, int m,
+                 std::string Link, std::string Dist,
+                 unsigned int nthreads, double tol, int maxit,
+                 IntegerVector keep, unsigned int steps, NumericVector pen){
+  
+  // Sparse design matrices are dgCMatrix objects, these are kept in CSC form
+  if(Rf_isS4(x)){
+    const arma::sp_mat X = as<arma::sp_mat>(x);
+    return(BackwardHelper(&X, y, offset, indices, num, interactions, method, m, Link,
+                          Dist, nthreads, tol, maxit, keep, steps, pen));
+  }
+  // Dense design matrices are either numeric matrices or mapped design files
+  const DenseDesign X(x);
+  return(BackwardHelper(X.get(), y, offset, indices, num, interactions, method, m, Link,
+                        Dist, nthreads, tol, maxit, keep, steps, pen));
+}
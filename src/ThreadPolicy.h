@@ -0,0 +1,107 @@
+#ifndef ThreadPolicy_H
+#define ThreadPolicy_H
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+using namespace Rcpp;
+
+// Ways that the work for a call can be split among threads
+// serial: all of the work is done by the calling thread
+// data: a single model is fit and the loops over observations are split
+// model: candidate models are fit at the same time, each one by a single thread
+enum class ThreadMode {serial, data, model};
+
+// Smallest number of observations and entries of X for which splitting the
+// loops over observations is worth starting a parallel region
+const unsigned int MinParRows = 4096;
+const double MinParWork = 262144;
+
+struct ThreadPlan{
+  ThreadMode Mode;
+  unsigned int nthreads;
+};
+
+// Checks if this is called from inside of an active parallel region, new
+// regions are not started here so nested parallelism is left to the caller
+inline bool InParallel(){
+#ifdef _OPENMP
+  return(omp_get_active_level() > 0);
+#else
+  return(false);
+#endif
+}
+
+// Chooses how to split the work for a call
+// n and p are the dimensions of X, nmodels is the number of models that can
+// be fit at the same time, this is 1 when a single model is fit
+inline ThreadPlan ChooseThreads(unsigned int n, unsigned int p,
+                                unsigned long long nmodels, unsigned int nthreads){
+  ThreadPlan Plan = {ThreadMode::serial, 1};
+#ifndef _OPENMP
+  nthreads = 1;
+#endif
+  if(nthreads <= 1 || InParallel()){
+    return(Plan);
+  }
+  if(nmodels > 1){
+    Plan.Mode = ThreadMode::model;
+    Plan.nthreads = (unsigned int)std::min((unsigned long long)nthreads, nmodels);
+  }
+  else if(n >= MinParRows && (double)n * p >= MinParWork){
+    Plan.Mode = ThreadMode::data;
+    Plan.nthreads = nthreads;
+  }
+  return(Plan);
+}
+
+// Checks whether a loop over n observations should be split among threads
+inline bool DataParallel(unsigned int n){
+#ifdef _OPENMP
+  return(n >= MinParRows && omp_get_max_threads() > 1 && !InParallel());
+#else
+  return(false);
+#endif
+}
+
+// Largest number of sibling models that are fit together by one thread
+const unsigned int MaxBatch = 16;
+
+// Gets the number of batches to split nmodels sibling models into, there is at 
+// least one batch for each thread in the current team when there are enough models
+inline unsigned int NumBatches(unsigned int nmodels){
+#ifdef _OPENMP
+  unsigned int team = omp_in_parallel() ? omp_get_num_threads() : omp_get_max_threads();
+#else
+  unsigned int team = 1;
+#endif
+  unsigned int nbatches = std::max(team, (nmodels + MaxBatch - 1) / MaxBatch);
+  return(std::min(nbatches, nmodels));
+}
+
+// Sets the number of threads used by parallel regions for the lifetime of this
+// object, the previous number is restored when it is destroyed so the setting
+// used by other OpenMP code in the R process is kept, even when an error is thrown
+class ThreadScope{
+private:
+  int OldThreads = 1;
+public:
+  const ThreadPlan Plan;
+  ThreadScope(ThreadPlan Plan1):Plan(Plan1){
+#ifdef _OPENMP
+    OldThreads = omp_get_max_threads();
+    omp_set_num_threads(Plan.nthreads);
+#endif
+  }
+  ~ThreadScope(){
+#ifdef _OPENMP
+    omp_set_num_threads(OldThreads);
+#endif
+  }
+  ThreadScope(const ThreadScope&) = delete;
+  ThreadScope& operator=(const ThreadScope&) = delete;
+};
+
+#endif
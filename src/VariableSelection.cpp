@@ -2,57 +2,34 @@
 #include <cmath>
 #include "BranchGLMHelpers.h"
 #include "ParBranchGLMHelpers.h"
+#include "GLMWorkspace.h"
+#include "LinRegChol.h"
+#include "VariableSelection.h"
+#include <vector>
 using namespace Rcpp;
 
 // Function used to get number of models given a certain maxsize and the number 
-// of variables
-unsigned long long GetNum(unsigned long long size, unsigned long long max){
+// of variables, this is a double so it doesn't overflow for large model spaces
+// Powers of 2 are exact, so this is exact whenever max >= size, otherwise the 
+// binomial coefficients are summed with compensation but they are rounded once 
+// they are above 2^53, so the total is only approximate for these
+double GetNum(unsigned long long size, unsigned long long max){
   double temp = 0;
   if(max >= size){
-    temp = pow(2, size);
+    temp = ldexp(1.0, size);
   }else{
     double helper = 1;
+    double err = 0;
     temp = 1;
     for(unsigned int i = 1; i <= max; i++){
       helper *= (double)(size - i + 1) /(i);
-      temp += round(helper);
+      CompensatedAdd(&temp, &err, round(helper));
     }
+    temp += err;
   }
   return(temp);
 }
 
-// Class to display progress for branch and bound method
-class Progress{
-private:
-  unsigned long long max_size,cur_size;
-  double last_print = -0.0000000001; 
-  double diff = 0.0000000001;
-  bool display_progress;
-public:
-  Progress(unsigned long long maxnum, bool display):max_size(maxnum), cur_size(0), 
-  display_progress(display){}
-  void update(unsigned long long num = 1){
-    cur_size += num;
-  };
-  void print(){
-    double next_print = 100 * (float)cur_size / (float)max_size;
-    if(display_progress && next_print - last_print >= diff){
-      Rcout << "Checked " << next_print << "% of all possible models"  << std::endl;
-      while(diff <= (next_print - last_print) && diff <= 1.0){
-        diff *= 10;
-      }
-      last_print = next_print;
-    }
-  }
-    void finalprint(){
-      double next_print = 100 * (float)cur_size / (float)max_size;
-      if(display_progress){
-        Rcout << "Checked " << next_print << "% of all possible models"  << std::endl;
-        Rcout << "Found best models"  << std::endl << std::endl;
-        }
-  }
-};
-
 // Gets matrix for a given model
 arma::mat GetMatrix(const arma::mat* X, arma::ivec* CurModel, 
                     const arma::ivec* Indices){
@@ -96,15 +73,63 @@ double UpdateBound(const arma::mat* X, arma::ivec* indices, int cur, double Lowe
   return(LowerBound + pen->at(cur));
 }
 
-// Function used to fit models and calculate desired metric
-double MetricHelper(const arma::mat* OldX, const arma::mat* XTWX, 
-                    const arma::vec* Y, const arma::vec* Offset,
-                    const arma::ivec* Indices, const arma::ivec* CurModel,
-                    std::string method, 
-                    int m, std::string Link, std::string Dist,
-                    double tol, int maxit, const arma::vec* pen, 
-                    unsigned int cur, arma::mat* betaMat){
-  // Getting submatrix of XTWX
+// Fits a model with the columns of X in NewInd
+// If Init is supplied, which is the coefficients from a neighboring model, then 
+// the fit is started from them and the usual initial values are only used when 
+// that fit fails
+template<typename T>
+int FitHelper(const T* X, const arma::uvec* NewInd, const arma::mat* XTWX, 
+              const arma::vec* Y, const arma::vec* Offset, 
+              std::string method, int m, GLMFamily Family, 
+              double tol, int maxit, arma::vec* beta, const arma::vec* Init, 
+              GLMWorkspace* Workspace){
+  
+  // Getting X'WX for this model in the workspace, the columns of X in NewInd 
+  // are used directly instead of copying them
+  arma::mat NewXTWX(Workspace->XTWX.memptr(), NewInd->n_elem, NewInd->n_elem, false, true);
+  NewXTWX = XTWX->submat(*NewInd, *NewInd);
+  int Iter = -1;
+  
+  // Warm starting from the supplied coefficients, X'X is not a good initial 
+  // hessian for these, so it isn't used
+  if(Init != nullptr && !IsLinReg(Family)){
+    *beta = Init->elem(*NewInd);
+    if(method == "BFGS"){
+      Iter = ParBFGSGLMCpp(beta, X, NewInd, &NewXTWX, Y, Offset, Family, tol, maxit, false, Workspace);
+    }
+    else if(method == "LBFGS"){
+      Iter = ParLBFGSGLMCpp(beta, X, NewInd, &NewXTWX, Y, Offset, Family, tol, maxit, m, false, Workspace);
+    }
+    else{
+      Iter = ParFisherScoringGLMCpp(beta, X, NewInd, &NewXTWX, Y, Offset, Family, tol, maxit, false, Workspace);
+    }
+    if(Iter >= 0){
+      return(Iter);
+    }
+  }
+  
+  // Getting initial values
+  bool UseXTWX = true;
+  beta->zeros(NewInd->n_elem);
+  PargetInit(beta, X, NewInd, &NewXTWX, Y, Offset, Family, &UseXTWX, Workspace);
+  
+  // Fitting model
+  if(IsLinReg(Family)){
+    Iter = ParLinRegCppShort(beta, X, NewInd, &NewXTWX, Y, Offset);
+  }else if(method == "BFGS"){
+    Iter = ParBFGSGLMCpp(beta, X, NewInd, &NewXTWX, Y, Offset, Family, tol, maxit, UseXTWX, Workspace);
+  }
+  else if(method == "LBFGS"){
+    Iter = ParLBFGSGLMCpp(beta, X, NewInd, &NewXTWX, Y, Offset, Family, tol, maxit, m, UseXTWX, Workspace);
+  }
+  else{
+    Iter = ParFisherScoringGLMCpp(beta, X, NewInd, &NewXTWX, Y, Offset, Family, tol, maxit, UseXTWX, Workspace);
+  }
+  return(Iter);
+}
+
+// Gets the columns of X for the variables in CurModel
+arma::uvec GetModelCols(const arma::ivec* Indices, const arma::ivec* CurModel){
   unsigned count = 0;
   for(unsigned int i = 0; i < Indices->n_elem; i++){
     if(CurModel->at(Indices->at(i)) != 0){
@@ -118,61 +143,171 @@ double MetricHelper(const arma::mat* OldX, const arma::mat* XTWX,
       NewInd.at(count++) = i;
     }
   }
+  return(NewInd);
+}
+
+// Calculates desired metric for a fitted model with the columns of X in NewInd
+template<typename T>
+double ModelMetric(const T* OldX, const arma::vec* Y, const arma::vec* Offset,
+                   const arma::uvec* NewInd, const arma::vec* beta, 
+                   const arma::ivec* CurModel, GLMFamily Family, double tol, 
+                   const arma::vec* pen, unsigned int cur, arma::mat* betaMat, 
+                   GLMWorkspace* Workspace){
+  
+  // Calculating mu in the workspace
+  arma::vec mu(Workspace->mu.memptr(), OldX->n_rows, false, true);
+  ParLinPredCpp(OldX, NewInd, beta, Offset, &mu);
+  FamilyDispatch<MuKernel>(Family, &mu, &mu, false);
+  double LogLik = -ParLogLikelihoodCpp(Y, &mu, Family);
+  double dispersion = GetDispersion(Y, &mu, LogLik, Family, tol);
+  if(dispersion <= 0 || std::isnan(LogLik) || std::isinf(dispersion)){
+    return(arma::datum::inf);
+  }
   
-  
-  arma::mat NewXTWX = XTWX->submat(NewInd, NewInd);
-  arma::mat X = OldX->cols(NewInd);
-  bool UseXTWX = true;
-  arma::vec beta(X.n_cols, arma::fill::zeros);
-  
-  // Getting initial values
-  PargetInit(&beta, &X, &NewXTWX, Y, Offset, Dist, Link, &UseXTWX);
-  int Iter;
-  
-  if(Dist == "gaussian" && Link == "identity"){
-    Iter = ParLinRegCppShort(&beta, &X, &NewXTWX, Y, Offset);
-  }else if(method == "BFGS"){
-    Iter = ParBFGSGLMCpp(&beta, &X, &NewXTWX, Y, Offset, Link, Dist, tol, maxit, UseXTWX);
+  if(Family.Dist == GLMDist::gaussian){
+    double temp = OldX->n_rows/2. * log(2*M_PI*dispersion);
+    LogLik = LogLik / dispersion - temp;
   }
-  else if(method == "LBFGS"){
-    Iter = ParLBFGSGLMCpp(&beta, &X, &NewXTWX, Y, Offset, Link, Dist, tol, maxit, m, UseXTWX);
+  else if(Family.Dist == GLMDist::poisson){
+    LogLik -=  LogFact(Y);
   }
-  else{
-    Iter = ParFisherScoringGLMCpp(&beta, &X, &NewXTWX, Y, Offset, Link, Dist, tol, maxit, UseXTWX);
+  else if(Family.Dist == GLMDist::gamma){
+    double shape = 1 / dispersion;
+    LogLik = shape * LogLik + 
+      OldX->n_rows * (shape * log(shape) - lgamma(shape)) + 
+      (shape - 1) * arma::accu(log(*Y));
+  }
+  if(std::isnan(LogLik)){
+    return(arma::datum::inf);
   }
+  // Getting beta
+  betaMat->submat(*NewInd, arma::uvec(1, arma::fill::value(cur))) = *beta;
+  return(-2 * LogLik + arma::accu(pen->elem(find(*CurModel != 0))));
+}
+
+// Function used to fit models and calculate desired metric
+template<typename T>
+double MetricHelper(const T* OldX, const arma::mat* XTWX, 
+                    const arma::vec* Y, const arma::vec* Offset,
+                    const arma::ivec* Indices, const arma::ivec* CurModel,
+                    std::string method, 
+                    int m, GLMFamily Family,
+                    double tol, int maxit, const arma::vec* pen, 
+                    unsigned int cur, arma::mat* betaMat, const arma::vec* Init, 
+                    GLMWorkspace* Workspace){
+  // Getting columns of X for this model
+  arma::uvec NewInd = GetModelCols(Indices, CurModel);
+  
+  // Fitting model
+  arma::vec beta(NewInd.n_elem, arma::fill::zeros);
+  int Iter = FitHelper(OldX, &NewInd, XTWX, Y, Offset, method, m, Family, 
+                       tol, maxit, &beta, Init, Workspace);
   
   if(Iter < 0){
     return(arma::datum::inf);
   }
   
-  arma::vec mu = ParLinkCpp(&X, &beta, Offset, Link, Dist);
-  double LogLik = -ParLogLikelihoodCpp(&X, Y, &mu, Dist);
-  double dispersion = GetDispersion(&X, Y, &mu, LogLik, Dist, tol);
-  if(dispersion <= 0 || std::isnan(LogLik) || std::isinf(dispersion)){
-    return(arma::datum::inf);
+  return(ModelMetric(OldX, Y, Offset, &NewInd, &beta, CurModel, Family, tol, pen, 
+                     cur, betaMat, Workspace));
+}
+
+// Fits batch b of nbatches of the models in Models and calculates the desired 
+// metric for them, the model in Models[i] is stored in column Cur[i] of betaMat 
+// and its metric in Metrics[Cur[i]]
+// The models are fit together with ParBatchFisherScoringGLMCpp when they are 
+// warm started with fisher scoring, any model that fails is refit on its own 
+// with MetricHelper from the usual initial values, since the warm start failed
+template<typename T>
+void BatchMetricHelper(const T* OldX, const arma::mat* XTWX, 
+                       const arma::vec* Y, const arma::vec* Offset,
+                       const arma::ivec* Indices, const std::vector<arma::ivec>* Models, 
+                       const arma::uvec* Cur, unsigned int b, unsigned int nbatches,
+                       std::string method, int m, GLMFamily Family,
+                       double tol, int maxit, const arma::vec* pen, 
+                       arma::mat* betaMat, arma::vec* Metrics, const arma::vec* Init, 
+                       GLMWorkspace* Workspace){
+  
+  // Getting models in this batch
+  unsigned int size = (Models->size() + nbatches - 1) / nbatches;
+  unsigned int start = b * size;
+  unsigned int end = std::min((unsigned int)Models->size(), start + size);
+  if(start >= end){
+    return;
+  }
+  
+  // Getting columns and initial values for each model
+  std::vector<arma::uvec> Cols(end - start);
+  std::vector<arma::vec> betas(end - start);
+  for(unsigned int k = start; k < end; k++){
+    Cols.at(k - start) = GetModelCols(Indices, &Models->at(k));
+    if(Init != nullptr){
+      betas.at(k - start) = Init->elem(Cols.at(k - start));
+    }
   }
   
-  if(Dist == "gaussian"){
-    double temp = X.n_rows/2. * log(2*M_PI*dispersion);
-    LogLik = LogLik / dispersion - temp;
+  // Fitting models together
+  arma::ivec Iters(end - start);
+  Iters.fill(-1);
+  bool Batched = Init != nullptr && end - start > 1 && method == "Fisher" && 
+    !IsLinReg(Family);
+  if(Batched){
+    Iters = ParBatchFisherScoringGLMCpp(OldX, &Cols, Y, Offset, &betas, Family, 
+                                        tol, maxit);
   }
-  else if(Dist == "poisson"){
-    LogLik -=  LogFact(Y);
+  
+  // Getting metrics
+  for(unsigned int k = start; k < end; k++){
+    unsigned int cur = Cur->at(k);
+    if(Iters.at(k - start) >= 0){
+      Metrics->at(cur) = ModelMetric(OldX, Y, Offset, &Cols.at(k - start), 
+                                     &betas.at(k - start), &Models->at(k), Family, 
+                                     tol, pen, cur, betaMat, Workspace);
+    }
+    else{
+      Metrics->at(cur) = MetricHelper(OldX, XTWX, Y, Offset, Indices, &Models->at(k), 
+                                      method, m, Family, tol, maxit, pen, cur, 
+                                      betaMat, Batched ? nullptr : Init, Workspace);
+    }
   }
-  else if(Dist == "gamma"){
-    double shape = 1 / dispersion;
-    LogLik = shape * LogLik + 
-      X.n_rows * (shape * log(shape) - lgamma(shape)) + 
-      (shape - 1) * arma::accu(log(*Y));
+}
+
+// Function used to calculate desired metric for linear regression from the 
+// cholesky factor of X'X for the model, so the model is not refit
+double LinRegMetricHelper(const LinRegChol* Chol, const arma::ivec* CurModel, 
+                          const arma::vec* pen, unsigned int cur, arma::mat* betaMat){
+  
+  // Dispersion parameter is the MSE
+  double dispersion = Chol->RSS() / Chol->n;
+  if(dispersion <= 0 || std::isinf(dispersion)){
+    return(arma::datum::inf);
   }
+  
+  // Log-likelihood after replacing the dispersion parameter with the MSE
+  double LogLik = -(Chol->n / 2.) * (1 + log(2*M_PI*dispersion));
   if(std::isnan(LogLik)){
     return(arma::datum::inf);
   }
+  
   // Getting beta
-  betaMat->submat(NewInd, arma::uvec(1, arma::fill::value(cur))) = beta;
+  arma::vec beta = Chol->GetBeta();
+  for(unsigned int i = 0; i < Chol->k; i++){
+    betaMat->at(Chol->Cols.at(i), cur) = beta.at(i);
+  }
   return(-2 * LogLik + arma::accu(pen->elem(find(*CurModel != 0))));
 }
 
+// Function used to calculate desired metric for linear regression from X'X and 
+// X'y, the cholesky factor for the model is found in O(k^3) so X isn't used
+double LinRegMetricHelper(const LinRegChol* Base, const arma::ivec* Indices, 
+                          const arma::ivec* CurModel, const arma::vec* pen, 
+                          unsigned int cur, arma::mat* betaMat){
+  LinRegChol Chol = *Base;
+  if(!Chol.AddModel(Indices, CurModel)){
+    return(arma::datum::inf);
+  }
+  return(LinRegMetricHelper(&Chol, CurModel, pen, cur, betaMat));
+}
+
 // Function used to check if given model is valid, i.e. if lower order terms are 
 // in the model while an interaction term is present
 bool CheckModel(const arma::ivec* CurModel, const arma::imat* Interactions){
@@ -242,7 +377,7 @@ bool BackwardCheckModels(const arma::ivec* CurModel, arma::uvec* NewOrder,
 
 // When doing the process backwards the upper model is already fit, so we just 
 // need to use that and minimum number of variables to get bound
-double BackwardGetBound(const arma::mat* X, arma::ivec* indices, arma::ivec* CurModel,
+double BackwardGetBound(arma::ivec* indices, arma::ivec* CurModel,
                         arma::uvec* NewOrder, unsigned int cur, double metricVal, 
                         const arma::vec* pen){
   
@@ -264,13 +399,15 @@ double BackwardGetBound(const arma::mat* X, arma::ivec* indices, arma::ivec* Cur
 
 
 // Fits upper model for a set of models and calculates the bound for the desired metric
-double GetBound(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
-                std::string method, int m, std::string Link, std::string Dist,
+template<typename T>
+double GetBound(const T* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+                std::string method, int m, GLMFamily Family,
                 arma::ivec* CurModel, arma::ivec* indices, 
                 double tol, int maxit,
                 const arma::vec* pen, unsigned int cur,
                 arma::uvec* NewOrder, double LowerBound,
-                arma::vec* Metrics, arma::mat* betaMat, bool DoAnyways = false){
+                arma::vec* Metrics, arma::mat* betaMat, const arma::vec* Init, 
+                const LinRegChol* Chol, GLMWorkspace* Workspace, bool DoAnyways){
   
   // Checking if we need to fit model for upper bound and updating bounds if we don't need to
   if(cur == 0 && !DoAnyways){
@@ -283,6 +420,22 @@ double GetBound(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, c
     UpperModel.at(NewOrder->at(i)) = 1;
   }
   
+  // Linear regression models are found from X'X and X'y, the columns of the 
+  // upper model are added to a copy of the factor for this node
+  if(Chol != nullptr){
+    LinRegChol Chol2 = *Chol;
+    double UpperMetric = arma::datum::inf;
+    if(Chol2.ExtendModel(indices, &UpperModel)){
+      UpperMetric = LinRegMetricHelper(&Chol2, &UpperModel, pen, cur, betaMat);
+    }
+    if(std::isinf(UpperMetric)){
+      return(LowerBound);
+    }
+    Metrics->at(cur) = UpperMetric;
+    return(UpperMetric - arma::accu(pen->elem(find(UpperModel != 0))) + 
+           arma::accu(pen->elem(find(*CurModel != 0))));
+  }
+  
   // Getting submatrix of XTWX
   unsigned count = 0;
   for(unsigned int i = 0; i < indices->n_elem; i++){
@@ -301,27 +454,10 @@ double GetBound(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, c
   // Defining Iter
   int Iter;
   
-  // Creating matrices for upper model and fitting it
-  arma::mat NewXTWX = XTWX->submat(NewInd, NewInd);
-  bool UseXTWX = true;
-  arma::mat xTemp = X->cols(NewInd);
-  arma::vec beta(xTemp.n_cols, arma::fill::zeros);
-  
-  // Getting initial values
-  PargetInit(&beta, &xTemp, &NewXTWX, Y, Offset, Dist, Link, &UseXTWX);
-  
-  // Fitting model
-  if(Dist == "gaussian" && Link == "identity"){
-    Iter = ParLinRegCppShort(&beta, &xTemp, &NewXTWX, Y, Offset);
-  }else if(method == "BFGS"){
-    Iter = ParBFGSGLMCpp(&beta, &xTemp, &NewXTWX, Y, Offset, Link, Dist, tol, maxit, UseXTWX);
-  }
-  else if(method == "LBFGS"){
-    Iter = ParLBFGSGLMCpp(&beta, &xTemp, &NewXTWX, Y, Offset, Link, Dist, tol, maxit, m, UseXTWX);
-  }
-  else{
-    Iter = ParFisherScoringGLMCpp(&beta, &xTemp, &NewXTWX, Y, Offset, Link, Dist, tol, maxit, UseXTWX);
-  }
+  // Fitting upper model
+  arma::vec beta(count, arma::fill::zeros);
+  Iter = FitHelper(X, &NewInd, XTWX, Y, Offset, method, m, Family, 
+                   tol, maxit, &beta, Init, Workspace);
   
   // Checking for non-invertible fisher info
   if(Iter < 0){
@@ -329,9 +465,11 @@ double GetBound(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, c
   }
   
   // Calculating metric value
-  arma::vec mu = ParLinkCpp(&xTemp, &beta, Offset, Link, Dist);
-  double LogLik = -ParLogLikelihoodCpp(&xTemp, Y, &mu, Dist);
-  double dispersion = GetDispersion(&xTemp, Y, &mu, LogLik, Dist, tol);
+  arma::vec mu(Workspace->mu.memptr(), X->n_rows, false, true);
+  ParLinPredCpp(X, &NewInd, &beta, Offset, &mu);
+  FamilyDispatch<MuKernel>(Family, &mu, &mu, false);
+  double LogLik = -ParLogLikelihoodCpp(Y, &mu, Family);
+  double dispersion = GetDispersion(Y, &mu, LogLik, Family, tol);
   
   // Checking for non-positive dispersion
   if(dispersion <= 0 || std::isinf(dispersion)){
@@ -339,17 +477,17 @@ double GetBound(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, c
   }
   
   // Final computation of log-likelihood
-  if(Dist == "gaussian"){
-    double temp = xTemp.n_rows/2. * log(2*M_PI*dispersion);
+  if(Family.Dist == GLMDist::gaussian){
+    double temp = X->n_rows/2. * log(2*M_PI*dispersion);
     LogLik = LogLik / dispersion - temp;
   }
-  else if(Dist == "poisson"){
+  else if(Family.Dist == GLMDist::poisson){
     LogLik -=  LogFact(Y);
   }
-  else if(Dist == "gamma"){
+  else if(Family.Dist == GLMDist::gamma){
     double shape = 1 / dispersion;
     LogLik = shape * LogLik + 
-      xTemp.n_rows * (shape * log(shape) - lgamma(shape)) + 
+      X->n_rows * (shape * log(shape) - lgamma(shape)) + 
       (shape - 1) * arma::accu(log(*Y));
   }
   
@@ -366,3 +504,86 @@ double GetBound(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, c
   double NewBound = -2 * LogLik + arma::accu(pen->elem(find(*CurModel != 0)));
   return(NewBound);
 }
+
+// Instantiating the metric functions for dense, sparse, and single precision
+// design matrices
+template double MetricHelper<arma::mat>(const arma::mat* OldX, const arma::mat* XTWX, 
+                                     const arma::vec* Y, const arma::vec* Offset,
+                                     const arma::ivec* Indices, const arma::ivec* CurModel,
+                                     std::string method, int m, GLMFamily Family,
+                                     double tol, int maxit, const arma::vec* pen, 
+                                     unsigned int cur, arma::mat* betaMat, 
+                                     const arma::vec* Init, GLMWorkspace* Workspace);
+template void BatchMetricHelper<arma::mat>(const arma::mat* OldX, const arma::mat* XTWX, 
+                                          const arma::vec* Y, const arma::vec* Offset,
+                                          const arma::ivec* Indices, 
+                                          const std::vector<arma::ivec>* Models, 
+                                          const arma::uvec* Cur, unsigned int b, 
+                                          unsigned int nbatches, std::string method, 
+                                          int m, GLMFamily Family, double tol, int maxit, 
+                                          const arma::vec* pen, arma::mat* betaMat, 
+                                          arma::vec* Metrics, const arma::vec* Init, 
+                                          GLMWorkspace* Workspace);
+template double GetBound<arma::mat>(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, 
+                                const arma::vec* Offset, std::string method, int m, 
+                                GLMFamily Family, arma::ivec* CurModel, 
+                                arma::ivec* indices, double tol, int maxit,
+                                const arma::vec* pen, unsigned int cur,
+                                arma::uvec* NewOrder, double LowerBound,
+                                arma::vec* Metrics, arma::mat* betaMat, 
+                                const arma::vec* Init, const LinRegChol* Chol, 
+                                GLMWorkspace* Workspace, bool DoAnyways);
+
+template double MetricHelper<arma::sp_mat>(const arma::sp_mat* OldX, const arma::mat* XTWX, 
+                                     const arma::vec* Y, const arma::vec* Offset,
+                                     const arma::ivec* Indices, const arma::ivec* CurModel,
+                                     std::string method, int m, GLMFamily Family,
+                                     double tol, int maxit, const arma::vec* pen, 
+                                     unsigned int cur, arma::mat* betaMat, 
+                                     const arma::vec* Init, GLMWorkspace* Workspace);
+template void BatchMetricHelper<arma::sp_mat>(const arma::sp_mat* OldX, const arma::mat* XTWX, 
+                                          const arma::vec* Y, const arma::vec* Offset,
+                                          const arma::ivec* Indices, 
+                                          const std::vector<arma::ivec>* Models, 
+                                          const arma::uvec* Cur, unsigned int b, 
+                                          unsigned int nbatches, std::string method, 
+                                          int m, GLMFamily Family, double tol, int maxit, 
+                                          const arma::vec* pen, arma::mat* betaMat, 
+                                          arma::vec* Metrics, const arma::vec* Init, 
+                                          GLMWorkspace* Workspace);
+template double GetBound<arma::sp_mat>(const arma::sp_mat* X, const arma::mat* XTWX, const arma::vec* Y, 
+                                const arma::vec* Offset, std::string method, int m, 
+                                GLMFamily Family, arma::ivec* CurModel, 
+                                arma::ivec* indices, double tol, int maxit,
+                                const arma::vec* pen, unsigned int cur,
+                                arma::uvec* NewOrder, double LowerBound,
+                                arma::vec* Metrics, arma::mat* betaMat, 
+                                const arma::vec* Init, const LinRegChol* Chol, 
+                                GLMWorkspace* Workspace, bool DoAnyways);
+
+template double MetricHelper<arma::fmat>(const arma::fmat* OldX, const arma::mat* XTWX, 
+                                     const arma::vec* Y, const arma::vec* Offset,
+                                     const arma::ivec* Indices, const arma::ivec* CurModel,
+                                     std::string method, int m, GLMFamily Family,
+                                     double tol, int maxit, const arma::vec* pen, 
+                                     unsigned int cur, arma::mat* betaMat, 
+                                     const arma::vec* Init, GLMWorkspace* Workspace);
+template void BatchMetricHelper<arma::fmat>(const arma::fmat* OldX, const arma::mat* XTWX, 
+                                          const arma::vec* Y, const arma::vec* Offset,
+                                          const arma::ivec* Indices, 
+                                          const std::vector<arma::ivec>* Models, 
+                                          const arma::uvec* Cur, unsigned int b, 
+                                          unsigned int nbatches, std::string method, 
+                                          int m, GLMFamily Family, double tol, int maxit, 
+                                          const arma::vec* pen, arma::mat* betaMat, 
+                                          arma::vec* Metrics, const arma::vec* Init, 
+                                          GLMWorkspace* Workspace);
+template double GetBound<arma::fmat>(const arma::fmat* X, const arma::mat* XTWX, const arma::vec* Y, 
+                                const arma::vec* Offset, std::string method, int m, 
+                                GLMFamily Family, arma::ivec* CurModel, 
+                                arma::ivec* indices, double tol, int maxit,
+                                const arma::vec* pen, unsigned int cur,
+                                arma::uvec* NewOrder, double LowerBound,
+                                arma::vec* Metrics, arma::mat* betaMat, 
+                                const arma::vec* Init, const LinRegChol* Chol, 
+                                GLMWorkspace* Workspace, bool DoAnyways);
@@ -2,26 +2,122 @@
 #define VariableSelection_H
 
 #include <RcppArmadillo.h>
+#include <chrono>
+#include <vector>
+#include "GLMFamily.h"
+#include "GLMWorkspace.h"
+#include "LinRegChol.h"
+#ifdef _OPENMP
+# include <omp.h>
+#endif
 using namespace Rcpp;
 
-unsigned long long GetNum(unsigned long long size, unsigned long long max);
+// Adds num to the unevaluated sum sum + err with an error-free transformation, 
+// the rounding error of the addition is carried in err
+inline void CompensatedAdd(double* sum, double* err, double num){
+  double s = *sum + num;
+  double temp = s - *sum;
+  *err += (*sum - (s - temp)) + (num - temp);
+  *sum = s + *err;
+  *err -= *sum - s;
+}
+
+double GetNum(unsigned long long size, unsigned long long max);
+
+// Checks if this is the master thread
+inline bool IsMaster(){
+#ifdef _OPENMP
+  return(omp_get_thread_num() == 0);
+#else
+  return(true);
+#endif
+}
+
+// Used with R_ToplevelExec to check for a user interrupt
+inline void InterruptHelper(void* dummy){
+  R_CheckUserInterrupt();
+}
 
+// Class to display progress for branch and bound method, this is shared by all 
+// threads searching the tree
+// Printing and checking for user interrupts are only done by the master thread
+// since R can't be called from other threads
+// The number of models checked is kept as the unevaluated sum cur_size + cur_err, 
+// so adding small counts to a count above 2^53 isn't lost, the counts for 
+// subtrees from GetNum are rounded above 2^53 so progress is approximate there
 class Progress{
 private:
-  unsigned long long max_size,cur_size;
+  double max_size;
+  double cur_size = 0;
+  double cur_err = 0;
   double last_print = -0.0000000001; 
   double diff = 0.0000000001;
   bool display_progress;
+  bool interrupt = false;
+  const unsigned long long* numchecked;
+  std::chrono::steady_clock::time_point start;
+  
+  // Gets percentage of models checked and the number of models fit per second
+  double percent(){
+    double temp;
+#pragma omp critical(Progress)
+    temp = 100 * (cur_size / max_size + cur_err / max_size);
+    return(temp);
+  }
+  void printfit(){
+    if(numchecked == nullptr){
+      return;
+    }
+    unsigned long long fit;
+#pragma omp atomic read
+    fit = *numchecked;
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - 
+                                                start).count();
+    Rcout << "Fit " << fit << " models";
+    if(secs > 0){
+      Rcout << " (" << fit / secs << " models per second)";
+    }
+    Rcout << std::endl;
+  }
 public:
-  Progress(unsigned long long maxnum, bool display):max_size(maxnum), cur_size(0), 
-  display_progress(display){}
-  void update(unsigned long long num = 1){
-    cur_size += num;
+  Progress(double maxnum, bool display, const unsigned long long* numchecked = nullptr):
+  max_size(maxnum), display_progress(display), numchecked(numchecked), 
+  start(std::chrono::steady_clock::now()){}
+  void update(double num = 1){
+    // Adding num with an error-free transformation, the rounding error is 
+    // carried in cur_err
+#pragma omp critical(Progress)
+    CompensatedAdd(&cur_size, &cur_err, num);
   };
+  // Gets and sets the number of models checked, these are used for checkpoints
+  void getstate(double* size, double* err) const{
+    *size = cur_size;
+    *err = cur_err;
+  }
+  void setstate(double size, double err){
+    cur_size = size;
+    cur_err = err;
+  }
+  // Returns true if the search has been interrupted, the interrupt is recorded 
+  // instead of jumping out of the parallel region
+  bool interrupted(){
+    if(IsMaster() && !R_ToplevelExec(InterruptHelper, nullptr)){
+#pragma omp atomic write
+      interrupt = true;
+    }
+    bool temp;
+#pragma omp atomic read
+    temp = interrupt;
+    return(temp);
+  }
   void print(){
-    double next_print = 100 * (float)cur_size / (float)max_size;
+    if(!IsMaster()){
+      return;
+    }
+    double next_print = percent();
     if(display_progress && next_print - last_print >= diff){
       Rcout << "Checked " << next_print << "% of all possible models"  << std::endl;
+      printfit();
       while(diff <= (next_print - last_print) && diff <= 1.0){
         diff *= 10;
       }
@@ -29,9 +125,10 @@ public:
     }
   }
     void finalprint(){
-      double next_print = 100 * (float)cur_size / (float)max_size;
+      double next_print = percent();
       if(display_progress){
         Rcout << "Checked " << next_print << "% of all possible models"  << std::endl;
+        printfit();
         Rcout << "Found best models"  << std::endl << std::endl;
         }
   }
@@ -43,12 +140,38 @@ arma::mat GetMatrix(const arma::mat* X, arma::ivec* CurModel,
 double UpdateBound(const arma::mat* X, arma::ivec* indices, int cur, double LowerBound, 
                    const arma::vec* pen);
 
-double MetricHelper(const arma::mat* OldX, const arma::mat* XTWX, 
+template<typename T>
+int FitHelper(const T* X, const arma::uvec* NewInd, const arma::mat* XTWX, 
+              const arma::vec* Y, const arma::vec* Offset, 
+              std::string method, int m, GLMFamily Family, 
+              double tol, int maxit, arma::vec* beta, const arma::vec* Init, 
+              GLMWorkspace* Workspace);
+
+template<typename T>
+double MetricHelper(const T* OldX, const arma::mat* XTWX, 
                     const arma::vec* Y, const arma::vec* Offset,
                     const arma::ivec* Indices, const arma::ivec* CurModel,
                     std::string method, 
-                    int m, std::string Link, std::string Dist,
-                    double tol, int maxit, const arma::vec* pen, unsigned int cur, arma::mat* betaMat);
+                    int m, GLMFamily Family,
+                    double tol, int maxit, const arma::vec* pen, unsigned int cur, arma::mat* betaMat, 
+                    const arma::vec* Init, GLMWorkspace* Workspace);
+
+template<typename T>
+void BatchMetricHelper(const T* OldX, const arma::mat* XTWX, 
+                       const arma::vec* Y, const arma::vec* Offset,
+                       const arma::ivec* Indices, const std::vector<arma::ivec>* Models, 
+                       const arma::uvec* Cur, unsigned int b, unsigned int nbatches,
+                       std::string method, int m, GLMFamily Family,
+                       double tol, int maxit, const arma::vec* pen, 
+                       arma::mat* betaMat, arma::vec* Metrics, const arma::vec* Init, 
+                       GLMWorkspace* Workspace);
+
+double LinRegMetricHelper(const LinRegChol* Chol, const arma::ivec* CurModel, 
+                          const arma::vec* pen, unsigned int cur, arma::mat* betaMat);
+
+double LinRegMetricHelper(const LinRegChol* Base, const arma::ivec* Indices, 
+                          const arma::ivec* CurModel, const arma::vec* pen, 
+                          unsigned int cur, arma::mat* betaMat);
 
 bool CheckModel(const arma::ivec* CurModel, const arma::imat* Interactions);
 
@@ -60,16 +183,18 @@ bool BackwardCheckModels(const arma::ivec* CurModel, arma::uvec* NewOrder,
                          const arma::imat* Interactions, 
                          unsigned int cur);
 
-double BackwardGetBound(const arma::mat* X, arma::ivec* indices, arma::ivec* CurModel,
+double BackwardGetBound(arma::ivec* indices, arma::ivec* CurModel,
                         arma::uvec* NewOrder, unsigned int cur, double metricVal, 
                         const arma::vec* pen);
 
-double GetBound(const arma::mat* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
-                std::string method, int m, std::string Link, std::string Dist,
+template<typename T>
+double GetBound(const T* X, const arma::mat* XTWX, const arma::vec* Y, const arma::vec* Offset,
+                std::string method, int m, GLMFamily Family,
                 arma::ivec* CurModel,  arma::ivec* indices, 
                 double tol, int maxit,
                 const arma::vec* pen, unsigned int cur,
                 arma::uvec* NewOrder, double LowerBound,
-                arma::vec* Metrics, arma::mat* betaMat, bool DoAnyways = false);
+                arma::vec* Metrics, arma::mat* betaMat, const arma::vec* Init, 
+                const LinRegChol* Chol, GLMWorkspace* Workspace, bool DoAnyways = false);
 
 #endif
@@ -0,0 +1,174 @@
+#include "VecMath.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+// The loops below are written without branches so they can be vectorized, 
+// on x86-64 linux a copy of each one is compiled for AVX-512 and AVX2 and the 
+// best one supported by the CPU is picked when the package is loaded
+// Floating point exceptions are not used, so gcc is allowed to turn the 
+// comparisons into blends
+#if defined(__GNUC__) && !defined(__clang__)
+# pragma GCC optimize ("no-trapping-math")
+#endif
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+# define VECMATH_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+# define VECMATH_CLONES
+#endif
+
+// Adding this to a double rounds it to an integer, the integer is then stored 
+// in the low bits of the result
+static const double RoundShift = 6755399441055744.0;
+
+static inline std::int64_t AsBits(double x){
+  std::int64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  return(bits);
+}
+
+static inline double AsDouble(std::int64_t bits){
+  double x;
+  std::memcpy(&x, &bits, sizeof(x));
+  return(x);
+}
+
+// Gets 2^k for an integer valued k with -1022 <= k <= 1023
+static inline double Pow2(double k){
+  return(AsDouble((AsBits(k + RoundShift) - AsBits(RoundShift) + 1023) << 52));
+}
+
+// exp(x) = 2^k * exp(r) with |r| <= log(2) / 2, exp(r) is found from its taylor 
+// series and 2^k is split into two factors so subnormal results are handled
+static inline double ExpScalar(double x){
+  x = x > 710 ? 710 : x;
+  x = x < -746 ? -746 : x;
+  double k = (x * 1.4426950408889634 + RoundShift) - RoundShift;
+  double r = x - k * 6.93147180369123816490e-01;
+  r -= k * 1.90821492927058770002e-10;
+  double p = 1.0 / 6227020800.0;
+  p = p * r + 1.0 / 479001600.0;
+  p = p * r + 1.0 / 39916800.0;
+  p = p * r + 1.0 / 3628800.0;
+  p = p * r + 1.0 / 362880.0;
+  p = p * r + 1.0 / 40320.0;
+  p = p * r + 1.0 / 5040.0;
+  p = p * r + 1.0 / 720.0;
+  p = p * r + 1.0 / 120.0;
+  p = p * r + 1.0 / 24.0;
+  p = p * r + 1.0 / 6.0;
+  p = p * r + 0.5;
+  p = p * r + 1.0;
+  p = p * r + 1.0;
+  double k1 = std::floor(k * 0.5);
+  return(p * Pow2(k1) * Pow2(k - k1));
+}
+
+// log(x) = k * log(2) + log(1 + f) where 1 + f is in [sqrt(2) / 2, sqrt(2)), 
+// this follows the reduction and polynomial used by fdlibm
+static inline double LogScalar(double x){
+  
+  // Scaling subnormal numbers
+  bool sub = x < 2.2250738585072014e-308;
+  double x1 = sub ? x * 18014398509481984.0 : x;
+  
+  // Splitting x into exponent and mantissa
+  std::int64_t hx = AsBits(x1) + (0x3ff0000000000000LL - 0x3fe6a09e667f3bcdLL);
+  double k = AsDouble((hx >> 52) + AsBits(RoundShift)) - RoundShift - 1023;
+  k = sub ? k - 54 : k;
+  double f = AsDouble((hx & 0x000fffffffffffffLL) + 0x3fe6a09e667f3bcdLL) - 1;
+  
+  // Calculating log(1 + f)
+  double s = f / (2 + f);
+  double z = s * s;
+  double R = 1.479819860511658591e-01;
+  R = R * z + 1.531383769920937332e-01;
+  R = R * z + 1.818357216161805012e-01;
+  R = R * z + 2.222219843214978396e-01;
+  R = R * z + 2.857142874366239149e-01;
+  R = R * z + 3.999999999940941908e-01;
+  R = R * z + 6.666666666666735130e-01;
+  R *= z;
+  double hfsq = 0.5 * f * f;
+  double val = k * 6.93147180369123816490e-01 - 
+    ((hfsq - (s * (hfsq + R) + k * 1.90821492927058770002e-10)) - f);
+  
+  // Special cases
+  val = x == std::numeric_limits<double>::infinity() ? x : val;
+  val = x == 0 ? -std::numeric_limits<double>::infinity() : val;
+  val = x < 0 ? std::numeric_limits<double>::quiet_NaN() : val;
+  val = x != x ? x : val;
+  return(val);
+}
+
+// Chebyshev coefficients for log(erfc(z) / t) + z^2 in 2 * t - 1 with 
+// t = 2 / (2 + z), this gives erfc(z) for z >= 0 with a single call to exp
+static const double ErfcCoefs[28] = {
+  -6.51326859890854704e-01, 6.41969792356490210e-01,
+  1.94764732041858360e-02, -9.56151478680863226e-03,
+  -9.46595344482036916e-04, 3.66839497852761447e-04,
+  4.25233248069077689e-05, -2.02785781125342418e-05,
+  -1.62429000464702561e-06, 1.30365583558052324e-06,
+  1.56264417220661419e-08, -8.52380959149265415e-08,
+  6.52905443909885149e-09, 5.05934349555146930e-09,
+  -9.91364156493033066e-10, -2.27365122293183597e-10,
+  9.64679110201552702e-11, 2.39403808303911459e-12,
+  -6.88602752649755322e-12, 8.94487927309072531e-13,
+  3.13092139934295813e-13, -1.12708223613672523e-13,
+  3.81090525518923205e-16, 7.10609761360923712e-15,
+  -1.52302820145710434e-15, -9.45749457129123340e-17,
+  1.21023718922427899e-16, -2.81666308774717710e-17
+};
+
+void VECMATH_CLONES VecExp(const double* x, double* y, unsigned int n){
+#pragma omp simd
+  for(unsigned int i = 0; i < n; i++){
+    y[i] = ExpScalar(x[i]);
+  }
+}
+
+void VECMATH_CLONES VecLog(const double* x, double* y, unsigned int n){
+#pragma omp simd
+  for(unsigned int i = 0; i < n; i++){
+    y[i] = LogScalar(x[i]);
+  }
+}
+
+// log1p(x) = x * log(u) / (u - 1) with u = 1 + x, this corrects for the 
+// rounding error made when calculating u
+void VECMATH_CLONES VecLog1p(const double* x, double* y, unsigned int n){
+#pragma omp simd
+  for(unsigned int i = 0; i < n; i++){
+    double x1 = x[i];
+    double u = 1 + x1;
+    double val = LogScalar(u) * (x1 / (u - 1));
+    val = u == 1 ? x1 : val;
+    val = x1 == std::numeric_limits<double>::infinity() ? x1 : val;
+    y[i] = val;
+  }
+}
+
+// Phi(x) = erfc(-x / sqrt(2)) / 2
+void VECMATH_CLONES VecNormCdf(const double* x, double* y, unsigned int n){
+#pragma omp simd
+  for(unsigned int i = 0; i < n; i++){
+    double x1 = x[i];
+    double z = std::fabs(x1) * 0.70710678118654752440;
+    double t = 2 / (2 + z);
+    double u = 2 * t - 1;
+    
+    // Clenshaw recurrence for the chebyshev series
+    double d = 0;
+    double dd = 0;
+#pragma GCC unroll 28
+    for(int j = 27; j > 0; j--){
+      double temp = d;
+      d = 2 * u * d - dd + ErfcCoefs[j];
+      dd = temp;
+    }
+    double P = u * d - dd + ErfcCoefs[0];
+    double tail = 0.5 * t * ExpScalar(P - z * z);
+    y[i] = x1 < 0 ? tail : 1 - tail;
+  }
+}
@@ -0,0 +1,14 @@
+#ifndef VecMath_H
+#define VecMath_H
+
+// Vectorized versions of the transcendental functions used by the link and 
+// log-likelihood kernels, these compute y[i] = f(x[i]) for i < n and x may be y
+void VecExp(const double* x, double* y, unsigned int n);
+
+void VecLog(const double* x, double* y, unsigned int n);
+
+void VecLog1p(const double* x, double* y, unsigned int n);
+
+void VecNormCdf(const double* x, double* y, unsigned int n);
+
+#endif